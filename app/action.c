@@ -23,7 +23,8 @@ void goDown(int *highlightedOption, int nrOfOptions, int terminalHeight, int *sc
 void goLeft(int *depth);
 void goUp(int *highlightedOption, int nrOfOptions, int terminalHeight, int *scrollOffset);
 void resetNextDepth(int *highlightedOptions, int depth, int *scrollOffsets);
-void downloadFile(MDClient *client, MDArray modules, int *highlightedOptions, int depth, Message *msg);
+void downloadFile(MDDownloader *downloader, MDArray modules, int *highlightedOptions, int depth, Message *msg);
+void mirrorCourse(MDDownloader *downloader, MDArray courses, int *highlightedOptions, char *mirrorFolder, Message *msg);
 void getMDFile(MDFile *mdFile, MDArray modules, int *highlightedOptions, int depth, Message *msg);
 void uploadFiles(MDClient *client, int depth, MDArray modules, int *highlightedOptions, char *uploadCommand, Message *msg);
 void checkIfAssignmentOrWorkshop(MDArray modules, int *highlightedOptions, int depth, Message *msg);
@@ -63,6 +64,9 @@ Action getAction(int key) {
         case 115: // s
             action = ACTION_DOWNLOAD;
             break;
+        case 109: // m
+            action = ACTION_MIRROR;
+            break;
         case 113: // q
             action = ACTION_QUIT;
             break;
@@ -125,8 +129,8 @@ int getDepthHeight(int depth, MDArray courses, int *highlightedOptions) {
     return height;
 }
 
-void doAction(Action action, MDArray courses, MDClient *client, int *highlightedOptions,
-        int *depth, int *scrollOffsets, char *uploadCommand, Message *msg) {
+void doAction(Action action, MDArray courses, MDClient *client, MDDownloader *downloader, int *highlightedOptions,
+        int *depth, int *scrollOffsets, char *uploadCommand, char *mirrorFolder, Message *msg) {
     int depthHeight = getDepthHeight(*depth, courses, highlightedOptions);
     MDArray topics = MD_COURSES(courses)[highlightedOptions[COURSES_DEPTH]].topics;
     MDArray modules = MD_TOPICS(topics)[highlightedOptions[TOPICS_DEPTH]].modules;
@@ -151,7 +155,10 @@ void doAction(Action action, MDArray courses, MDClient *client, int *highlighted
             createMsg(msg, NULL, NULL, MSG_TYPE_DISMISSED);
             break;
         case ACTION_DOWNLOAD:
-            downloadFile(client, modules, highlightedOptions, *depth, msg);
+            downloadFile(downloader, modules, highlightedOptions, *depth, msg);
+            break;
+        case ACTION_MIRROR:
+            mirrorCourse(downloader, courses, highlightedOptions, mirrorFolder, msg);
             break;
         case ACTION_UPLOAD:
             uploadFiles(client, *depth, modules, highlightedOptions, uploadCommand, msg);
@@ -161,6 +168,18 @@ void doAction(Action action, MDArray courses, MDClient *client, int *highlighted
     }
 }
 
+void fitHighlightedOptions(MDArray courses, int *highlightedOptions, int *depth, int *scrollOffsets) {
+    for (int i = COURSES_DEPTH; i <= *depth; ++i) {
+        int depthHeight = getDepthHeight(i, courses, highlightedOptions);
+        if (highlightedOptions[i] + scrollOffsets[i] >= depthHeight) {
+            for (int j = i; j < LAST_DEPTH; ++j)
+                highlightedOptions[j] = scrollOffsets[j] = 0;
+            *depth = (depthHeight > 0 || i == COURSES_DEPTH) ? i : i - 1;
+            return;
+        }
+    }
+}
+
 void goRight(int *depth) {
     ++*depth;
 }
@@ -206,25 +225,60 @@ void resetNextDepth(int *highlightedOption, int depth, int *scrollOffsets) {
     }
 }
 
-void downloadFile(MDClient *client, MDArray modules, int *highlightedOptions, int depth, Message *msg) {
+void downloadFile(MDDownloader *downloader, MDArray modules, int *highlightedOptions, int depth, Message *msg) {
     MDFile mdFile;
     getMDFile(&mdFile, modules, highlightedOptions, depth, msg);
     if (checkIfAbort(*msg))
         return;
-    FILE* file = fopen(mdFile.filename, "w");
-    if (!file) {
-        createMsg(msg, MSG_CANNOT_OPEN_DOWNLOAD_FILE, NULL, MSG_TYPE_ERROR);
+
+    // The file is downloaded in the background, see showDownloadProgress.
+    MDError mdError;
+    md_downloader_add(downloader, &mdFile, mdFile.filename, NULL, &mdError);
+    if (mdError) {
+        createMsg(msg, md_error_get_message(mdError), NULL, MSG_TYPE_ERROR);
         return;
     }
+    createMsg(msg, MSG_DOWNLOADING, mdFile.filename, MSG_TYPE_INFO);
+}
 
+void mirrorCourse(MDDownloader *downloader, MDArray courses, int *highlightedOptions, char *mirrorFolder, Message *msg) {
+    MDCourse *course = &MD_COURSES(courses)[highlightedOptions[COURSES_DEPTH]];
+    cchar *folder = mirrorFolder && mirrorFolder[0] ? mirrorFolder : DEFAULT_MIRROR_FOLDER;
     MDError mdError;
-    md_client_download_file(client, &mdFile, file, &mdError);
-    fclose(file);
+    int added = md_downloader_mirror(downloader, course, folder, &mdError);
     if (mdError) {
         createMsg(msg, md_error_get_message(mdError), NULL, MSG_TYPE_ERROR);
         return;
     }
-    createMsg(msg, MSG_DOWNLOADED, mdFile.filename, MSG_TYPE_SUCCESS);
+    if (!added) {
+        createMsg(msg, MSG_MIRRORED, course->name, MSG_TYPE_SUCCESS);
+        return;
+    }
+    char details[MSG_LEN];
+    snprintf(details, MSG_LEN, "%s (%d files)", course->name, added);
+    createMsg(msg, MSG_MIRRORING, details, MSG_TYPE_INFO);
+}
+
+void showDownloadProgress(void *data, const MDDownloadProgress *progress) {
+    Message *msg = data;
+    char details[MSG_LEN];
+    switch (progress->state) {
+        case MD_DOWNLOAD_DONE:
+            createMsg(msg, MSG_DOWNLOADED, progress->filename, MSG_TYPE_SUCCESS);
+            break;
+        case MD_DOWNLOAD_FAILED:
+            snprintf(details, MSG_LEN, "%s: %s", progress->filename, md_error_get_message(progress->error));
+            // Errors quit the main loop, while other downloads may go on.
+            createMsg(msg, MSG_CANNOT_DOWNLOAD, details, MSG_TYPE_WARNING);
+            break;
+        default:
+            if (progress->size > 0)
+                snprintf(details, MSG_LEN, "%s (%lld%%)", progress->filename, progress->received * 100 / progress->size);
+            else
+                snprintf(details, MSG_LEN, "%s (%lld KB)", progress->filename, progress->received / 1024);
+            createMsg(msg, MSG_DOWNLOADING, details, MSG_TYPE_INFO);
+            break;
+    }
 }
 
 void getMDFile(MDFile *mdFile, MDArray modules, int *highlightedOptions, int depth, Message *msg) {
@@ -32,14 +32,21 @@ typedef enum Action {
     ACTION_DISMISS_MSG,
     ACTION_UPLOAD,
     ACTION_DOWNLOAD,
+    ACTION_MIRROR,
     ACTION_QUIT,
 } Action;
 
 Action getAction(int key);
 // TODO: move validation for upload and download from their functions to this
 void validateAction(Action *action, MDArray courses, int *highlightedOptions, int depth, int currentMaxDepth);
-void doAction(Action action, MDArray courses, MDClient *client, int *highlightedOptions,
-        int *depth, int *scrollOffsets, char *uploadCommand, Message *msg);
+void doAction(Action action, MDArray courses, MDClient *client, MDDownloader *downloader, int *highlightedOptions,
+        int *depth, int *scrollOffsets, char *uploadCommand, char *mirrorFolder, Message *msg);
+// showDownloadProgress is the callback of md_downloader_poll, which shows the
+// progress of a download in the message line.
+void showDownloadProgress(void *data, const MDDownloadProgress *progress);
+// fitHighlightedOptions moves the cursor back to valid options after courses
+// have been replaced.
+void fitHighlightedOptions(MDArray courses, int *highlightedOptions, int *depth, int *scrollOffsets);
 
 // ui.c
 
@@ -66,7 +73,8 @@ typedef struct optionCoordinates {
     Depth depth;
 } OptionCoordinates;
 
-void mainLoop(MDArray courses, MDClient *client, char *uploadCommand, Message *msg, Message *prevMsg);
+void mainLoop(MDArray *courses, MDClient *client, MDRefresher *refresher, MDDownloader *downloader, char *uploadCommand,
+        char *mirrorFolder, Message *msg, Message *prevMsg);
 int getMax(int *array, int size);
 
 // option.c
@@ -101,19 +109,75 @@ void *xcalloc(size_t n, size_t size, Message *msg);
 char *getStr(int n);
 int getNrOfDigits(int number);
 void printSpaces(int count);
-void setHtmlRenders(MDArray *courses, Message *msg);
+#define PRERENDER_DISTANCE 10  // in modules from the highlighted one.
+
+// preRenderHtml takes finished background renders and submits descriptions of
+// the modules near the highlighted one (in both directions, across topics of
+// the course), up to PRERENDER_DISTANCE modules away, to be rendered in the
+// background, nearest first. Returns false if there was nothing to do.
+bool preRenderHtml(MDArray courses, int *highlightedOptions, Message *msg);
+// getModuleAt returns the module at given index of the topic, which may go
+// past either end of it into the neighbouring topics, or NULL if there's none.
+MDModule *getModuleAt(MDArray topics, int topicIndex, int moduleIndex);
 MDRichText *getModuleDescription(MDModule *module);
+// getHtmlRender returns the render of the description, rendering it the first
+// time it's needed. Returns NULL on failure.
+HtmlRender *getHtmlRender(MDRichText *description, Message *msg);
+// setHtmlRender renders the description, taking the render from the render
+// cache if it's there.
 void setHtmlRender(MDRichText *description, Message *msg);
+// setCachedHtmlRender sets the render of the description from the render
+// cache, returning false if it's not there.
+bool setCachedHtmlRender(MDRichText *description, Message *msg);
+void freeHtmlRenders(MDArray *courses);
+
+// render_cache.c
+
+// openRenderCache maps the render cache file at path, if there's a valid one.
+// Renders are cached even if there's none, to be saved to path later.
+void openRenderCache(cchar *path);
+// findCachedRender sets render to the cached render of the html and returns
+// true, if there's one. The lines of the render are borrowed from the cache,
+// so it must not be closed while the render is in use.
+bool findCachedRender(cchar *html, HtmlRender *render, Message *msg);
+// saveRenderCache writes renders of all the descriptions of the courses, both
+// rendered and cached ones, if any of them were not cached yet. The file is
+// only replaced by closeRenderCache.
+void saveRenderCache(MDArray courses);
+void closeRenderCache();
+
+// render_pool.c
+
+// startRenderPool starts a thread per processor to render descriptions in the
+// background. If none start, descriptions are rendered on the main thread.
+void startRenderPool();
+// renderInBackground submits the description to be rendered in the
+// background, unless it's cached, and returns true. Returns false if it's
+// already submitted.
+bool renderInBackground(MDRichText *description, Message *msg);
+// takeRenders attaches finished renders to their descriptions, returning true
+// if there were any.
+bool takeRenders(Message *msg);
+// cancelRenders drops all the submitted renders, which must be done before the
+// courses of the descriptions are freed.
+void cancelRenders();
+void stopRenderPool();
 
 // config.c
 
+#define DEFAULT_MIRROR_FOLDER "."
+
 typedef struct ConfigValues {
     char *site;
     char *token;
     char *uploadCommand;
+    char *mirrorFolder;  // empty or NULL if not configured.
 } ConfigValues;
 
 void readConfigFile(ConfigValues *configValues, Message *msg);
+// getCachePath returns allocated path to a file in the cache folder, creating
+// the folder if needed, or NULL if the location of the folder is unknown.
+char *getCachePath(cchar *filename);
 
 // input.c
 
@@ -123,8 +187,29 @@ char *getInput(char *inputMsg, Message *msg);
 
 // main.c
 
-void initialize(MDClient **client, MDArray *courses, ConfigValues *configValues, Message *msg);
-void terminate(MDClient *client, MDArray courses, Message *msg, Message *prevMsg);
+// initialize creates the client and courses, loading them from the cache if
+// possible, and starts the refresher and the downloader.
+void initialize(MDClient **client, MDArray *courses, MDRefresher **refresher, MDDownloader **downloader,
+        ConfigValues *configValues, Message *msg);
+bool loadCache(MDClient **client, MDArray *courses, ConfigValues *configValues);
+void saveCache(MDClient *client, MDArray courses);
+// takeRefreshedCourses replaces courses with the ones fetched by the refresher
+// and returns true if the refresher has finished since the last call.
+bool takeRefreshedCourses(MDRefresher *refresher, MDArray *courses, Message *msg);
+void terminate(MDClient *client, MDArray courses, MDRefresher *refresher, MDDownloader *downloader, Message *msg,
+        Message *prevMsg);
+
+typedef struct MirrorProgress {
+    int left, failed;  // downloads.
+} MirrorProgress;
+
+// mirrorCourses mirrors all the courses into the folder without the interface,
+// once the first refresh has finished, and waits for the downloads. Returns
+// false if anything failed.
+bool mirrorCourses(MDArray *courses, MDRefresher *refresher, MDDownloader *downloader, cchar *folder, Message *msg);
+// printMirrorProgress is the callback of md_downloader_poll used by
+// mirrorCourses, which prints finished downloads.
+void printMirrorProgress(void *data, const MDDownloadProgress *progress);
 
 #endif // __APP_H
 
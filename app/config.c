@@ -10,6 +10,10 @@
 #include <unistd.h>
 #include <string.h>
 #include <stdbool.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
 
 #include "config.h"
 
@@ -42,6 +46,8 @@ void initConfigValues(ConfigValues *configValues, Message *msg) {
         configValues->token = xcalloc(LINE_LIMIT, sizeof(char), msg);
     if (msg->type != MSG_TYPE_ERROR)
         configValues->site = xcalloc(LINE_LIMIT, sizeof(char), msg);
+    if (msg->type != MSG_TYPE_ERROR)
+        configValues->mirrorFolder = xcalloc(LINE_LIMIT, sizeof(char), msg);
 }
 
 char *getConfigPath(Message *msg) {
@@ -75,8 +81,41 @@ FILE *openConfigFile(char *configPath, Message *msg) {
     return configFile;
 }
 
+char *getCachePath(cchar *filename) {
+    char *sysCacheHome = getenv(ENV_CACHE_HOME), *cacheHome = NULL;
+    if (!sysCacheHome) {
+#ifdef PLATFORM_UNIX
+        char *sysHome = getenv(ENV_HOME);
+        if (!sysHome)
+            return NULL;
+        cacheHome = joinPaths(sysHome, CACHE_HOME_FOLDER);
+        makeFolder(cacheHome);
+        sysCacheHome = cacheHome;
+#else
+        return NULL;
+#endif
+    }
+    char *cacheFolderPath = joinPaths(sysCacheHome, CACHE_FOLDER);
+    makeFolder(cacheFolderPath);
+    char *cachePath = joinPaths(cacheFolderPath, (char *)filename);
+    free(cacheFolderPath);
+    free(cacheHome);
+    return cachePath;
+}
+
+void makeFolder(char *path) {
+    // Errors are ignored, as the folder most likely exists already. Otherwise
+    // opening files in it will fail anyway. Cached files hold the token, so
+    // the folders are only accessible by the user.
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0700);
+#endif
+}
+
 char *joinPaths(char *string1, char *string2) {
-    int resultLength = strlen(string1) + strlen(string2);
+    int resultLength = strlen(string1) + strlen(string2) + 2;
     char *result = malloc(resultLength * sizeof(char));
     sprintf(result, "%s%c%s", string1, PATH_SEPERATOR, string2);
     return result;
@@ -121,6 +160,13 @@ void sreadValue(ConfigValues *configValues, Property property, char *line, int *
             break;
         case PROPERTY_UPLOAD_COMMAND:
             configValues->uploadCommand = sreadUntil(line, '\n', LINE_LIMIT, readPos, 0);
+            break;
+        case PROPERTY_MIRROR_FOLDER:
+            // Paths may contain blanks, so only the leading ones are skipped.
+            while (isblank(line[*readPos]))
+                ++*readPos;
+            configValues->mirrorFolder = sreadUntil(line, '\n', LINE_LIMIT, readPos, 0);
+            break;
         default:
             break;
     }
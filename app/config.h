@@ -12,16 +12,20 @@
 #define PLATFORM_WIN
 #define PATH_SEPERATOR '\\'
 #define ENV_CONFIG_HOME "LOCALAPPDATA"
+#define ENV_CACHE_HOME "LOCALAPPDATA"
 #else
 #define PLATFORM_UNIX
 #define PATH_SEPERATOR '/'
 #define ENV_CONFIG_HOME "XDG_CONFIG_HOME"
 #define ENV_HOME "HOME"
 #define CONFIG_HOME_FOLDER ".config"
+#define ENV_CACHE_HOME "XDG_CACHE_HOME"
+#define CACHE_HOME_FOLDER ".cache"
 #endif
 
 #define CONFIG_FOLDER "moot"
 #define CONFIG_FILE "config"
+#define CACHE_FOLDER "moot"
 #define CFG_SEPERATOR '='
 #define MAX_CONFIG_PATH_LENGTH 4096
 
@@ -31,6 +35,7 @@ static cchar * const properties[] = {
     "site",
     "token",
     "file_selection_command",
+    "mirror_folder",
 };
 
 typedef enum Property {
@@ -38,6 +43,7 @@ typedef enum Property {
     PROPERTY_SITE,
     PROPERTY_FILE_SELECTION_COMMAND,
     PROPERTY_UPLOAD_COMMAND,
+    PROPERTY_MIRROR_FOLDER,
     NR_OF_PROPERTIES,
 } Property;
 
@@ -45,7 +51,7 @@ void initConfigValues(ConfigValues *configValues, Message *msg);
 char *getConfigPath(Message *msg);
 FILE *openConfigFile(char *configPath, Message *msg);
 char *joinPaths(char *string1, char *string2);
-char *joinPaths(char *string1, char *string2);
+void makeFolder(char *path);
 void processLine(char *line, ConfigValues *configValues, Message *msg);
 Property getProperty(char *propertyStr, Message *msg);
 void skipSeperator(int *readPos);
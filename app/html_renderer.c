@@ -52,7 +52,11 @@ ArrayWrapper wrapArray(void *dataPtr, int *lenPtr, int size);
 void arrayAppendMulti(ArrayWrapper *array, int count, const void *elems, Message *message);
 void arrayAppend(ArrayWrapper *array, const void *elem, Message *message);
 void arrayShrink(ArrayWrapper *array, Message *message);
-HtmlRender renderHtml(const char *html, Message *message);
+HtmlRender renderHtml(const char *html, Arena *arena, Message *message);
+// allocateFromArena and deallocateToArena are the gumbo allocator functions
+// for parsing to an arena, which is only released all at once.
+void *allocateFromArena(void *arena, size_t size);
+void deallocateToArena(void *arena, void *ptr);
 
 // addLine adds line to render, also adding empty one above if
 // state::trailingNewline is true.
@@ -146,11 +150,18 @@ void arrayShrink(ArrayWrapper *array, Message *message) {
     }
 }
 
-HtmlRender renderHtml(const char *html, Message *message) {
-    HtmlRender render = {.lineCount = 0, .lines = NULL};
+HtmlRender renderHtml(const char *html, Arena *arena, Message *message) {
+    HtmlRender render = {.lineCount = 0, .lines = NULL, .borrowed = false, .wrapCache = {.width = 0}};
 
     GumboOptions options = kGumboDefaultOptions;
     options.fragment_context = GUMBO_TAG_HTML;
+    // Parse errors are not shown, so there's no point in keeping them.
+    options.max_errors = 0;
+    if (arena) {
+        options.allocator = allocateFromArena;
+        options.deallocator = deallocateToArena;
+        options.userdata = arena;
+    }
 
     GumboOutput *out = gumbo_parse_with_options(&options, html, strlen(html));
     if (out) {
@@ -162,11 +173,22 @@ HtmlRender renderHtml(const char *html, Message *message) {
         renderNodes(getNodeChildren(out->root), false, &state);
     }
 
-    gumbo_destroy_output(&options, out);
+    if (arena)
+        arena_reset(arena);
+    else
+        gumbo_destroy_output(&options, out);
 
     return render;
 }
 
+void *allocateFromArena(void *arena, size_t size) {
+    return arena_alloc(arena, size);
+}
+
+void deallocateToArena(void *arena, void *ptr) {
+    // The memory is released once the whole document is rendered.
+}
+
 void addLine(RenderState *state, char *line) {
     if (*(state->renderWrap.len) && state->trailingNewline) {
         char *empty = xcalloc(1, 1, state->msg);
@@ -469,56 +491,70 @@ bool canBreakWord(const char *s, int length) {
     return length && strstr(BREAK_ON_CHARS, c) != NULL;
 }
 
-WrappedLines wrapHtmlRender(HtmlRender render, int width, Message *message) {
-    // This implementation relies on the html rendering algorithm, which leaves
-    // only spaces as whitespace.
-    WrappedLines result = {.count = 0, .lines = NULL};
-    ArrayWrapper resultWrap = wrapArray(&result.lines, &result.count, sizeof(Line));
-    if (width < 2) {
-        return result;
+WrappedLines wrapHtmlRender(HtmlRender *render, int width, int lineCount, Message *message) {
+    WrapCache *cache = &render->wrapCache;
+    if (cache->width != width) {
+        freeWrappedLines(cache->lines);
+        *cache = (WrapCache){
+            .width = width,
+            .renderLine = 0,
+            .position = NULL,
+            .lines = {.count = 0, .lines = NULL},
+            .capacity = 0,
+        };
     }
 
-    for (int i = 0; i < render.lineCount && isOk(message); ++i) {
-        const char *it = render.lines[i];
-        do {
-            // Skip leading space.
-            if (*it == ' ') {
-                ++it;
-            }
+    // This implementation relies on the html rendering algorithm, which leaves
+    // only spaces as whitespace.
+    ArrayWrapper resultWrap = wrapArray(&cache->lines.lines, &cache->lines.count, sizeof(Line));
+    resultWrap.cap = cache->capacity;
+    while (width >= 2 && cache->lines.count < lineCount && cache->renderLine < render->lineCount && isOk(message)) {
+        const char *it = cache->position ? cache->position : render->lines[cache->renderLine];
+        // Skip leading space.
+        if (*it == ' ') {
+            ++it;
+        }
 
-            const char *begin = it, *lastBreakPos = NULL;
-            int sliceWidth = 0;
-            while (sliceWidth < width && *it) {
-                Rune ch;
-                int chLength = utf8decodeNullTerm(it, &ch);
-                if (canBreakWord(it, chLength) && it - begin > 0) {
-                    lastBreakPos = it;
-                }
-                it += chLength;
-                sliceWidth += wcwidth(ch);
+        const char *begin = it, *lastBreakPos = NULL;
+        int sliceWidth = 0;
+        while (sliceWidth < width && *it) {
+            Rune ch;
+            int chLength = utf8decodeNullTerm(it, &ch);
+            if (canBreakWord(it, chLength) && it - begin > 0) {
+                lastBreakPos = it;
             }
+            it += chLength;
+            sliceWidth += wcwidth(ch);
+        }
 
-            const char *end = it;
-            if (sliceWidth >= width && lastBreakPos && !canBreakWord(it, 0)) {
-                end = lastBreakPos + utf8decodeNullTerm(lastBreakPos, &(Rune){0});
-            }
+        const char *end = it;
+        if (sliceWidth >= width && lastBreakPos && !canBreakWord(it, 0)) {
+            end = lastBreakPos + utf8decodeNullTerm(lastBreakPos, &(Rune){0});
+        }
 
-            arrayAppend(&resultWrap, &(Line){.text = begin, .length = end - begin}, message);
+        arrayAppend(&resultWrap, &(Line){.text = begin, .length = end - begin}, message);
 
-            it = end;
-        } while (*it && isOk(message));
+        // Every line of the render results in at least one wrapped line, even
+        // if it's empty.
+        if (*end) {
+            cache->position = end;
+        } else {
+            cache->position = NULL;
+            ++cache->renderLine;
+        }
     }
+    cache->capacity = resultWrap.cap;
 
-    arrayShrink(&resultWrap, message);
-    return result;
+    return cache->lines;
 }
 
 void freeHtmlRender(HtmlRender render) {
-    for (unsigned int i = 0; i < render.lineCount; ++i) {
+    for (unsigned int i = 0; i < render.lineCount && !render.borrowed; ++i) {
         free(render.lines[i]);
     }
 
     free(render.lines);
+    freeWrappedLines(render.wrapCache.lines);
 }
 
 void freeWrappedLines(WrappedLines lines) {
@@ -12,6 +12,7 @@
 
 #ifndef __HTML_RENDERER_H
 #define __HTML_RENDERER_H
+#include "arena.h"
 #include "message.h"
 #include "util.h"
 
@@ -23,13 +24,6 @@
 // break up text when wrapping.
 #define BREAK_ON_CHARS " " ZERO_WIDTH_SPACE
 
-// HtmlRender is the html rendered to text. It should not be used directly, but
-// wrapped first.
-typedef struct HtmlRender {
-    int lineCount;
-    char **lines;
-} HtmlRender;
-
 // Line is NOT null terminated piece of text, limited to certain width.
 typedef struct Line {
     const char *text;
@@ -42,16 +36,39 @@ typedef struct WrappedLines {
     Line *lines;
 } WrappedLines;
 
+// WrapCache keeps the lines of a render wrapped so far to some width, along
+// with the position to continue wrapping from.
+typedef struct WrapCache {
+    int width;             // 0 if nothing was wrapped yet.
+    int renderLine;        // the next line of the render to wrap.
+    const char *position;  // in the render line, NULL if it's not started.
+    WrappedLines lines;
+    int capacity;  // of lines.
+} WrapCache;
+
+// HtmlRender is the html rendered to text. It should not be used directly, but
+// wrapped first.
+typedef struct HtmlRender {
+    int lineCount;
+    char **lines;
+    bool borrowed;  // lines are owned by the render cache, not the render.
+    WrapCache wrapCache;
+} HtmlRender;
+
 // renderHtml renders html to text. Html is expected to be encoded in UTF-8 and
-// output should be wrapped before using.
-HtmlRender renderHtml(const char *html, Message *message);
+// output should be wrapped before using. The parsed document is allocated from
+// the arena if it's not NULL, which is reset once done, so one arena can be
+// reused for many renders on the same thread. The output is not in the arena.
+HtmlRender renderHtml(const char *html, Arena *arena, Message *message);
 
 // wrapHtmlRender wraps rendered html output, resulting in each line no longer
-// than given width when printed in terminal. The lines are pointing to the
-// original HtmlRender output, therefore lines are not zero terminated and
-// the HtmlRender should not be freed while WrappedLines generated from it are
-// in use.
-WrappedLines wrapHtmlRender(HtmlRender render, int width, Message *message);
+// than given width when printed in terminal. Only the first lineCount lines
+// (or all of them, if there are fewer) are guaranteed to be wrapped. The lines
+// are pointing to the original HtmlRender output, therefore lines are not zero
+// terminated. They are kept in the render and only wrapped further by later
+// calls with the same width, so they must not be freed and are only valid
+// until the render is freed or wrapped to another width.
+WrappedLines wrapHtmlRender(HtmlRender *render, int width, int lineCount, Message *message);
 
 void freeHtmlRender(HtmlRender render);
 void freeWrappedLines(WrappedLines lines);
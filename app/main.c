@@ -8,12 +8,30 @@
 #include <string.h>
 
 #include "rlutil.h"
+#include "thread.h"
 #include "utf8.h"
 #include "wcwidth.h"
 #include "app.h"
 #include "config.h"
 
-int main() {
+#define CACHE_CLIENT_FILE "client"
+#define CACHE_COURSES_FILE "courses"
+#define CACHE_HTTP_FOLDER "http"
+#define CACHE_RENDERS_FILE "renders"
+#define REFRESH_INTERVAL 300  // in seconds
+#define ARG_MIRROR "--mirror"
+#define USAGE "Usage: moot [" ARG_MIRROR " [folder]]\n"
+#define MIRROR_PARALLEL 4  // downloads at once in mirror mode.
+#define MIRROR_POLL_INTERVAL 100  // in milliseconds
+
+int main(int argc, char **argv) {
+    // With --mirror, files of all courses are mirrored into the folder given
+    // or configured without showing the interface.
+    bool mirror = argc > 1 && !strcmp(argv[1], ARG_MIRROR);
+    if (argc > (mirror ? 3 : 1)) {
+        printf(USAGE);
+        return 1;
+    }
     ConfigValues configValues;
     Message msg, prevMsg;
     msgInit(&msg);
@@ -28,45 +46,188 @@ int main() {
         if (msg.type == MSG_TYPE_ERROR)
             return 0;
     }
-    MDArray courses;
+    MDArray courses = MD_ARRAY_INITIALIZER;
     MDClient *client = NULL;
-    initialize(&client, &courses, &configValues, &msg);
+    MDRefresher *refresher = NULL;
+    MDDownloader *downloader = NULL;
+    initialize(&client, &courses, &refresher, &downloader, &configValues, &msg);
     if (msg.type == MSG_TYPE_ERROR) {
         printMsgNoUI(msg);
-        terminate(client, courses, &msg, &prevMsg);
+        terminate(client, courses, refresher, downloader, &msg, &prevMsg);
         return 0;
     }
+    if (mirror) {
+        cchar *folder = argc > 2 ? argv[2] : configValues.mirrorFolder && configValues.mirrorFolder[0]
+                ? configValues.mirrorFolder : DEFAULT_MIRROR_FOLDER;
+        bool ok = mirrorCourses(&courses, refresher, downloader, folder, &msg);
+        if (msg.type == MSG_TYPE_ERROR)
+            printMsgNoUI(msg);
+        terminate(client, courses, refresher, downloader, &msg, &prevMsg);
+        return !ok;
+    }
 
+    startRenderPool();
     hidecursor();
     cls();
-    mainLoop(courses, client, configValues.uploadCommand, &msg, &prevMsg);
+    mainLoop(&courses, client, refresher, downloader, configValues.uploadCommand, configValues.mirrorFolder, &msg,
+            &prevMsg);
     cls();
     showcursor();
 
-    terminate(client, courses, &msg, &prevMsg);
+    terminate(client, courses, refresher, downloader, &msg, &prevMsg);
     return 0;
 }
 
-void initialize(MDClient **client, MDArray *courses, ConfigValues *configValues, Message *msg) {
+void initialize(MDClient **client, MDArray *courses, MDRefresher **refresher, MDDownloader **downloader,
+        ConfigValues *configValues, Message *msg) {
     MDError mdError = MD_ERR_NONE;
     md_init();
-    *client = md_client_new(configValues->token, configValues->site, &mdError);
-    if (!mdError)
-        md_client_init(*client, &mdError);
-    if (!mdError)
-        *courses = md_client_fetch_courses(*client, 0, &mdError);
+    char *httpCachePath = getCachePath(CACHE_HTTP_FOLDER);
+    if (httpCachePath) {
+        makeFolder(httpCachePath);
+        // Requests work the same without the cache, so failures are ignored.
+        md_http_cache_set_folder(httpCachePath, &mdError);
+        mdError = MD_ERR_NONE;
+    }
+    free(httpCachePath);
+    char *rendersPath = getCachePath(CACHE_RENDERS_FILE);
+    openRenderCache(rendersPath);
+    free(rendersPath);
+    if (!loadCache(client, courses, configValues)) {
+        *client = md_client_new(configValues->token, configValues->site, &mdError);
+        if (!mdError)
+            md_client_init(*client, &mdError);
+        if (!mdError)
+            *courses = md_client_fetch_courses(*client, 0, &mdError);
+        if (mdError) {
+            createMsg(msg, md_error_get_message(mdError), NULL, MSG_TYPE_ERROR);
+            return;
+        }
+        saveCache(*client, *courses);
+    }
+
+    char *coursesPath = getCachePath(CACHE_COURSES_FILE);
+    *refresher = md_refresher_new(*client, *courses, REFRESH_INTERVAL, 0, coursesPath, &mdError);
+    free(coursesPath);
     if (mdError) {
         createMsg(msg, md_error_get_message(mdError), NULL, MSG_TYPE_ERROR);
         return;
     }
-    setHtmlRenders(courses, msg);
+    // Courses are synced right away, as cached ones may be outdated and freshly
+    // fetched ones have no module statuses loaded.
+    md_refresher_refresh(*refresher);
+
+    *downloader = md_downloader_new(*client, &mdError);
+    if (mdError)
+        createMsg(msg, md_error_get_message(mdError), NULL, MSG_TYPE_ERROR);
+}
+
+bool loadCache(MDClient **client, MDArray *courses, ConfigValues *configValues) {
+    MDError mdError = MD_ERR_FILE_OPERATION;
+    char *clientPath = getCachePath(CACHE_CLIENT_FILE);
+    char *coursesPath = getCachePath(CACHE_COURSES_FILE);
+    if (clientPath && coursesPath) {
+        *client = md_client_load_from_file(clientPath, &mdError);
+        // Cache of a different user or site must not be used.
+        if (!mdError && (strcmp((*client)->token, configValues->token) || strcmp((*client)->website, configValues->site)))
+            mdError = MD_ERR_INVALID_FILE;
+        if (!mdError)
+            *courses = md_courses_load_from_file(coursesPath, &mdError);
+        if (mdError) {
+            md_client_cleanup(*client);
+            *client = NULL;
+        }
+    }
+    free(clientPath);
+    free(coursesPath);
+    return !mdError;
+}
+
+void saveCache(MDClient *client, MDArray courses) {
+    // Cache is not essential, so failures to save it are ignored.
+    MDError mdError;
+    char *clientPath = getCachePath(CACHE_CLIENT_FILE);
+    char *coursesPath = getCachePath(CACHE_COURSES_FILE);
+    if (clientPath && coursesPath) {
+        md_client_save_to_file(client, clientPath, &mdError);
+        if (!mdError)
+            md_courses_save_to_file(courses, coursesPath, &mdError);
+    }
+    free(clientPath);
+    free(coursesPath);
 }
 
-void terminate(MDClient *client, MDArray courses, Message *msg, Message *prevMsg) {
+bool takeRefreshedCourses(MDRefresher *refresher, MDArray *courses, Message *msg) {
+    MDError mdError;
+    MDArray newCourses;
+    if (!md_refresher_take(refresher, &newCourses, &mdError))
+        return false;
+    if (mdError) {
+        createMsg(msg, MSG_CANNOT_REFRESH, md_error_get_message(mdError), MSG_TYPE_WARNING);
+        return true;
+    }
+    // Old courses are only used by this thread, so they can be freed right
+    // after the swap.
+    cancelRenders();
+    freeHtmlRenders(courses);
+    md_courses_cleanup(*courses);
+    *courses = newCourses;
+    return true;
+}
+
+void terminate(MDClient *client, MDArray courses, MDRefresher *refresher, MDDownloader *downloader, Message *msg,
+        Message *prevMsg) {
+    // The refresher and the downloader use the client, so they must be stopped
+    // first. Unfinished downloads are resumed when they are started again.
+    md_refresher_cleanup(refresher);
+    md_downloader_cleanup(downloader);
     free(msg->msg);
     free(prevMsg->msg);
+    stopRenderPool();
+    saveRenderCache(courses);
+    freeHtmlRenders(&courses);
+    // Cached renders point to the mapped file, so it's closed after them.
+    closeRenderCache();
     md_courses_cleanup(courses);
     md_client_cleanup(client);
     md_cleanup();
 }
 
+bool mirrorCourses(MDArray *courses, MDRefresher *refresher, MDDownloader *downloader, cchar *folder, Message *msg) {
+    // Cached courses may miss new files, so the first refresh is waited for.
+    // If it fails, the cached courses are mirrored anyway.
+    while (!takeRefreshedCourses(refresher, courses, msg))
+        th_sleep(MIRROR_POLL_INTERVAL);
+    if (msg->type == MSG_TYPE_ERROR)
+        return false;
+    if (msg->type == MSG_TYPE_WARNING)
+        printMsgNoUI(*msg);
+
+    md_downloader_set_parallel(downloader, MIRROR_PARALLEL);
+    MirrorProgress progress = {0, 0};
+    MDError mdError = MD_ERR_NONE;
+    for (int i = 0; i < courses->len && !mdError; ++i)
+        progress.left += md_downloader_mirror(downloader, &MD_COURSES(*courses)[i], folder, &mdError);
+    if (mdError)
+        createMsg(msg, md_error_get_message(mdError), NULL, MSG_TYPE_ERROR);
+    // Downloads added before a failure are still finished.
+    while (progress.left > 0) {
+        if (!md_downloader_poll(downloader, printMirrorProgress, &progress))
+            th_sleep(MIRROR_POLL_INTERVAL);
+    }
+    return !mdError && !progress.failed;
+}
+
+void printMirrorProgress(void *data, const MDDownloadProgress *progress) {
+    MirrorProgress *mirror = data;
+    if (progress->state == MD_DOWNLOAD_DONE) {
+        printf(MSG_DOWNLOADED "\n", progress->filename);
+    } else if (progress->state == MD_DOWNLOAD_FAILED) {
+        printf(ERROR_MSG_INIT_STRING MSG_CANNOT_DOWNLOAD ": %s\n", progress->filename,
+                md_error_get_message(progress->error));
+        ++mirror->failed;
+    } else {
+        return;
+    }
+    --mirror->left;
+}
@@ -18,6 +18,12 @@ typedef const char cchar;
 #define MSG_DOWNLOADED "Succesfully downloaded %s"
 #define MSG_UPLOADED "Succesfully uploaded %s files"
 
+#define MSG_MIRRORED "%s is up to date"
+
+// info messages
+#define MSG_DOWNLOADING "Downloading %s"
+#define MSG_MIRRORING "Mirroring %s"
+
 // bad action messages
 #define MSG_NO_FILE_CHOSEN "No file chosen"
 #define MSG_NOT_ASSIGNMENT_OR_WORKSHOP "This is not an assignment or a workshop"
@@ -26,6 +32,8 @@ typedef const char cchar;
 // warning messages
 #define MSG_NO_CFG_VALUE "No value found for: %s"
 #define MSG_WRONG_CFG_PROPERTY "No property named %s"
+#define MSG_CANNOT_REFRESH "Couldn't refresh courses: %s"
+#define MSG_CANNOT_DOWNLOAD "Couldn't download %s"
 
 // error messages
 #define MSG_CANNOT_GET_ENV "Couldn't find required environment variables for your system"
@@ -33,7 +41,6 @@ typedef const char cchar;
 #define MSG_NO_TOKEN "No token found in config file"
 #define MSG_NO_SITE "No site found in config file"
 #define MSG_CANNOT_ALLOCATE "Cannot allocate memory"
-#define MSG_CANNOT_OPEN_DOWNLOAD_FILE "Cannot open file for download: %s"
 #define MSG_CANNOT_EXEC_UPLOAD_CMD "Couldn't execute upload command: %s"
 
 typedef enum MsgType {
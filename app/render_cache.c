@@ -0,0 +1,294 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Cache of rendered descriptions, kept in a file between runs.
+ *
+ * Renders are looked up by the hash of their html, so that unchanged
+ * descriptions are not parsed again. The file is mapped to memory and renders
+ * found in it point to its lines, which are stored null terminated one after
+ * another. Entries are sorted by hash, so they are looked up using binary
+ * search right in the mapped file, without reading it first.
+ *
+ * File layout (in native byte order):
+ *   RenderCacheHeader
+ *   RenderCacheEntry[count]  (sorted by hash)
+ *   lines of each entry
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app.h"
+#include "fmap.h"
+#include "html_renderer.h"
+
+#define RENDER_CACHE_MAGIC "MTRC"
+// RENDER_CACHE_VERSION must be increased after any change to the file format
+// or to the output of renderHtml.
+#define RENDER_CACHE_VERSION 1
+#define RENDER_CACHE_BYTE_ORDER 0x01020304u
+#define RENDER_CACHE_TEMP_SUFFIX ".tmp"
+
+typedef struct RenderCacheHeader {
+    char magic[4];
+    uint32_t version, byteOrder, count;
+} RenderCacheHeader;
+
+typedef struct RenderCacheEntry {
+    uint64_t hash;
+    uint32_t textLength, lineCount;  // textLength tells apart most collisions.
+    uint64_t offset;                 // of the lines in the file.
+} RenderCacheEntry;
+
+typedef struct RenderCache {
+    char *path;
+    FMap map;
+    const RenderCacheEntry *entries;  // in the map, NULL if there's none.
+    uint32_t count;
+    bool changed;  // some descriptions were rendered, which are not cached.
+} RenderCache;
+
+// SavedRender is a render to be written to the cache file, taken either from
+// a description or from the old cache.
+typedef struct SavedRender {
+    uint64_t hash;
+    uint32_t textLength;
+    HtmlRender *render;
+    const RenderCacheEntry *entry;
+    uint64_t size;  // of the lines, including their terminators.
+} SavedRender;
+
+static RenderCache renderCache = {.path = NULL, .entries = NULL, .count = 0, .changed = false};
+
+uint64_t hashText(cchar *text, size_t length);
+const RenderCacheEntry *findCacheEntry(uint64_t hash, uint32_t textLength);
+bool getCacheEntrySize(const RenderCacheEntry *entry, uint64_t *size);
+bool collectSavedRenders(MDArray courses, SavedRender **renders, int *count);
+int compareSavedRenders(const void *a, const void *b);
+bool writeRenderCache(FILE *file, SavedRender *renders, int count);
+
+void openRenderCache(cchar *path) {
+    if (!path || !(renderCache.path = malloc(strlen(path) + 1)))
+        return;
+    strcpy(renderCache.path, path);
+    if (!fmap_open(&renderCache.map, path))
+        return;
+    const RenderCacheHeader *header = (const RenderCacheHeader *)renderCache.map.data;
+    // Files of other versions or broken ones are just replaced when saving.
+    bool valid = renderCache.map.size >= sizeof(RenderCacheHeader) &&
+                 !memcmp(header->magic, RENDER_CACHE_MAGIC, sizeof(header->magic)) &&
+                 header->version == RENDER_CACHE_VERSION && header->byteOrder == RENDER_CACHE_BYTE_ORDER &&
+                 header->count <= (renderCache.map.size - sizeof(RenderCacheHeader)) / sizeof(RenderCacheEntry);
+    if (!valid) {
+        fmap_close(&renderCache.map);
+        renderCache.changed = true;
+        return;
+    }
+    renderCache.entries = (const RenderCacheEntry *)(header + 1);
+    renderCache.count = header->count;
+}
+
+bool findCachedRender(cchar *html, HtmlRender *render, Message *msg) {
+    size_t length = strlen(html);
+    const RenderCacheEntry *entry = findCacheEntry(hashText(html, length), length);
+    uint64_t size;
+    if (entry && getCacheEntrySize(entry, &size)) {
+        *render = (HtmlRender){.lineCount = 0, .lines = NULL, .borrowed = true, .wrapCache = {.width = 0}};
+        render->lines = entry->lineCount ? xmalloc(entry->lineCount * sizeof(char *), msg) : NULL;
+        if (entry->lineCount && !render->lines)
+            return false;
+        const char *line = renderCache.map.data + entry->offset;
+        for (uint32_t i = 0; i < entry->lineCount; ++i) {
+            render->lines[i] = (char *)line;
+            line += strlen(line) + 1;
+        }
+        render->lineCount = entry->lineCount;
+        return true;
+    }
+    renderCache.changed = true;
+    return false;
+}
+
+void saveRenderCache(MDArray courses) {
+    if (!renderCache.changed || !renderCache.path)
+        return;
+    SavedRender *renders = NULL;
+    int count = 0;
+    char *tempPath = malloc(strlen(renderCache.path) + sizeof(RENDER_CACHE_TEMP_SUFFIX));
+    FILE *file = NULL;
+    // The cache is not essential, so failures to save it are ignored.
+    if (tempPath && collectSavedRenders(courses, &renders, &count)) {
+        sprintf(tempPath, "%s%s", renderCache.path, RENDER_CACHE_TEMP_SUFFIX);
+        file = fopen(tempPath, "wb");
+    }
+    if (file) {
+        bool ok = writeRenderCache(file, renders, count);
+        ok = !fclose(file) && ok;
+        // The old file can only be replaced once it's not mapped any more,
+        // which is done by closeRenderCache.
+        if (!ok)
+            remove(tempPath);
+        renderCache.changed = !ok;
+    }
+    free(tempPath);
+    free(renders);
+}
+
+void closeRenderCache() {
+    if (renderCache.entries)
+        fmap_close(&renderCache.map);
+    renderCache.entries = NULL;
+    renderCache.count = 0;
+    if (renderCache.path && !renderCache.changed) {
+        char *tempPath = malloc(strlen(renderCache.path) + sizeof(RENDER_CACHE_TEMP_SUFFIX));
+        if (tempPath) {
+            sprintf(tempPath, "%s%s", renderCache.path, RENDER_CACHE_TEMP_SUFFIX);
+#ifdef _WIN32
+            // Rename does not replace existing files on windows.
+            remove(renderCache.path);
+#endif
+            // Only fails if nothing was saved, leaving the old file.
+            rename(tempPath, renderCache.path);
+            free(tempPath);
+        }
+    }
+    free(renderCache.path);
+    renderCache.path = NULL;
+}
+
+// hashText returns 64 bit hash of the text, mixing 8 bytes at a time.
+uint64_t hashText(cchar *text, size_t length) {
+    uint64_t hash = length * 0x9e3779b97f4a7c15u;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, text + i, sizeof(word));
+        word *= 0xbf58476d1ce4e5b9u;
+        hash = (hash ^ word ^ (word >> 31)) * 0x94d049bb133111ebu;
+    }
+    uint64_t word = 0;
+    memcpy(&word, text + i, length - i);
+    hash = (hash ^ word) * 0xbf58476d1ce4e5b9u;
+    return hash ^ (hash >> 29);
+}
+
+// findCacheEntry returns the entry of given hash and text length, or NULL if
+// there's none.
+const RenderCacheEntry *findCacheEntry(uint64_t hash, uint32_t textLength) {
+    uint32_t low = 0, high = renderCache.count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (renderCache.entries[middle].hash < hash)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    for (; low < renderCache.count && renderCache.entries[low].hash == hash; ++low) {
+        if (renderCache.entries[low].textLength == textLength)
+            return &renderCache.entries[low];
+    }
+    return NULL;
+}
+
+// getCacheEntrySize finds the size of the lines of the entry, returning false
+// if they don't fit in the file (so it's broken).
+bool getCacheEntrySize(const RenderCacheEntry *entry, uint64_t *size) {
+    if (entry->offset > renderCache.map.size)
+        return false;
+    const char *begin = renderCache.map.data + entry->offset, *line = begin;
+    const char *end = renderCache.map.data + renderCache.map.size;
+    for (uint32_t i = 0; i < entry->lineCount; ++i) {
+        const char *terminator = memchr(line, '\0', end - line);
+        if (!terminator)
+            return false;
+        line = terminator + 1;
+    }
+    *size = line - begin;
+    return true;
+}
+
+// collectSavedRenders collects renders of all the descriptions of the courses
+// which are either rendered or cached, sorted by hash and without duplicates.
+// Descriptions no longer in the courses are left out.
+bool collectSavedRenders(MDArray courses, SavedRender **renders, int *count) {
+    int capacity = 0;
+    for (int i = 0; i < courses.len; ++i) {
+        MDArray topics = MD_COURSES(courses)[i].topics;
+        for (int j = 0; j < topics.len; ++j)
+            capacity += MD_TOPICS(topics)[j].modules.len;
+    }
+    *renders = malloc((capacity ? capacity : 1) * sizeof(SavedRender));
+    if (!*renders)
+        return false;
+    *count = 0;
+    for (int i = 0; i < courses.len; ++i) {
+        MDArray topics = MD_COURSES(courses)[i].topics;
+        for (int j = 0; j < topics.len; ++j) {
+            MDArray modules = MD_TOPICS(topics)[j].modules;
+            for (int k = 0; k < modules.len; ++k) {
+                MDRichText *description = getModuleDescription(&MD_MODULES(modules)[k]);
+                cchar *html = description->text ? description->text : "";
+                size_t length = strlen(html);
+                SavedRender saved = {.hash = hashText(html, length), .textLength = length};
+                saved.render = description->html_render;
+                saved.entry = saved.render ? NULL : findCacheEntry(saved.hash, saved.textLength);
+                bool found = saved.render || (saved.entry && getCacheEntrySize(saved.entry, &saved.size));
+                if (saved.render) {
+                    saved.size = 0;
+                    for (int l = 0; l < saved.render->lineCount; ++l)
+                        saved.size += strlen(saved.render->lines[l]) + 1;
+                }
+                if (found)
+                    (*renders)[(*count)++] = saved;
+            }
+        }
+    }
+    qsort(*renders, *count, sizeof(SavedRender), compareSavedRenders);
+    int unique = 0;
+    for (int i = 0; i < *count; ++i) {
+        SavedRender *last = unique ? &(*renders)[unique - 1] : NULL;
+        if (!last || last->hash != (*renders)[i].hash || last->textLength != (*renders)[i].textLength)
+            (*renders)[unique++] = (*renders)[i];
+    }
+    *count = unique;
+    return true;
+}
+
+int compareSavedRenders(const void *a, const void *b) {
+    const SavedRender *renderA = a, *renderB = b;
+    if (renderA->hash != renderB->hash)
+        return renderA->hash < renderB->hash ? -1 : 1;
+    return (renderA->textLength > renderB->textLength) - (renderA->textLength < renderB->textLength);
+}
+
+bool writeRenderCache(FILE *file, SavedRender *renders, int count) {
+    RenderCacheHeader header = {.version = RENDER_CACHE_VERSION, .byteOrder = RENDER_CACHE_BYTE_ORDER, .count = count};
+    memcpy(header.magic, RENDER_CACHE_MAGIC, sizeof(header.magic));
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t offset = sizeof(header) + count * sizeof(RenderCacheEntry);
+    for (int i = 0; i < count && ok; ++i) {
+        SavedRender *saved = &renders[i];
+        RenderCacheEntry entry = {
+            .hash = saved->hash,
+            .textLength = saved->textLength,
+            .lineCount = saved->render ? saved->render->lineCount : saved->entry->lineCount,
+            .offset = offset,
+        };
+        ok = fwrite(&entry, sizeof(entry), 1, file) == 1;
+        offset += saved->size;
+    }
+    for (int i = 0; i < count && ok; ++i) {
+        SavedRender *saved = &renders[i];
+        if (saved->render) {
+            for (int l = 0; l < saved->render->lineCount && ok; ++l) {
+                cchar *line = saved->render->lines[l];
+                ok = fwrite(line, 1, strlen(line) + 1, file) == strlen(line) + 1;
+            }
+        } else {
+            ok = fwrite(renderCache.map.data + saved->entry->offset, 1, saved->size, file) == saved->size;
+        }
+    }
+    return ok;
+}
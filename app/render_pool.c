@@ -0,0 +1,234 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Threads rendering descriptions in the background.
+ *
+ * Descriptions are submitted from the main thread and rendered in the order
+ * they were submitted by any of the threads. Each job has its own copy of the
+ * html and its own message, so the threads share nothing but the queues.
+ * Finished renders are only attached to their descriptions by the main thread
+ * when it takes them, and renders of courses which were replaced in the
+ * meantime are dropped.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "app.h"
+#include "html_renderer.h"
+#include "thread.h"
+
+#define RENDER_THREADS_MAX 16
+// RENDER_IDLE_TIMEOUT is the longest time in milliseconds an idle thread
+// sleeps before checking the queue again.
+#define RENDER_IDLE_TIMEOUT 1000
+
+typedef struct RenderJob {
+    MDRichText *description;  // only used by the main thread.
+    int generation;           // of the pool when submitted.
+    char *html;
+    HtmlRender render;
+    Message msg;
+    char msgBuffer[MSG_LEN];
+    struct RenderJob *next;
+} RenderJob;
+
+typedef struct RenderPool {
+    void *mutex, *cond;  // guard the queues and stop.
+    RenderJob *queued, *lastQueued, *done;
+    bool stop;
+    int threadCount;
+    void *threads[RENDER_THREADS_MAX];
+    // Fields below are only used by the main thread.
+    int generation;  // increased when the submitted jobs are cancelled.
+    MDRichText **pending;  // descriptions submitted and not taken yet.
+    int pendingCount, pendingCapacity;
+} RenderPool;
+
+static RenderPool renderPool = {.mutex = NULL, .cond = NULL, .threadCount = 0, .pending = NULL};
+
+void renderThread(void *arg);
+bool isRenderPending(MDRichText *description);
+void removePendingRender(MDRichText *description);
+void freeRenderJobs(RenderJob *jobs);
+
+void startRenderPool() {
+    int count = th_cpu_count();
+    count = count > RENDER_THREADS_MAX ? RENDER_THREADS_MAX : count;
+    renderPool.mutex = th_mutex_new();
+    renderPool.cond = th_cond_new();
+    if (!renderPool.mutex || !renderPool.cond)
+        return;
+    // Descriptions are rendered on the main thread if no threads start.
+    for (int i = 0; i < count; ++i) {
+        renderPool.threads[renderPool.threadCount] = th_create(renderThread, NULL);
+        if (renderPool.threads[renderPool.threadCount])
+            ++renderPool.threadCount;
+    }
+}
+
+bool renderInBackground(MDRichText *description, Message *msg) {
+    if (isRenderPending(description))
+        return false;
+    // Cached renders are cheap enough to take right away.
+    if (setCachedHtmlRender(description, msg) || msg->type == MSG_TYPE_ERROR)
+        return true;
+    if (!renderPool.threadCount) {
+        setHtmlRender(description, msg);
+        return true;
+    }
+    if (renderPool.pendingCount == renderPool.pendingCapacity) {
+        int capacity = renderPool.pendingCapacity ? renderPool.pendingCapacity * 2 : PRERENDER_DISTANCE * 2 + 1;
+        MDRichText **pending = xrealloc(renderPool.pending, capacity * sizeof(MDRichText *), msg);
+        if (!pending)
+            return true;
+        renderPool.pending = pending;
+        renderPool.pendingCapacity = capacity;
+    }
+    cchar *html = description->text ? description->text : "";
+    RenderJob *job = xmalloc(sizeof(RenderJob), msg);
+    char *htmlCopy = xmalloc(strlen(html) + 1, msg);
+    if (!job || !htmlCopy) {
+        free(job);
+        free(htmlCopy);
+        return true;
+    }
+    *job = (RenderJob){
+        .description = description,
+        .generation = renderPool.generation,
+        .html = strcpy(htmlCopy, html),
+        .render = {.lineCount = 0, .lines = NULL, .borrowed = false, .wrapCache = {.width = 0}},
+        .msg = {.msg = job->msgBuffer, .type = MSG_TYPE_NONE},
+        .next = NULL,
+    };
+    renderPool.pending[renderPool.pendingCount++] = description;
+
+    th_mutex_lock(renderPool.mutex);
+    if (renderPool.lastQueued)
+        renderPool.lastQueued->next = job;
+    else
+        renderPool.queued = job;
+    renderPool.lastQueued = job;
+    th_cond_signal(renderPool.cond);
+    th_mutex_unlock(renderPool.mutex);
+    return true;
+}
+
+bool takeRenders(Message *msg) {
+    if (!renderPool.threadCount)
+        return false;
+    th_mutex_lock(renderPool.mutex);
+    RenderJob *jobs = renderPool.done;
+    renderPool.done = NULL;
+    th_mutex_unlock(renderPool.mutex);
+
+    for (RenderJob *job = jobs; job; job = job->next) {
+        if (job->generation != renderPool.generation)
+            continue;
+        removePendingRender(job->description);
+        if (job->msg.type == MSG_TYPE_ERROR) {
+            createMsg(msg, "%s", job->msg.msg, MSG_TYPE_ERROR);
+        } else if (!job->description->html_render) {
+            // The description may have been rendered on the main thread in
+            // the meantime, if it was shown before the job was done.
+            HtmlRender *render = xmalloc(sizeof(HtmlRender), msg);
+            if (render) {
+                *render = job->render;
+                job->render = (HtmlRender){.lineCount = 0, .lines = NULL, .borrowed = false, .wrapCache = {.width = 0}};
+                job->description->html_render = render;
+            }
+        }
+    }
+    freeRenderJobs(jobs);
+    return jobs != NULL;
+}
+
+void cancelRenders() {
+    if (!renderPool.threadCount)
+        return;
+    th_mutex_lock(renderPool.mutex);
+    RenderJob *jobs = renderPool.queued;
+    renderPool.queued = renderPool.lastQueued = NULL;
+    th_mutex_unlock(renderPool.mutex);
+    freeRenderJobs(jobs);
+    // Jobs which are being rendered right now are dropped once taken.
+    ++renderPool.generation;
+    renderPool.pendingCount = 0;
+}
+
+void stopRenderPool() {
+    if (renderPool.mutex && renderPool.cond) {
+        th_mutex_lock(renderPool.mutex);
+        renderPool.stop = true;
+        th_cond_signal(renderPool.cond);
+        th_mutex_unlock(renderPool.mutex);
+    }
+    for (int i = 0; i < renderPool.threadCount; ++i)
+        th_join(renderPool.threads[i]);
+    renderPool.threadCount = 0;
+    freeRenderJobs(renderPool.queued);
+    freeRenderJobs(renderPool.done);
+    renderPool.queued = renderPool.lastQueued = renderPool.done = NULL;
+    if (renderPool.mutex)
+        th_mutex_free(renderPool.mutex);
+    if (renderPool.cond)
+        th_cond_free(renderPool.cond);
+    renderPool.mutex = renderPool.cond = NULL;
+    free(renderPool.pending);
+    renderPool.pending = NULL;
+    renderPool.pendingCount = renderPool.pendingCapacity = 0;
+}
+
+void renderThread(void *arg) {
+    // Documents are parsed to an arena, which is reused for all the jobs of
+    // the thread.
+    Arena arena;
+    arena_init(&arena);
+    th_mutex_lock(renderPool.mutex);
+    while (!renderPool.stop) {
+        RenderJob *job = renderPool.queued;
+        if (!job) {
+            th_cond_wait(renderPool.cond, renderPool.mutex, RENDER_IDLE_TIMEOUT);
+            continue;
+        }
+        renderPool.queued = job->next;
+        if (!renderPool.queued)
+            renderPool.lastQueued = NULL;
+        th_mutex_unlock(renderPool.mutex);
+
+        job->render = renderHtml(job->html, &arena, &job->msg);
+
+        th_mutex_lock(renderPool.mutex);
+        job->next = renderPool.done;
+        renderPool.done = job;
+    }
+    th_mutex_unlock(renderPool.mutex);
+    arena_cleanup(&arena);
+}
+
+bool isRenderPending(MDRichText *description) {
+    for (int i = 0; i < renderPool.pendingCount; ++i) {
+        if (renderPool.pending[i] == description)
+            return true;
+    }
+    return false;
+}
+
+void removePendingRender(MDRichText *description) {
+    for (int i = 0; i < renderPool.pendingCount; ++i) {
+        if (renderPool.pending[i] == description) {
+            renderPool.pending[i] = renderPool.pending[--renderPool.pendingCount];
+            return;
+        }
+    }
+}
+
+void freeRenderJobs(RenderJob *jobs) {
+    while (jobs) {
+        RenderJob *next = jobs->next;
+        freeHtmlRender(jobs->render);
+        free(jobs->html);
+        free(jobs);
+        jobs = next;
+    }
+}
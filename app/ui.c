@@ -8,6 +8,7 @@
 #include <string.h>
 
 #include "rlutil.h"
+#include "thread.h"
 #include "utf8.h"
 #include "wcwidth.h"
 #include "app.h"
@@ -18,6 +19,10 @@
 #define THIRD_WIDTH_DIVISOR 2
 
 #define NR_OF_WIDTHS 3
+#define INPUT_POLL_INTERVAL 20  // in milliseconds
+// DESCRIPTION_LOOKAHEAD is the number of description lines wrapped past the
+// bottom of the terminal, so that they are ready before they are shown.
+#define DESCRIPTION_LOOKAHEAD 20
 
 typedef struct Layout {
     int heights[LAST_DEPTH], *widths;
@@ -27,19 +32,24 @@ void savePrevMessage(Message *msg, Message *prevMsg);
 void restorePrevMessage(Message *msg, Message *prevMsg);
 int getNrOfRecurringMessages(Message msg, Message *prevMsg, Action action);
 OptionCoordinates printMenu(MDArray courses, int *highlightedOptions, int depth, int *scrollOffsets, Message *msg);
-void getDescriptionLines(WrappedLines *lines, MDArray courses, int *highlightedOptions, int width, Message *msg);
+// getDescriptionLines gets the lines of the highlighted description wrapped
+// to the width, of which at least lineCount are wrapped. The lines belong to
+// the render of the description and must not be freed.
+void getDescriptionLines(WrappedLines *lines, MDArray courses, int *highlightedOptions, int width, int lineCount,
+        Message *msg);
 // fills specified width and height with spaces
 void clean(int width, int height);
 // getWidths get gets three different widths for menu layout, depending on how
 // much space is currently available in the terminal
 int *getWidths();
 
-void mainLoop(MDArray courses, MDClient *client, char *uploadCommand, Message *msg, Message *prevMsg) {
-    Action action;
+void mainLoop(MDArray *courses, MDClient *client, MDRefresher *refresher, MDDownloader *downloader, char *uploadCommand,
+        char *mirrorFolder, Message *msg, Message *prevMsg) {
+    Action action = ACTION_INVALID;
     int depth = 0, highlightedOptions[LAST_DEPTH] = {0};
     int scrollOffsets[LAST_DEPTH] = {0};
     OptionCoordinates menuSize;
-    menuSize = printMenu(courses, highlightedOptions, depth, scrollOffsets, msg);
+    menuSize = printMenu(*courses, highlightedOptions, depth, scrollOffsets, msg);
 
     while (action != ACTION_QUIT) {
         if (kbhit()) {
@@ -47,10 +57,14 @@ void mainLoop(MDArray courses, MDClient *client, char *uploadCommand, Message *m
             msg->type = MSG_TYPE_NONE;
             int key = getkey();
             action = getAction(key);
-            validateAction(&action, courses, highlightedOptions, depth, menuSize.depth);
+            validateAction(&action, *courses, highlightedOptions, depth, menuSize.depth);
             if (action != ACTION_INVALID) {
-                doAction(action, courses, client, highlightedOptions, &depth, scrollOffsets, uploadCommand, msg);
+                doAction(action, *courses, client, downloader, highlightedOptions, &depth, scrollOffsets, uploadCommand,
+                        mirrorFolder, msg);
             }
+            // The highlighted course is refreshed first.
+            if (courses->len)
+                md_refresher_set_priority_course(refresher, MD_COURSES(*courses)[highlightedOptions[COURSES_DEPTH]].id);
 
             cls();
             if (msg->type == MSG_TYPE_NONE)
@@ -61,10 +75,29 @@ void mainLoop(MDArray courses, MDClient *client, char *uploadCommand, Message *m
             locate(0, 0);
             savePrevMessage(msg, prevMsg);
             msg->type = MSG_TYPE_NONE;
-            menuSize = printMenu(courses, highlightedOptions, depth, scrollOffsets, msg);
+            menuSize = printMenu(*courses, highlightedOptions, depth, scrollOffsets, msg);
             if (msg->type == MSG_TYPE_ERROR)
                 return;
             restorePrevMessage(msg, prevMsg);
+        } else if (takeRefreshedCourses(refresher, courses, msg)) {
+            if (msg->type == MSG_TYPE_ERROR)
+                return;
+            fitHighlightedOptions(*courses, highlightedOptions, &depth, scrollOffsets);
+            cls();
+            printMsg(*msg, 0);
+            locate(0, 0);
+            menuSize = printMenu(*courses, highlightedOptions, depth, scrollOffsets, msg);
+            if (msg->type == MSG_TYPE_ERROR)
+                return;
+        } else if (md_downloader_poll(downloader, showDownloadProgress, msg)) {
+            printMsg(*msg, 0);
+        } else if (preRenderHtml(*courses, highlightedOptions, msg)) {
+            // Descriptions near the cursor are rendered one at a time while
+            // idle, so that they are ready when shown without delaying input.
+            if (msg->type == MSG_TYPE_ERROR)
+                return;
+        } else {
+            th_sleep(INPUT_POLL_INTERVAL);
         }
     }
 }
@@ -101,11 +134,14 @@ OptionCoordinates printMenu(MDArray courses, int *highlightedOptions, int depth,
     int terminalHeight = trows() - 1;
     WrappedLines descriptionLines = {
         .count = 0,
-        .lines = malloc(sizeof(Line *)),
+        .lines = NULL,
     };
 
     if (depth == MODULE_DEPTH1 && highlightedOptions[depth] == DESCRIPTION_HEIGHT) {
-        getDescriptionLines(&descriptionLines, courses, highlightedOptions, widths[NR_OF_WIDTHS - 1], msg);
+        // Only the lines which may be shown are wrapped, while the ones
+        // wrapped before are kept in the render.
+        int lineCount = scrollOffsets[MODULE_DEPTH2] + terminalHeight + DESCRIPTION_LOOKAHEAD;
+        getDescriptionLines(&descriptionLines, courses, highlightedOptions, widths[NR_OF_WIDTHS - 1], lineCount, msg);
         if (msg->type == MSG_TYPE_ERROR)
             return menuSize;
     }
@@ -131,22 +167,22 @@ OptionCoordinates printMenu(MDArray courses, int *highlightedOptions, int depth,
     }
     menuSize.height = printPos.height;
 
-    if (descriptionLines.count)
-        freeWrappedLines(descriptionLines);
     free(widths);
 
     return menuSize;
 }
 
-void getDescriptionLines(WrappedLines *lines, MDArray courses, int *highlightedOptions, int width, Message *msg) {
+void getDescriptionLines(WrappedLines *lines, MDArray courses, int *highlightedOptions, int width, int lineCount,
+        Message *msg) {
         MDModule *module = &MD_MODULES(MD_TOPICS(MD_COURSES(courses)
                     [highlightedOptions[COURSES_DEPTH]].topics)
                     [highlightedOptions[TOPICS_DEPTH]].modules)
                     [highlightedOptions[MODULES_DEPTH]];
 
-        MDRichText *description = getModuleDescription(module);
-        HtmlRender *render = description->html_render;
-        *lines = wrapHtmlRender(*render, width, msg);
+        // Descriptions are only rendered once they are needed.
+        HtmlRender *render = getHtmlRender(getModuleDescription(module), msg);
+        if (render)
+            *lines = wrapHtmlRender(render, width, lineCount, msg);
 }
 
 int *getWidths() {
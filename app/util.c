@@ -42,20 +42,38 @@ void printSpaces(int count) {
     printf("%*s", count, "");
 }
 
-void setHtmlRenders(MDArray *courses, Message *msg) {
-    for (int coursesIndex = 0; coursesIndex < courses->len; ++coursesIndex) {
-        MDArray topics = MD_COURSES(*courses)[coursesIndex].topics;
-        for (int topicsIndex = 0; topicsIndex < topics.len; ++topicsIndex) {
-            MDArray modules = MD_TOPICS(topics)[topicsIndex].modules;
-            for (int modulesIndex = 0; modulesIndex < modules.len; ++modulesIndex) {
-                MDModule *module = &MD_MODULES(modules)[modulesIndex];
-                MDRichText *description = getModuleDescription(module);
-                if (description->format == MD_FORMAT_HTML) {
-                    setHtmlRender(description, msg);
-                }
-            }
+bool preRenderHtml(MDArray courses, int *highlightedOptions, Message *msg) {
+    bool busy = takeRenders(msg);
+    if (!courses.len || msg->type == MSG_TYPE_ERROR)
+        return busy;
+    MDArray topics = MD_COURSES(courses)[highlightedOptions[COURSES_DEPTH]].topics;
+    for (int distance = 0; distance <= PRERENDER_DISTANCE; ++distance) {
+        for (int direction = 1; direction >= (distance ? -1 : 1); direction -= 2) {
+            MDModule *module = getModuleAt(topics, highlightedOptions[TOPICS_DEPTH],
+                    highlightedOptions[MODULES_DEPTH] + distance * direction);
+            if (module && !getModuleDescription(module)->html_render)
+                busy = renderInBackground(getModuleDescription(module), msg) || busy;
+            if (msg->type == MSG_TYPE_ERROR)
+                return true;
         }
     }
+    return busy;
+}
+
+MDModule *getModuleAt(MDArray topics, int topicIndex, int moduleIndex) {
+    while (topicIndex >= 0 && topicIndex < topics.len) {
+        MDArray modules = MD_TOPICS(topics)[topicIndex].modules;
+        if (moduleIndex < 0) {
+            if (--topicIndex >= 0)
+                moduleIndex += MD_TOPICS(topics)[topicIndex].modules.len;
+        } else if (moduleIndex >= modules.len) {
+            moduleIndex -= modules.len;
+            ++topicIndex;
+        } else {
+            return &MD_MODULES(modules)[moduleIndex];
+        }
+    }
+    return NULL;
 }
 
 MDRichText *getModuleDescription(MDModule *module) {
@@ -71,11 +89,53 @@ MDRichText *getModuleDescription(MDModule *module) {
     }
 }
 
+HtmlRender *getHtmlRender(MDRichText *description, Message *msg) {
+    if (!description->html_render)
+        setHtmlRender(description, msg);
+    return description->html_render;
+}
+
 void setHtmlRender(MDRichText *description, Message *msg) {
-    HtmlRender *render = malloc(sizeof(HtmlRender));
-    *render = renderHtml(description->text, msg);
-    if (msg->type == MSG_TYPE_ERROR)
+    if (setCachedHtmlRender(description, msg) || msg->type == MSG_TYPE_ERROR)
+        return;
+    HtmlRender *render = xmalloc(sizeof(HtmlRender), msg);
+    if (!render)
+        return;
+    *render = renderHtml(description->text ? description->text : "", NULL, msg);
+    if (msg->type == MSG_TYPE_ERROR) {
+        free(render);
         return;
+    }
     description->html_render = render;
 }
 
+bool setCachedHtmlRender(MDRichText *description, Message *msg) {
+    HtmlRender render;
+    description->html_render = NULL;
+    if (!findCachedRender(description->text ? description->text : "", &render, msg))
+        return false;
+    description->html_render = xmalloc(sizeof(HtmlRender), msg);
+    if (description->html_render)
+        *(HtmlRender *)description->html_render = render;
+    else
+        freeHtmlRender(render);
+    return true;
+}
+
+void freeHtmlRenders(MDArray *courses) {
+    for (int coursesIndex = 0; coursesIndex < courses->len; ++coursesIndex) {
+        MDArray topics = MD_COURSES(*courses)[coursesIndex].topics;
+        for (int topicsIndex = 0; topicsIndex < topics.len; ++topicsIndex) {
+            MDArray modules = MD_TOPICS(topics)[topicsIndex].modules;
+            for (int modulesIndex = 0; modulesIndex < modules.len; ++modulesIndex) {
+                MDRichText *description = getModuleDescription(&MD_MODULES(modules)[modulesIndex]);
+                if (description->html_render) {
+                    freeHtmlRender(*(HtmlRender *)description->html_render);
+                    free(description->html_render);
+                    description->html_render = NULL;
+                }
+            }
+        }
+    }
+}
+
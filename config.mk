@@ -1,6 +1,6 @@
 CC = gcc
 RM = rm -f
-LDLIBS = -lcurl -lm -ldl
+LDLIBS = -lcurl -lm -ldl -lpthread
 CCFLAGS = -Wall -g -Wpedantic -std=c11
 # e. g. -I.../curl/include
 INCLUDES =
@@ -0,0 +1,85 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * See arena.h
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "arena.h"
+
+// ARENA_BLOCK_SIZE is the usual size of a block. Larger allocations get a
+// block of their own.
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGN (sizeof(max_align_t))
+#define ARENA_ALIGN_UP(size) (((size) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN)
+
+struct ArenaBlock {
+    ArenaBlock *next;
+    max_align_t data[];
+};
+
+void arena_init(Arena *arena) {
+    arena->blocks = NULL;
+    arena->next = arena->end = NULL;
+}
+
+// arena_alloc_aligned returns size bytes of memory aligned to align, which
+// must be a divisor of ARENA_ALIGN.
+static void *arena_alloc_aligned(Arena *arena, size_t size, size_t align) {
+    size = size ? size : 1;
+    size_t padding = (align - (uintptr_t)arena->next % align) % align;
+    if ((size_t)(arena->end - arena->next) < padding + size) {
+        size_t blockSize = size > ARENA_BLOCK_SIZE / 4 ? ARENA_ALIGN_UP(size) : ARENA_BLOCK_SIZE;
+        ArenaBlock *block = malloc(sizeof(ArenaBlock) + blockSize);
+        if (!block)
+            return NULL;
+        if (blockSize != ARENA_BLOCK_SIZE && arena->blocks) {
+            // The current block may still have space for smaller allocations.
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+            return block->data;
+        }
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->next = (char *)block->data;
+        arena->end = arena->next + blockSize;
+        padding = 0;
+    }
+    void *memory = arena->next + padding;
+    arena->next += padding + size;
+    return memory;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    return arena_alloc_aligned(arena, size, ARENA_ALIGN);
+}
+
+void *arena_alloc_bytes(Arena *arena, size_t size) {
+    return arena_alloc_aligned(arena, size, 1);
+}
+
+void arena_reset(Arena *arena) {
+    ArenaBlock *block = arena->blocks;
+    if (!block)
+        return;
+    // The current block is always the first one, ending where the free space
+    // ends.
+    char *end = arena->end;
+    arena->blocks = block->next;
+    arena_cleanup(arena);
+    block->next = NULL;
+    arena->blocks = block;
+    arena->next = (char *)block->data;
+    arena->end = end;
+}
+
+void arena_cleanup(Arena *arena) {
+    while (arena->blocks) {
+        ArenaBlock *next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+    arena->next = arena->end = NULL;
+}
@@ -0,0 +1,43 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * A simple bump allocator. Memory is taken from large blocks one after another
+ * and can only be released all at once, which makes it a good fit for many
+ * small allocations sharing a lifetime, such as nodes of a parsed document.
+ */
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+// Arena is a bump allocator, its fields are private. A zeroed arena is valid
+// and empty.
+typedef struct Arena {
+    ArenaBlock *blocks;
+    char *next, *end;  // free space of the current block.
+} Arena;
+
+// arena_init initializes an empty arena.
+void arena_init(Arena *arena);
+
+// arena_alloc returns size bytes of memory aligned for any type, which stay
+// valid until the arena is cleaned up, or NULL on failure.
+void *arena_alloc(Arena *arena, size_t size);
+
+// arena_alloc_bytes is the same as arena_alloc, but the memory is not aligned,
+// which saves space for strings and such.
+void *arena_alloc_bytes(Arena *arena, size_t size);
+
+// arena_reset releases all the memory allocated from the arena like
+// arena_cleanup, but keeps the current block to allocate from again, which
+// saves allocating it anew when the arena is reused for similar data.
+void arena_reset(Arena *arena);
+
+// arena_cleanup releases all the memory allocated from the arena, leaving it
+// empty and ready to be used again.
+void arena_cleanup(Arena *arena);
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * See fmap.h
+ */
+
+#if defined(_WIN32)
+#define PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "fmap.h"
+
+int fmap_open(FMap *map, const char *filename) {
+    map->data = NULL;
+    map->size = 0;
+    map->handle = NULL;
+#ifdef PLATFORM_WINDOWS
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            map->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (map->data) {
+                map->size = (size_t)size.QuadPart;
+                map->handle = mapping;
+            } else {
+                CloseHandle(mapping);
+            }
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            map->data = data;
+            map->size = st.st_size;
+        }
+    }
+    close(fd);
+#endif
+    return map->data != NULL;
+}
+
+void fmap_close(FMap *map) {
+    if (!map->data)
+        return;
+#ifdef PLATFORM_WINDOWS
+    UnmapViewOfFile(map->data);
+    CloseHandle(map->handle);
+#else
+    munmap((void *)map->data, map->size);
+#endif
+    map->data = NULL;
+    map->size = 0;
+}
@@ -0,0 +1,28 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * A super simple wrapper library for read-only file memory mapping using POSIX
+ * and Win32 api.
+ */
+
+#ifndef __FMAP_H
+#define __FMAP_H
+
+#include <stddef.h>
+
+// FMap is a read-only view of a whole file.
+typedef struct FMap {
+    const char *data;
+    size_t size;
+    void *handle;  // private
+} FMap;
+
+// fmap_open maps given file to memory, returning non 0 on success. The mapping
+// should be released by the caller using fmap_close. Empty files can not be
+// mapped.
+int fmap_open(FMap *map, const char *filename);
+
+// fmap_close releases a mapping created using fmap_open.
+void fmap_close(FMap *map);
+
+#endif
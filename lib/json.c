@@ -5,6 +5,7 @@
  */
 
 #include <ctype.h>
+#include <locale.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,113 +14,780 @@
 #include "json.h"
 #include "utf8.h"
 
-#define CONST_STRLEN(str) (sizeof(str) - 1)
+// On x86 with GCC compatible compilers, strings and whitespace are scanned 16
+// (SSE2) or 32 (AVX2, if the cpu supports it) bytes at a time. The functions
+// are selected once, on the first scan.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define JSON_SIMD_X86
+#include <immintrin.h>
+#include <stdatomic.h>
+#endif
+
 #define TRUE_VALUE "true"
 #define FALSE_VALUE "false"
 #define NULL_VALUE "null"
+// JSON_MAX_EXACT_DIGITS is the length of the longest integers which always fit
+// to unsigned long long.
+#define JSON_MAX_EXACT_DIGITS 19
+// JSON_MAX_EXACT_MANTISSA and JSON_MAX_EXACT_POWER are the largest integer and
+// power of ten which are exact in a double.
+#define JSON_MAX_EXACT_MANTISSA (1ULL << 53)
+#define JSON_MAX_EXACT_POWER 22
+// JSON_NUMBER_BUFFER_SIZE is the size of the stack buffer for numbers converted
+// by json_strtod. Longer ones are copied to allocated memory.
+#define JSON_NUMBER_BUFFER_SIZE 64
+// Keys of objects parsed into an arena are copied once and shared by all the
+// objects, up to JSON_MAX_KEYS distinct keys of at most JSON_MAX_KEY_LEN bytes.
+#define JSON_MAX_KEYS 4096
+#define JSON_MAX_KEY_LEN 64
+
+static const double powersOfTen[JSON_MAX_EXACT_POWER + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// JsonParserState is the state of JsonParser between two bytes of input.
+// States between values, where whitespace is skipped, come first.
+typedef enum JsonParserState {
+    JSON_STATE_VALUE,         // a value is expected.
+    JSON_STATE_ARRAY_FIRST,   // after '[', a value or ']' is expected.
+    JSON_STATE_ARRAY_NEXT,    // after ',' in an array, a value is expected.
+    JSON_STATE_OBJECT_FIRST,  // after '{', a key or '}' is expected.
+    JSON_STATE_OBJECT_NEXT,   // after ',' in an object, a key is expected.
+    JSON_STATE_COLON,         // after a key, ':' is expected.
+    JSON_STATE_AFTER_VALUE,   // ',' or the end of the container is expected.
+    JSON_STATE_STRING,
+    JSON_STATE_ESCAPE,        // after '\' in a string.
+    JSON_STATE_UNICODE,       // inside the digits of "\u" escape.
+    JSON_STATE_LITERAL,       // inside true, false or null.
+    JSON_STATE_NUMBER_SIGN,   // after '-'.
+    JSON_STATE_NUMBER_ZERO,   // after leading '0'.
+    JSON_STATE_NUMBER_INT,
+    JSON_STATE_NUMBER_DOT,
+    JSON_STATE_NUMBER_FRACTION,
+    JSON_STATE_NUMBER_EXP,    // after 'e' or 'E'.
+    JSON_STATE_NUMBER_EXP_SIGN,
+    JSON_STATE_NUMBER_EXP_DIGITS,
+} JsonParserState;
+
+// JsonParserFrame is an object or array which is being parsed. Its values or
+// entries are collected in the items buffer of the frame, which is kept for
+// later containers at the same depth, and are only moved to memory of their
+// own (see json_parser_alloc) once the container ends. In handler mode nothing
+// is collected and the container is node of the frame itself.
+struct JsonParserFrame {
+    Json *container;
+    void *items;
+    size_t itemsCap;  // in bytes.
+    Json node;
+};
 
-// Triple is a helper enum when more then a boolean is needed.
-typedef enum Triple {
-    Yes,
-    Maybe,
-    No,
-} Triple;
+// JsonObjectIndex is placed after the entries of large objects (see Json). Its
+// slots are only allocated by the first lookup, from the arena the object was
+// parsed to, or using malloc if there's none. Slots hold entry index + 1, or 0
+// if empty, and are probed linearly.
+typedef struct JsonObjectIndex {
+    Arena *arena;
+    JsonLength *slots;  // NULL until the index is built.
+} JsonObjectIndex;
 
-// JsonRet is the type returned by parsing functions which can hold both the
-// error codes (< 0) and parsed byte count.
-typedef long JsonRet;
+// json_object_index_size returns the number of index slots for an object of
+// given length, or 0 if it's not indexed. At most half of the slots are used.
+JsonLength json_object_index_size(JsonLength len);
+JsonObjectIndex *json_object_index(Json *object);
+// json_object_build_index allocates and fills the slots of the index,
+// returning false if they can't be allocated.
+bool json_object_build_index(Json *object);
+// json_hash returns hash of the key of given bytes.
+JsonLength json_hash(const char *data, size_t size);
 
-// ignore_whitespace skips all the whitespace (according to is_whitespace) and
-// returns pointer to the first non-whitespace byte.
-const char *ignore_whitespace(const char *data);
 bool is_whitespace(char token);
+// json_scan_string returns the number of bytes before the first quote or
+// backslash in data.
+size_t json_scan_string(const char *data, size_t size);
+// json_scan_whitespace returns the number of whitespace bytes at the start of
+// data.
+size_t json_scan_whitespace(const char *data, size_t size);
 bool is_digit(char c);
 bool is_positive_digit(char c);
-
-// Functions to parse specific json types. Returns parsed byte count or error
-// code (< 0). First byte should be the start if value, no whitespace is skiped
-// at the beginning.
-
-JsonRet json_parse_value(Json *json, const char *data);
-JsonRet json_parse_object(JsonObject *object, const char *data);
-JsonRet json_parse_array(JsonArray *array, const char *data);
-JsonRet json_parse_string(JsonString *string, const char *data);
-JsonRet json_parse_number(JsonNumber *number, const char *data);
-JsonRet json_parse_boolean(JsonBoolean *boolean, const char *data);
-JsonRet json_parse_null(const char *data);
+int hex_digit_value(char c);
 
 // Cleanup functions for specific Json types. Objects themselves are not freed.
 
 void json_value_cleanup(Json *json);
-void json_object_cleanup(JsonObject *object);
-void json_array_cleanup(JsonArray *array);
+void json_object_cleanup(Json *object);
+void json_array_cleanup(Json *array);
 void json_string_cleanup(JsonString *string);
 
-// Dynamic array management functions.
-
-// array_grow reallocates given array to fit current length.
-// @param array array to grow, valid pointer
-// @param len pointer to wanted array length, set to 0 on failure
-// @param cap pointer to current capacity, adjusted when reallocating / set to 0 on fail
-// @param size size in bytes of single array element
-// @return new pointer to array, NULL if failed
-void *array_grow(void *array, JsonLength *len, JsonLength *cap, JsonLength size);
-
-// array_append appends single value at the end of given array.
-// @param array array to append, valid pointer
-// @param len pointer to current array length, adjusted and set to 0 on failure
-// @param cap pointer to current capacity, adjusted when reallocating / set to 0 on fail
-// @param size size in bytes of single array element
-// @param value valid pointer to the element to append
-// @return new pointer to array, NULL if failed
-void *array_append(void *array, JsonLength *len, JsonLength *cap, JsonLength size, const void *value);
+// Functions of the parser state machine. Each of them returns JSON_ERR_OK or
+// an error, after which the parser stops.
+
+// json_parser_step processes a single byte of input.
+JsonParseError json_parser_step(JsonParser *parser, char c);
+JsonParseError json_parser_begin_value(JsonParser *parser, char c);
+JsonParseError json_parser_end_value(JsonParser *parser);
+// json_parser_end_scalar passes the parsed string, number, boolean or null to
+// the handler, if any, and ends it.
+JsonParseError json_parser_end_scalar(JsonParser *parser);
+JsonParseError json_parser_end_string(JsonParser *parser);
+JsonParseError json_parser_end_number(JsonParser *parser);
+JsonParseError json_parser_end_container(JsonParser *parser);
+JsonParseError json_parser_push(JsonParser *parser, Json *container);
+// json_parser_add_item makes room for one more value or entry in the container
+// of the innermost frame and returns it, or NULL on failure.
+void *json_parser_add_item(JsonParser *parser);
+// json_parser_alloc allocates memory for the parsed value from the arena of
+// the parser, or using malloc if there's none.
+void *json_parser_alloc(JsonParser *parser, size_t size);
+// json_parser_abort releases the partially parsed value after an error.
+void json_parser_abort(JsonParser *parser);
+JsonParseError json_parser_buffer_append(JsonParser *parser, const char *data, size_t size);
+// json_parser_begin_string starts parsing a string which begins after the
+// current byte.
+JsonParseError json_parser_begin_string(JsonParser *parser, bool isKey);
+// json_parser_string_append appends decoded bytes to the current string, which
+// is either in the buffer or, when parsing in situ, in the parsed text itself.
+JsonParseError json_parser_string_append(JsonParser *parser, const char *data, size_t size);
+// json_parser_intern_key returns the key in the buffer, copied to the arena
+// only if it has not been already. Its str is NULL on failure.
+JsonString json_parser_intern_key(JsonParser *parser);
+// json_parser_string_run appends bytes of a string up to the next quote or
+// backslash at once, returning the number of consumed bytes.
+size_t json_parser_string_run(JsonParser *parser, const char *data, size_t size);
+// json_strtod converts valid number text of given length, which is followed by
+// '\0', using strtod, but independently of the locale.
+JsonParseError json_strtod(const char *text, size_t len, double *value);
+// json_parser_digit_run appends digits of a number at once, returning the
+// number of consumed bytes.
+size_t json_parser_digit_run(JsonParser *parser, const char *data, size_t size);
 
 bool is_whitespace(char token) {
     return token == ' ' || token == '\n' || token == '\r' || token == '\t';
 }
 
-const char *ignore_whitespace(const char *data) {
-    while (*data && is_whitespace(*data)) {
-        ++data;
+size_t json_scan_string_scalar(const char *data, size_t size) {
+    size_t length = 0;
+    while (length < size && data[length] != '"' && data[length] != '\\')
+        ++length;
+    return length;
+}
+
+size_t json_scan_whitespace_scalar(const char *data, size_t size) {
+    size_t length = 0;
+    while (length < size && is_whitespace(data[length]))
+        ++length;
+    return length;
+}
+
+#ifdef JSON_SIMD_X86
+size_t json_scan_string_sse2(const char *data, size_t size) {
+    const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(data + i));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + json_scan_string_scalar(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) size_t json_scan_string_avx2(const char *data, size_t size) {
+    const __m256i quote = _mm256_set1_epi8('"'), backslash = _mm256_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i *)(data + i));
+        unsigned mask = _mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, quote), _mm256_cmpeq_epi8(bytes, backslash)));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + json_scan_string_sse2(data + i, size - i);
+}
+
+size_t json_scan_whitespace_sse2(const char *data, size_t size) {
+    const __m128i space = _mm_set1_epi8(' '), newLine = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r'), tab = _mm_set1_epi8('\t');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, newLine)),
+                                          _mm_or_si128(_mm_cmpeq_epi8(bytes, carriageReturn), _mm_cmpeq_epi8(bytes, tab)));
+        int mask = ~_mm_movemask_epi8(whitespace) & 0xFFFF;
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + json_scan_whitespace_scalar(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) size_t json_scan_whitespace_avx2(const char *data, size_t size) {
+    const __m256i space = _mm256_set1_epi8(' '), newLine = _mm256_set1_epi8('\n');
+    const __m256i carriageReturn = _mm256_set1_epi8('\r'), tab = _mm256_set1_epi8('\t');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i whitespace =
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, space), _mm256_cmpeq_epi8(bytes, newLine)),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, carriageReturn), _mm256_cmpeq_epi8(bytes, tab)));
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(whitespace);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + json_scan_whitespace_sse2(data + i, size - i);
+}
+
+// JsonScanner is the type of the scanning functions.
+typedef size_t (*JsonScanner)(const char *data, size_t size);
+
+// The scanners for the cpu, NULL until selected by json_select_scanners. They
+// may be selected by several threads at once, which store the same values.
+static _Atomic(JsonScanner) jsonStringScanner, jsonWhitespaceScanner;
+
+static void json_select_scanners() {
+    bool avx2 = __builtin_cpu_supports("avx2");
+    atomic_store_explicit(&jsonStringScanner, avx2 ? json_scan_string_avx2 : json_scan_string_sse2,
+                          memory_order_relaxed);
+    atomic_store_explicit(&jsonWhitespaceScanner, avx2 ? json_scan_whitespace_avx2 : json_scan_whitespace_sse2,
+                          memory_order_relaxed);
+}
+#endif
+
+size_t json_scan_string(const char *data, size_t size) {
+#ifdef JSON_SIMD_X86
+    JsonScanner scan = atomic_load_explicit(&jsonStringScanner, memory_order_relaxed);
+    if (!scan) {
+        json_select_scanners();
+        scan = atomic_load_explicit(&jsonStringScanner, memory_order_relaxed);
+    }
+    return scan(data, size);
+#else
+    return json_scan_string_scalar(data, size);
+#endif
+}
+
+size_t json_scan_whitespace(const char *data, size_t size) {
+    // Whitespace between values is mostly short, so the first byte after it
+    // is checked first.
+    if (size < 2 || !is_whitespace(data[1]))
+        return size && is_whitespace(data[0]);
+#ifdef JSON_SIMD_X86
+    JsonScanner scan = atomic_load_explicit(&jsonWhitespaceScanner, memory_order_relaxed);
+    if (!scan) {
+        json_select_scanners();
+        scan = atomic_load_explicit(&jsonWhitespaceScanner, memory_order_relaxed);
+    }
+    return scan(data, size);
+#else
+    return json_scan_whitespace_scalar(data, size);
+#endif
+}
+
+inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline bool is_positive_digit(char c) {
+    return c >= '1' && c <= '9';
+}
+
+int hex_digit_value(char c) {
+    if (is_digit(c))
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+void json_parser_init(JsonParser *parser, Json *json) {
+    json_parser_init_arena(parser, json, NULL);
+}
+
+void json_parser_init_arena(JsonParser *parser, Json *json, Arena *arena) {
+    parser->root = parser->slot = json;
+    parser->arena = arena;
+    parser->text = parser->stringStart = parser->stringEnd = NULL;
+    parser->cursor = NULL;
+    parser->stack = NULL;
+    parser->depth = parser->stackCap = 0;
+    parser->maxDepth = JSON_DEFAULT_MAX_DEPTH;
+    parser->size = 0;
+    parser->maxSize = JSON_NO_SIZE_LIMIT;
+    parser->state = JSON_STATE_VALUE;
+    parser->buffer = NULL;
+    parser->bufferLen = parser->bufferCap = 0;
+    parser->keys = NULL;
+    parser->keysLen = parser->keysCap = 0;
+    parser->literal = NULL;
+    parser->count = 0;
+    parser->rune = 0;
+    parser->isKey = false;
+    parser->handler = NULL;
+    parser->error = JSON_ERR_OK;
+    json->type = JSON_NULL;
+}
+
+void json_parser_init_handler(JsonParser *parser, JsonHandler *handler) {
+    json_parser_init_arena(parser, &parser->value, NULL);
+    // There's no tree to free.
+    parser->root = NULL;
+    parser->handler = handler;
+}
+
+JsonParseError json_parser_buffer_append(JsonParser *parser, const char *data, size_t size) {
+    if (parser->bufferLen + size + 1 > parser->bufferCap) {
+        size_t cap = parser->bufferCap ? parser->bufferCap : 64;
+        while (cap < parser->bufferLen + size + 1)
+            cap *= 2;
+        char *buffer = realloc(parser->buffer, cap);
+        if (!buffer)
+            return JSON_ERR_FAILED_ALLOCATION;
+        parser->buffer = buffer;
+        parser->bufferCap = cap;
+    }
+    memcpy(parser->buffer + parser->bufferLen, data, size);
+    parser->bufferLen += size;
+    return JSON_ERR_OK;
+}
+
+JsonParseError json_parser_begin_string(JsonParser *parser, bool isKey) {
+    parser->isKey = isKey;
+    parser->bufferLen = 0;
+    parser->state = JSON_STATE_STRING;
+    if (parser->text) {
+        // The cursor points to the opening quote in the text.
+        parser->stringStart = parser->stringEnd = parser->text + (parser->cursor - parser->text) + 1;
+    }
+    return JSON_ERR_OK;
+}
+
+JsonParseError json_parser_string_append(JsonParser *parser, const char *data, size_t size) {
+    if (!parser->text)
+        return json_parser_buffer_append(parser, data, size);
+    // Decoded strings are never longer than their source, so they can be
+    // written over it.
+    if (parser->stringEnd != data)
+        memmove(parser->stringEnd, data, size);
+    parser->stringEnd += size;
+    return JSON_ERR_OK;
+}
+
+void json_parser_set_limits(JsonParser *parser, JsonLength maxDepth, size_t maxSize) {
+    parser->maxDepth = maxDepth;
+    parser->maxSize = maxSize;
+}
+
+JsonParseError json_parser_push(JsonParser *parser, Json *container) {
+    if (parser->depth >= parser->maxDepth)
+        return JSON_ERR_DEPTH_LIMIT;
+    if (parser->depth == parser->stackCap) {
+        JsonLength cap = parser->stackCap ? parser->stackCap * 2 : 16;
+        JsonParserFrame *stack = realloc(parser->stack, cap * sizeof(JsonParserFrame));
+        if (!stack)
+            return JSON_ERR_FAILED_ALLOCATION;
+        for (JsonLength i = parser->stackCap; i < cap; ++i)
+            stack[i] = (JsonParserFrame){.container = NULL, .items = NULL, .itemsCap = 0};
+        // Nodes of the frames have moved along with the stack.
+        for (JsonLength i = 0; i < parser->depth && parser->handler; ++i)
+            stack[i].container = &stack[i].node;
+        parser->stack = stack;
+        parser->stackCap = cap;
+    }
+    JsonParserFrame *frame = &parser->stack[parser->depth++];
+    if (parser->handler) {
+        frame->node = *container;
+        container = &frame->node;
+        if (!parser->handler->begin(parser->handler->data, container->type))
+            return JSON_ERR_STOPPED;
+    }
+    frame->container = container;
+    return JSON_ERR_OK;
+}
+
+void *json_parser_add_item(JsonParser *parser) {
+    JsonParserFrame *frame = &parser->stack[parser->depth - 1];
+    Json *container = frame->container;
+    bool isArray = container->type == JSON_ARRAY;
+    size_t size = isArray ? sizeof(Json) : sizeof(JsonObjectEntry);
+    if ((container->len + 1) * size > frame->itemsCap) {
+        size_t cap = frame->itemsCap ? frame->itemsCap * 2 : 16 * size;
+        void *items = realloc(frame->items, cap);
+        if (!items)
+            return NULL;
+        frame->items = items;
+        frame->itemsCap = cap;
+    }
+    if (isArray) {
+        container->values = frame->items;
+        return &container->values[container->len++];
+    }
+    container->entries = frame->items;
+    return &container->entries[container->len++];
+}
+
+void *json_parser_alloc(JsonParser *parser, size_t size) {
+    return parser->arena ? arena_alloc(parser->arena, size) : malloc(size);
+}
+
+JsonParseError json_parser_begin_value(JsonParser *parser, char c) {
+    if (parser->depth && parser->stack[parser->depth - 1].container->type == JSON_ARRAY && !parser->handler) {
+        parser->slot = json_parser_add_item(parser);
+        if (!parser->slot)
+            return JSON_ERR_FAILED_ALLOCATION;
+        // The value is initialized to null in case it does not get parsed.
+        parser->slot->type = JSON_NULL;
+    }
+    Json *json = parser->slot;
+    switch (c) {
+        case '{':
+            *json = (Json){.type = JSON_OBJECT, .entries = NULL, .len = 0};
+            parser->state = JSON_STATE_OBJECT_FIRST;
+            return json_parser_push(parser, json);
+        case '[':
+            *json = (Json){.type = JSON_ARRAY, .values = NULL, .len = 0};
+            parser->state = JSON_STATE_ARRAY_FIRST;
+            return json_parser_push(parser, json);
+        case '"':
+            return json_parser_begin_string(parser, false);
+        case 't':
+            parser->literal = TRUE_VALUE;
+            break;
+        case 'f':
+            parser->literal = FALSE_VALUE;
+            break;
+        case 'n':
+            parser->literal = NULL_VALUE;
+            break;
+        default:
+            if (c != '-' && !is_digit(c))
+                return JSON_ERR_INVALID_VALUE;
+            parser->bufferLen = 0;
+            parser->state = c == '-' ? JSON_STATE_NUMBER_SIGN : c == '0' ? JSON_STATE_NUMBER_ZERO : JSON_STATE_NUMBER_INT;
+            return json_parser_buffer_append(parser, &c, 1);
     }
-    return data;
+    parser->count = 1;
+    parser->state = JSON_STATE_LITERAL;
+    return JSON_ERR_OK;
+}
+
+JsonParseError json_parser_end_value(JsonParser *parser) {
+    parser->state = JSON_STATE_AFTER_VALUE;
+    return JSON_ERR_OK;
+}
+
+JsonParseError json_parser_end_scalar(JsonParser *parser) {
+    if (parser->handler && !parser->handler->value(parser->handler->data, parser->slot))
+        return JSON_ERR_STOPPED;
+    return json_parser_end_value(parser);
 }
 
-JsonRet json_parse_boolean(JsonBoolean *boolean, const char *data) {
-    if (strncmp(data, TRUE_VALUE, CONST_STRLEN(TRUE_VALUE)) == 0) {
-        *boolean = true;
-        return CONST_STRLEN(TRUE_VALUE);
+JsonParseError json_parser_end_string(JsonParser *parser) {
+    JsonString string;
+    if (parser->handler) {
+        // Strings are passed right from the buffer.
+        if (json_parser_buffer_append(parser, "", 1))
+            return JSON_ERR_FAILED_ALLOCATION;
+        string = (JsonString){.str = parser->buffer, .len = --parser->bufferLen};
+        if (parser->isKey) {
+            parser->state = JSON_STATE_COLON;
+            return parser->handler->key(parser->handler->data, string.str, string.len) ? JSON_ERR_OK : JSON_ERR_STOPPED;
+        }
+    } else if (parser->text) {
+        // The end is at most at the closing quote, which is no longer needed.
+        *parser->stringEnd = '\0';
+        string = (JsonString){.str = parser->stringStart, .len = parser->stringEnd - parser->stringStart};
+    } else if (parser->isKey && parser->arena) {
+        string = json_parser_intern_key(parser);
+        if (!string.str)
+            return JSON_ERR_FAILED_ALLOCATION;
+    } else {
+        size_t size = parser->bufferLen + 1;
+        string = (JsonString){.str = parser->arena ? arena_alloc_bytes(parser->arena, size) : malloc(size),
+                              .len = parser->bufferLen};
+        if (!string.str)
+            return JSON_ERR_FAILED_ALLOCATION;
+        memcpy(string.str, parser->buffer, parser->bufferLen);
+        string.str[string.len] = '\0';
     }
-    if (strncmp(data, FALSE_VALUE, CONST_STRLEN(FALSE_VALUE)) == 0) {
-        *boolean = false;
-        return CONST_STRLEN(FALSE_VALUE);
+    if (!parser->isKey) {
+        *parser->slot = (Json){.type = JSON_STRING, .str = string.str, .len = string.len};
+        return json_parser_end_scalar(parser);
     }
-    return JSON_ERR_INVALID_VALUE;
+
+    JsonObjectEntry *entry = json_parser_add_item(parser);
+    if (!entry) {
+        if (!parser->arena && !parser->text)
+            free(string.str);
+        return JSON_ERR_FAILED_ALLOCATION;
+    }
+    entry->key = string;
+    // In case the value does not get parsed and initialized.
+    entry->value.type = JSON_NULL;
+    parser->slot = &entry->value;
+    parser->state = JSON_STATE_COLON;
+    return JSON_ERR_OK;
 }
 
-JsonRet json_parse_null(const char *data) {
-    return strncmp(data, NULL_VALUE, 4) == 0 ? CONST_STRLEN(NULL_VALUE) : JSON_ERR_INVALID_VALUE;
+JsonString json_parser_intern_key(JsonParser *parser) {
+    JsonString key = {.str = NULL, .len = parser->bufferLen};
+    bool intern = key.len <= JSON_MAX_KEY_LEN && parser->keysLen < JSON_MAX_KEYS;
+    if (intern && (parser->keysLen + 1) * 2 > parser->keysCap) {
+        // The set is rebuilt at twice the size, so that at most half of it is
+        // used. If that fails, keys are just not shared anymore.
+        JsonLength cap = parser->keysCap ? parser->keysCap * 2 : 64;
+        JsonString *keys = calloc(cap, sizeof(JsonString));
+        if (keys) {
+            for (JsonLength i = 0; i < parser->keysCap; ++i) {
+                JsonString *old = &parser->keys[i];
+                if (!old->str)
+                    continue;
+                JsonLength slot = json_hash(old->str, old->len) & (cap - 1);
+                while (keys[slot].str)
+                    slot = (slot + 1) & (cap - 1);
+                keys[slot] = *old;
+            }
+            free(parser->keys);
+            parser->keys = keys;
+            parser->keysCap = cap;
+        }
+        intern = keys != NULL;
+    }
+    JsonString *slot = NULL;
+    if (intern) {
+        JsonLength mask = parser->keysCap - 1;
+        for (JsonLength i = json_hash(parser->buffer, key.len) & mask;; i = (i + 1) & mask) {
+            slot = &parser->keys[i];
+            if (!slot->str)
+                break;
+            if (slot->len == key.len && !memcmp(slot->str, parser->buffer, key.len))
+                return *slot;
+        }
+    }
+    key.str = arena_alloc_bytes(parser->arena, key.len + 1);
+    if (key.str) {
+        memcpy(key.str, parser->buffer, key.len);
+        key.str[key.len] = '\0';
+        if (slot) {
+            *slot = key;
+            ++parser->keysLen;
+        }
+    }
+    return key;
 }
 
-JsonRet json_parse_string(JsonString *string, const char *data) {
-    const char *begin = data;
-    ++data;
-    bool escaped = false, unicode = false;
-    JsonLength cap = 1;
-    string->len = 0;
-    string->str = malloc(cap);
-    while (*data) {
-        if (escaped) {
+JsonParseError json_parser_end_number(JsonParser *parser) {
+    switch (parser->state) {
+        case JSON_STATE_NUMBER_SIGN:
+            return JSON_ERR_NUMBER_INVALID;
+        case JSON_STATE_NUMBER_DOT:
+            return JSON_ERR_NUMBER_INVALID_DECIMAL;
+        case JSON_STATE_NUMBER_EXP:
+        case JSON_STATE_NUMBER_EXP_SIGN:
+            return JSON_ERR_NUMBER_INVALID_EXPONENT;
+        default:
+            break;
+    }
+    Json *number = parser->slot;
+    number->type = JSON_NUMBER;
+    const char *text = parser->buffer;
+    size_t len = parser->bufferLen, i = 0;
+    bool negative = text[0] == '-';
+
+    // The syntax has already been checked, so the number is only split to
+    // significant digits and decimal exponent. Numbers with more than
+    // JSON_MAX_EXACT_DIGITS significant digits are left to strtod, so further
+    // digits are only counted.
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    long exponent = 0;
+    for (i = negative; i < len && is_digit(text[i]); ++i) {
+        if (digits < JSON_MAX_EXACT_DIGITS)
+            mantissa = mantissa * 10 + (text[i] - '0');
+        digits += digits || text[i] != '0';
+    }
+    if (i < len && text[i] == '.') {
+        for (++i; i < len && is_digit(text[i]); ++i) {
+            if (digits < JSON_MAX_EXACT_DIGITS) {
+                mantissa = mantissa * 10 + (text[i] - '0');
+                --exponent;
+            }
+            digits += digits || text[i] != '0';
+        }
+    }
+    if (i < len) {
+        bool negativeExponent = text[++i] == '-';
+        long value = 0;
+        for (i += text[i] == '-' || text[i] == '+'; i < len; ++i) {
+            // Larger exponents overflow anyway.
+            if (value < 100000)
+                value = value * 10 + (text[i] - '0');
+        }
+        exponent += negativeExponent ? -value : value;
+    }
+
+    bool isInteger = parser->state == JSON_STATE_NUMBER_INT || parser->state == JSON_STATE_NUMBER_ZERO;
+    if (isInteger && digits <= JSON_MAX_EXACT_DIGITS && mantissa <= (unsigned long long)INT64_MAX + negative &&
+        !(negative && !mantissa)) {
+        number->isInteger = true;
+        number->integer = negative ? -(int64_t)(mantissa - 1) - 1 : (int64_t)mantissa;
+        return json_parser_end_scalar(parser);
+    }
+    number->isInteger = false;
+    if (digits <= JSON_MAX_EXACT_DIGITS && mantissa <= JSON_MAX_EXACT_MANTISSA &&
+        labs(exponent) <= JSON_MAX_EXACT_POWER) {
+        // Both the mantissa and the power of ten are exact, so a single
+        // operation gives correctly rounded result (Clinger's fast path).
+        double value = mantissa;
+        value = exponent < 0 ? value / powersOfTen[-exponent] : value * powersOfTen[exponent];
+        number->real = negative ? -value : value;
+        return json_parser_end_scalar(parser);
+    }
+    parser->buffer[len] = '\0';
+    JsonParseError error = json_strtod(parser->buffer, len, &number->real);
+    return error ? error : json_parser_end_scalar(parser);
+}
+
+JsonParseError json_strtod(const char *text, size_t len, double *value) {
+    const char *point = localeconv()->decimal_point;
+    const char *dot = memchr(text, '.', len);
+    if (!dot || !strcmp(point, ".")) {
+        *value = strtod(text, NULL);
+        return JSON_ERR_OK;
+    }
+    // The decimal point is replaced with the one of the locale.
+    size_t pointLen = strlen(point), size = len - 1 + pointLen + 1;
+    char stackBuffer[JSON_NUMBER_BUFFER_SIZE];
+    char *buffer = size <= JSON_NUMBER_BUFFER_SIZE ? stackBuffer : malloc(size);
+    if (!buffer)
+        return JSON_ERR_FAILED_ALLOCATION;
+    size_t before = dot - text;
+    memcpy(buffer, text, before);
+    memcpy(buffer + before, point, pointLen);
+    memcpy(buffer + before + pointLen, dot + 1, len - before);
+    *value = strtod(buffer, NULL);
+    if (buffer != stackBuffer)
+        free(buffer);
+    return JSON_ERR_OK;
+}
+
+JsonParseError json_parser_end_container(JsonParser *parser) {
+    if (parser->handler) {
+        --parser->depth;
+        return parser->handler->end(parser->handler->data) ? json_parser_end_value(parser) : JSON_ERR_STOPPED;
+    }
+    JsonParserFrame *frame = &parser->stack[parser->depth - 1];
+    Json *container = frame->container;
+    bool isArray = container->type == JSON_ARRAY;
+    JsonLength len = container->len;
+    void *items = NULL;
+    bool indexed = !isArray && json_object_index_size(len);
+    if (len) {
+        size_t size = len * (isArray ? sizeof(Json) : sizeof(JsonObjectEntry));
+        items = json_parser_alloc(parser, size + (indexed ? sizeof(JsonObjectIndex) : 0));
+        // On failure, the frame still holds the items for json_parser_abort.
+        if (!items)
+            return JSON_ERR_FAILED_ALLOCATION;
+        memcpy(items, frame->items, size);
+        if (indexed)
+            *(JsonObjectIndex *)((char *)items + size) = (JsonObjectIndex){.arena = parser->arena, .slots = NULL};
+    }
+    if (isArray) {
+        container->values = items;
+    } else {
+        container->entries = items;
+        container->indexed = indexed;
+    }
+    --parser->depth;
+    return json_parser_end_value(parser);
+}
+
+size_t json_parser_string_run(JsonParser *parser, const char *data, size_t size) {
+    size_t length = json_scan_string(data, size);
+    if (json_parser_string_append(parser, data, length))
+        parser->error = JSON_ERR_FAILED_ALLOCATION;
+    return length;
+}
+
+size_t json_parser_digit_run(JsonParser *parser, const char *data, size_t size) {
+    size_t length = 0;
+    while (length < size && is_digit(data[length]))
+        ++length;
+    if (json_parser_buffer_append(parser, data, length))
+        parser->error = JSON_ERR_FAILED_ALLOCATION;
+    return length;
+}
+
+JsonParseError json_parser_step(JsonParser *parser, char c) {
+    switch (parser->state) {
+        case JSON_STATE_VALUE:
+            if (is_whitespace(c))
+                return JSON_ERR_OK;
+            return json_parser_begin_value(parser, c);
+        case JSON_STATE_ARRAY_FIRST:
+        case JSON_STATE_ARRAY_NEXT:
+            if (is_whitespace(c))
+                return JSON_ERR_OK;
+            if (c == ']') {
+                if (parser->state == JSON_STATE_ARRAY_NEXT)
+                    return JSON_ERR_ARRAY_UNEXPECTED_END;
+                return json_parser_end_container(parser);
+            }
+            return json_parser_begin_value(parser, c);
+        case JSON_STATE_OBJECT_FIRST:
+        case JSON_STATE_OBJECT_NEXT:
+            if (is_whitespace(c))
+                return JSON_ERR_OK;
+            if (c == '}') {
+                if (parser->state == JSON_STATE_OBJECT_NEXT)
+                    return JSON_ERR_OBJECT_UNEXPECTED_END;
+                return json_parser_end_container(parser);
+            }
+            if (c != '"')
+                return JSON_ERR_OBJECT_UNEXPECTED_VALUE;
+            return json_parser_begin_string(parser, true);
+        case JSON_STATE_COLON:
+            if (is_whitespace(c))
+                return JSON_ERR_OK;
+            if (c != ':')
+                return JSON_ERR_OBJECT_MISSING_COLLON;
+            parser->state = JSON_STATE_VALUE;
+            return JSON_ERR_OK;
+        case JSON_STATE_AFTER_VALUE: {
+            if (is_whitespace(c))
+                return JSON_ERR_OK;
+            JsonType containerType = parser->depth ? parser->stack[parser->depth - 1].container->type : JSON_NULL;
+            if (containerType == JSON_ARRAY) {
+                if (c == ',') {
+                    parser->state = JSON_STATE_ARRAY_NEXT;
+                    return JSON_ERR_OK;
+                }
+                return c == ']' ? json_parser_end_container(parser) : JSON_ERR_ARRAY_UNEXPECTED_VALUE;
+            }
+            if (containerType == JSON_OBJECT) {
+                if (c == ',') {
+                    parser->state = JSON_STATE_OBJECT_NEXT;
+                    return JSON_ERR_OK;
+                }
+                return c == '}' ? json_parser_end_container(parser) : JSON_ERR_OBJECT_UNEXPECTED_VALUE;
+            }
+            return JSON_ERR_TRAILING_DATA;
+        }
+        case JSON_STATE_STRING:
+            if (c == '"')
+                return json_parser_end_string(parser);
+            if (c == '\\') {
+                parser->state = JSON_STATE_ESCAPE;
+                return JSON_ERR_OK;
+            }
+            return json_parser_string_append(parser, &c, 1);
+        case JSON_STATE_ESCAPE: {
             char token = 0;
-            switch (*data) {
+            switch (c) {
                 case '\\':
-                    token = '\\';
-                    break;
                 case '\"':
-                    token = '\"';
-                    break;
                 case '/':
-                    token = '/';
+                    token = c;
                     break;
                 case 'b':
                     token = '\b';
@@ -137,282 +805,322 @@ JsonRet json_parse_string(JsonString *string, const char *data) {
                     token = '\t';
                     break;
                 case 'u':
-                    unicode = true;
-                    break;
+                    parser->count = 0;
+                    parser->rune = 0;
+                    parser->state = JSON_STATE_UNICODE;
+                    return JSON_ERR_OK;
                 default:
                     return JSON_ERR_STRING_INVALID_ESCAPE;
             }
-            if (token) {
-                string->str = array_append(string->str, &string->len, &cap, sizeof(char), &token);
-                if (!string->str)
-                    return JSON_ERR_FAILED_ALLOCATION;
-            }
-            escaped = false;
-            ++data;
-        } else if (unicode) {
-            char tmp[5];
-            int len = 0;
-            // TODO: check if correct.
-            if (sscanf(data, "%4[0-9a-fA-F]%n", tmp, &len) != 1 || len != 4) {
+            parser->state = JSON_STATE_STRING;
+            return json_parser_string_append(parser, &token, 1);
+        }
+        case JSON_STATE_UNICODE: {
+            int digit = hex_digit_value(c);
+            if (digit < 0)
                 return JSON_ERR_STRING_INVALID_ESCAPE_DIGITS;
-            }
-            unsigned long long rune = strtoull(tmp, NULL, 16);
+            parser->rune = parser->rune * 16 + digit;
+            if (++parser->count < 4)
+                return JSON_ERR_OK;
             char buff[6];
-            int size = utf8encode(rune, buff);
-            for (int i = 0; i < size; ++i) {
-                string->str = array_append(string->str, &string->len, &cap, sizeof(char), buff + i);
-                if (!string->str)
-                    return JSON_ERR_FAILED_ALLOCATION;
-            }
-            // TODO: convert to utf-8?
-            data += 4;
-            unicode = false;
-        } else {
-            switch (*data) {
-                case '\\':
-                    escaped = true;
-                    break;
-                case '"':
-                    string->str = realloc(string->str, string->len + 1);
-                    if (string->str)
-                        string->str[string->len] = 0;
-                    return !string->len || string->str ? data - begin + 1 : JSON_ERR_FAILED_ALLOCATION;
-                default:
-                    string->str = array_append(string->str, &string->len, &cap, sizeof(char), data);
-                    if (!string->str)
-                        return JSON_ERR_FAILED_ALLOCATION;
-            }
-            ++data;
+            int size = utf8encode(parser->rune, buff);
+            parser->state = JSON_STATE_STRING;
+            return json_parser_string_append(parser, buff, size);
         }
-    }
-    return JSON_ERR_STRING_END_NOT_FOUND;
-}
-
-JsonRet json_parse_object(JsonObject *object, const char *data) {
-    const char *begin = data;
-    ++data;
-    Triple needEntry = Maybe;
-    JsonLength cap = 1;
-    object->len = 0;
-    object->entries = malloc(cap * sizeof(object->entries[0]));
-    while (*data) {
-        data = ignore_whitespace(data);
-        if (*data == '}') {
-            if (needEntry == Yes) {
-                return JSON_ERR_OBJECT_UNEXPECTED_END;
+        case JSON_STATE_LITERAL:
+            if (c != parser->literal[parser->count])
+                return JSON_ERR_INVALID_VALUE;
+            if (parser->literal[++parser->count])
+                return JSON_ERR_OK;
+            if (parser->literal[0] == NULL_VALUE[0]) {
+                parser->slot->type = JSON_NULL;
+            } else {
+                parser->slot->type = JSON_BOOLEAN;
+                parser->slot->boolean = parser->literal[0] == TRUE_VALUE[0];
             }
-            object->entries = realloc(object->entries, sizeof(object->entries[0]) * object->len);
-            return !object->len || object->entries ? data - begin + 1 : JSON_ERR_FAILED_ALLOCATION;
-        }
-        if (needEntry == No) {
-            return JSON_ERR_OBJECT_UNEXPECTED_VALUE;
-        }
-        ++(object->len);
-        object->entries = array_grow(object->entries, &object->len, &cap, sizeof(object->entries[0]));
-        if (!object->entries) {
-            return JSON_ERR_FAILED_ALLOCATION;
-        }
-        // In case the value does not get parsed and initialized.
-        object->entries[object->len - 1].value.type = JSON_NULL;
-        JsonRet offset = json_parse_string(&object->entries[object->len - 1].key, data);
-        if (offset < 0) {
-            return offset;
-        }
-        data = ignore_whitespace(data + offset);
-        if (*(data++) != ':') {
-            return JSON_ERR_OBJECT_MISSING_COLLON;
-        }
-        data = ignore_whitespace(data);
-        offset = json_parse_value(&object->entries[object->len - 1].value, data);
-        if (offset < 0) {
-            return offset;
-        }
-        data = ignore_whitespace(data + offset);
-        if (*data == ',') {
-            ++data;
-            needEntry = Yes;
-        } else {
-            needEntry = No;
-        }
+            return json_parser_end_scalar(parser);
+        default:
+            break;
     }
-    return JSON_ERR_OBJECT_END_NOT_FOUND;
-}
 
-void *array_grow(void *array, JsonLength *len, JsonLength *cap, JsonLength size) {
-    if (*len >= *cap) {
-        *cap *= 2;
-        if (!*cap)
-            *cap = 1;
-        array = realloc(array, (*cap) * size);
+    // Numbers end at the first byte which does not belong to them, which is
+    // then processed again.
+    JsonParserState next = parser->state;
+    switch (parser->state) {
+        case JSON_STATE_NUMBER_SIGN:
+            next = c == '0' ? JSON_STATE_NUMBER_ZERO : is_positive_digit(c) ? JSON_STATE_NUMBER_INT : next;
+            if (next == parser->state)
+                return JSON_ERR_NUMBER_INVALID;
+            break;
+        case JSON_STATE_NUMBER_ZERO:
+        case JSON_STATE_NUMBER_INT:
+            if (c == '.')
+                next = JSON_STATE_NUMBER_DOT;
+            else if (c == 'e' || c == 'E')
+                next = JSON_STATE_NUMBER_EXP;
+            else if (!is_digit(c) || parser->state == JSON_STATE_NUMBER_ZERO)
+                next = JSON_STATE_VALUE;
+            break;
+        case JSON_STATE_NUMBER_DOT:
+            if (!is_digit(c))
+                return JSON_ERR_NUMBER_INVALID_DECIMAL;
+            next = JSON_STATE_NUMBER_FRACTION;
+            break;
+        case JSON_STATE_NUMBER_FRACTION:
+            if (c == 'e' || c == 'E')
+                next = JSON_STATE_NUMBER_EXP;
+            else if (!is_digit(c))
+                next = JSON_STATE_VALUE;
+            break;
+        case JSON_STATE_NUMBER_EXP:
+        case JSON_STATE_NUMBER_EXP_SIGN:
+            if (parser->state == JSON_STATE_NUMBER_EXP && (c == '+' || c == '-'))
+                next = JSON_STATE_NUMBER_EXP_SIGN;
+            else if (is_digit(c))
+                next = JSON_STATE_NUMBER_EXP_DIGITS;
+            else
+                return JSON_ERR_NUMBER_INVALID_EXPONENT;
+            break;
+        case JSON_STATE_NUMBER_EXP_DIGITS:
+            if (!is_digit(c))
+                next = JSON_STATE_VALUE;
+            break;
+        default:
+            break;
     }
-    if (!array) {
-        *cap = *len = 0;
+    if (next == JSON_STATE_VALUE) {
+        JsonParseError error = json_parser_end_number(parser);
+        return error ? error : json_parser_step(parser, c);
     }
-    return array;
+    parser->state = next;
+    return json_parser_buffer_append(parser, &c, 1);
 }
 
-void *array_append(void *array, JsonLength *len, JsonLength *cap, JsonLength size, const void *value) {
-    ++(*len);
-    array = array_grow(array, len, cap, size);
-    if (array) {
-        memcpy((char *)array + ((*len) - 1) * size, value, size);
+JsonParseError json_parser_feed(JsonParser *parser, const char *data, size_t size) {
+    parser->size += size;
+    if (!parser->error && parser->maxSize != JSON_NO_SIZE_LIMIT && parser->size > parser->maxSize)
+        parser->error = JSON_ERR_SIZE_LIMIT;
+    for (size_t i = 0; i < size && !parser->error; ++i) {
+        if (parser->state == JSON_STATE_STRING) {
+            i += json_parser_string_run(parser, data + i, size - i);
+            if (i == size || parser->error)
+                break;
+        } else if (parser->state < JSON_STATE_STRING && is_whitespace(data[i])) {
+            i += json_scan_whitespace(data + i, size - i);
+            if (i == size)
+                break;
+        } else if (parser->state == JSON_STATE_NUMBER_INT || parser->state == JSON_STATE_NUMBER_FRACTION ||
+                   parser->state == JSON_STATE_NUMBER_EXP_DIGITS) {
+            i += json_parser_digit_run(parser, data + i, size - i);
+            if (i == size || parser->error)
+                break;
+        }
+        parser->cursor = data + i;
+        parser->error = json_parser_step(parser, data[i]);
     }
-    return array;
+    if (parser->error)
+        json_parser_abort(parser);
+    return parser->error;
 }
 
-JsonRet json_parse_array(JsonArray *array, const char *data) {
-    const char *begin = data;
-    ++data;
-    Triple needValue = Maybe;
-    JsonLength cap = 1;
-    array->len = 0;
-    array->values = malloc(cap * sizeof(Json));
+JsonParseError json_parser_finish(JsonParser *parser) {
+    if (!parser->error) {
+        switch (parser->state) {
+            case JSON_STATE_STRING:
+            case JSON_STATE_ESCAPE:
+                parser->error = JSON_ERR_STRING_END_NOT_FOUND;
+                break;
+            case JSON_STATE_UNICODE:
+                parser->error = JSON_ERR_STRING_INVALID_ESCAPE_DIGITS;
+                break;
+            case JSON_STATE_LITERAL:
+                parser->error = JSON_ERR_INVALID_VALUE;
+                break;
+            case JSON_STATE_AFTER_VALUE:
+                break;
+            default:
+                if (parser->state >= JSON_STATE_NUMBER_SIGN)
+                    parser->error = json_parser_end_number(parser);
+                else if (!parser->depth)
+                    parser->error = JSON_ERR_INVALID_VALUE;
+                break;
+        }
+    }
+    if (!parser->error && parser->depth) {
+        bool array = parser->stack[parser->depth - 1].container->type == JSON_ARRAY;
+        parser->error = array ? JSON_ERR_ARRAY_END_NOT_FOUND : JSON_ERR_OBJECT_END_NOT_FOUND;
+    }
+    JsonParseError error = parser->error;
+    if (error)
+        json_parser_abort(parser);
+    // The tree now belongs to the caller.
+    parser->root = NULL;
+    json_parser_cleanup(parser);
+    return error;
+}
 
-    while (*data) {
-        data = ignore_whitespace(data);
-        if (*data == ']') {
-            if (needValue == Yes) {
-                return JSON_ERR_ARRAY_UNEXPECTED_END;
+void json_parser_abort(JsonParser *parser) {
+    if (!parser->root)
+        return;
+    // Values of open containers are still in the buffers of their frames,
+    // starting with the innermost one.
+    for (JsonLength i = parser->depth; i > 0; --i) {
+        Json *container = parser->stack[i - 1].container;
+        if (!parser->arena && container->type == JSON_ARRAY) {
+            for (JsonLength j = 0; j < container->len; ++j)
+                json_value_cleanup(&container->values[j]);
+        } else if (!parser->arena) {
+            for (JsonLength j = 0; j < container->len; ++j) {
+                json_string_cleanup(&container->entries[j].key);
+                json_value_cleanup(&container->entries[j].value);
             }
-            array->values = realloc(array->values, sizeof(Json) * array->len);
-            return !array->len || array->values ? data - begin + 1 : 0;
-        }
-        if (needValue == No) {
-            return JSON_ERR_ARRAY_UNEXPECTED_VALUE;
-        }
-        ++(array->len);
-        array->values = array_grow(array->values, &array->len, &cap, sizeof(array->values[0]));
-        if (!array->values) {
-            return JSON_ERR_FAILED_ALLOCATION;
-        }
-        // In case the value does not get parsed and initialized.
-        array->values[array->len - 1].type = JSON_NULL;
-        JsonRet offset = json_parse_value(&array->values[array->len - 1], data);
-        if (offset < 0) {
-            return offset;
-        }
-        data = ignore_whitespace(data + offset);
-        if (*data == ',') {
-            ++data;
-            needValue = Yes;
-        } else {
-            needValue = No;
         }
+        container->type = JSON_NULL;
     }
-    return JSON_ERR_ARRAY_END_NOT_FOUND;
+    parser->depth = 0;
+    if (!parser->arena)
+        json_cleanup(parser->root);
+    parser->root->type = JSON_NULL;
 }
 
-inline bool is_digit(char c) {
-    return c >= '0' && c <= '9';
+void json_parser_cleanup(JsonParser *parser) {
+    json_parser_abort(parser);
+    parser->root = NULL;
+    for (JsonLength i = 0; i < parser->stackCap; ++i)
+        free(parser->stack[i].items);
+    free(parser->stack);
+    free(parser->buffer);
+    free(parser->keys);
+    parser->stack = NULL;
+    parser->buffer = NULL;
+    parser->keys = NULL;
+    parser->depth = parser->stackCap = 0;
+    parser->bufferLen = parser->bufferCap = 0;
+    parser->keysLen = parser->keysCap = 0;
 }
 
-inline bool is_positive_digit(char c) {
-    return c >= '1' && c <= '9';
+JsonParseError json_parse(Json *json, const char *data) {
+    return json_parse_arena(json, data, NULL);
 }
 
-JsonRet json_parse_number(JsonNumber *number, const char *data) {
-    const char *begin = data;
-    if (*data == '-') {
-        ++data;
-    }
-    if (*data == '0') {
-        ++data;
-    } else if (is_positive_digit(*data)) {
-        ++data;
-        while (is_digit(*data)) {
-            ++data;
-        }
-    } else {
-        return JSON_ERR_NUMBER_INVALID;
+JsonParseError json_parse_arena(Json *json, const char *data, Arena *arena) {
+    JsonParser parser;
+    json_parser_init_arena(&parser, json, arena);
+    json_parser_feed(&parser, data, strlen(data));
+    return json_parser_finish(&parser);
+}
+
+JsonParseError json_parse_in_situ(Json *json, char *data, Arena *arena) {
+    JsonParser parser;
+    json_parser_init_arena(&parser, json, arena);
+    parser.text = data;
+    json_parser_feed(&parser, data, strlen(data));
+    return json_parser_finish(&parser);
+}
+
+JsonLength json_object_index_size(JsonLength len) {
+    if (len < JSON_INDEX_MIN_LEN || len > UINT_MAX / 4)
+        return 0;
+    JsonLength size = JSON_INDEX_MIN_LEN * 2;
+    while (size < len * 2)
+        size *= 2;
+    return size;
+}
+
+JsonObjectIndex *json_object_index(Json *object) {
+    return (JsonObjectIndex *)(object->entries + object->len);
+}
+
+JsonLength json_hash(const char *data, size_t size) {
+    // Every byte is mixed, 8 at a time, so that keys sent by the server can't
+    // be made to collide cheaply.
+    uint64_t hash = size * 0x9e3779b97f4a7c15u;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0xbf58476d1ce4e5b9u;
+        hash ^= hash >> 31;
     }
-    if (*data == '.') {
-        ++data;
-        if (!is_digit(*data)) {
-            return JSON_ERR_NUMBER_INVALID_DECIMAL;
-        }
-        while (is_digit(*data)) {
-            ++data;
+    uint64_t word = 0;
+    for (int shift = 0; i < size; ++i, shift += 8)
+        word |= (uint64_t)(unsigned char)data[i] << shift;
+    hash = (hash ^ word) * 0x94d049bb133111ebu;
+    return (JsonLength)(hash ^ hash >> 32);
+}
+
+bool json_object_build_index(Json *object) {
+    JsonObjectIndex *index = json_object_index(object);
+    JsonLength indexSize = json_object_index_size(object->len), mask = indexSize - 1;
+    size_t size = indexSize * sizeof(JsonLength);
+    index->slots = index->arena ? arena_alloc(index->arena, size) : malloc(size);
+    if (!index->slots)
+        return false;
+    memset(index->slots, 0, size);
+    for (JsonLength i = 0; i < object->len; ++i) {
+        JsonString *key = &object->entries[i].key;
+        JsonLength slot = json_hash(key->str, key->len) & mask;
+        bool duplicate = false;
+        for (; index->slots[slot] && !duplicate; slot = (slot + 1) & mask) {
+            JsonString *other = &object->entries[index->slots[slot] - 1].key;
+            duplicate = other->len == key->len && !memcmp(other->str, key->str, key->len);
         }
+        // Only the first of duplicate keys is indexed, as found by linear
+        // search.
+        if (!duplicate)
+            index->slots[slot] = i + 1;
     }
-    if (*data == 'e' || *data == 'E') {
-        ++data;
-        if (*data == '+' || *data == '-') {
-            ++data;
-        }
-        if (!is_digit(*data)) {
-            return JSON_ERR_NUMBER_INVALID_EXPONENT;
-        }
-        while (is_digit(*data)) {
-            ++data;
+    return true;
+}
+
+Json *json_object_get(Json *json, const char *key) {
+    if (json->type != JSON_OBJECT)
+        return NULL;
+    size_t len = strlen(key);
+    JsonObjectIndex *index = json->indexed ? json_object_index(json) : NULL;
+    // Objects are searched linearly if the index can't be built.
+    if (!index || (!index->slots && !json_object_build_index(json))) {
+        for (JsonLength i = 0; i < json->len; ++i) {
+            JsonString *other = &json->entries[i].key;
+            if (other->len == len && !memcmp(other->str, key, len))
+                return &json->entries[i].value;
         }
+        return NULL;
     }
-    char *endPtr;
-    // TODO: use locale-independent way and check for overflows.
-    *number = strtold(begin, &endPtr);
-    if (endPtr != data) {
-        return JSON_ERR_NUMBER_INVALID;
+    JsonLength mask = json_object_index_size(json->len) - 1;
+    for (JsonLength slot = json_hash(key, len) & mask; index->slots[slot]; slot = (slot + 1) & mask) {
+        JsonObjectEntry *entry = &json->entries[index->slots[slot] - 1];
+        if (entry->key.len == len && !memcmp(entry->key.str, key, len))
+            return &entry->value;
     }
-    return endPtr - begin;
+    return NULL;
 }
 
-JsonRet json_parse_value(Json *json, const char *data) {
-    // In case the value does not get parsed and initialized.
-    json->type = JSON_NULL;
-    switch (*data) {
-        case '{':
-            json->type = JSON_OBJECT;
-            return json_parse_object(&json->object, data);
-        case '[':
-            json->type = JSON_ARRAY;
-            return json_parse_array(&json->array, data);
-        case '"':
-            json->type = JSON_STRING;
-            return json_parse_string(&json->string, data);
-        case 't':
-        case 'f':
-            json->type = JSON_BOOLEAN;
-            return json_parse_boolean(&json->boolean, data);
-        case 'n':
-            json->type = JSON_NULL;
-            return json_parse_null(data);
-        default:
-            if (*data == '-' || is_digit(*data)) {
-                json->type = JSON_NUMBER;
-                return json_parse_number(&json->number, data);
-            }
-            return JSON_ERR_INVALID_VALUE;
-    }
+int64_t json_integer(Json *json) {
+    return json->isInteger ? json->integer : (int64_t)json->real;
 }
 
-JsonParseError json_parse(Json *json, const char *data) {
-    data = ignore_whitespace(data);
-    JsonRet offset = json_parse_value(json, data);
-    if (offset < 0 || *ignore_whitespace(data + offset) != 0) {
-        json_cleanup(json);
-        return offset < 0 ? offset : JSON_ERR_TRAILING_DATA;
-    }
-    return JSON_ERR_OK;
+double json_real(Json *json) {
+    return json->isInteger ? (double)json->integer : json->real;
 }
 
 void json_string_cleanup(JsonString *string) {
     free(string->str);
 }
 
-void json_object_cleanup(JsonObject *object) {
-    if (object && object->entries) {
-        for (JsonLength i = 0; i < object->len; ++i) {
-            json_string_cleanup(&object->entries[i].key);
-            json_value_cleanup(&object->entries[i].value);
-        }
+void json_object_cleanup(Json *object) {
+    for (JsonLength i = 0; i < object->len; ++i) {
+        json_string_cleanup(&object->entries[i].key);
+        json_value_cleanup(&object->entries[i].value);
     }
+    if (object->indexed)
+        free(json_object_index(object)->slots);
     free(object->entries);
 }
 
-void json_array_cleanup(JsonArray *array) {
-    if (array && array->values) {
-        for (JsonLength i = 0; i < array->len; ++i) {
-            json_value_cleanup(&array->values[i]);
-        }
+void json_array_cleanup(Json *array) {
+    for (JsonLength i = 0; i < array->len; ++i) {
+        json_value_cleanup(&array->values[i]);
     }
     free(array->values);
 }
@@ -420,13 +1128,13 @@ void json_array_cleanup(JsonArray *array) {
 void json_value_cleanup(Json *json) {
     switch (json->type) {
         case JSON_OBJECT:
-            json_object_cleanup(&json->object);
+            json_object_cleanup(json);
             break;
         case JSON_ARRAY:
-            json_array_cleanup(&json->array);
+            json_array_cleanup(json);
             break;
         case JSON_STRING:
-            json_string_cleanup(&json->string);
+            free(json->str);
             break;
         default:
             // Other types don't contain anything required to free.
@@ -3,14 +3,18 @@
  * Licensed as with https://github.com/moodle-tui/moot
  *
  * Yet another JSON (https://json.org) parser. While it is usable, this parser
- * was made to exercise coding and there are better JSON parsers around. The
- * main flaw of this parser is that it is recursively implemented and thus will
- * probably crash if the level of nested objects/arrays reaches very high
- * number. 
+ * was made to exercise coding and there are better JSON parsers around.
  *
- * Besides this, currently it does not validate utf-8 at all, and no number
- * overflow is checked. Standart C library funcions are used to parse numbers,
- * thus it is locale-dependent.
+ * The parser is a state machine with an explicit stack of open objects and
+ * arrays, so it does not recurse and input can be pushed to it in chunks of
+ * any size (e. g. as they are downloaded) using JsonParser. json_parse is a
+ * shortcut for parsing a whole string at once. Nesting depth and document size
+ * are limited (see json_parser_set_limits), so that hostile input can't
+ * exhaust memory. A parser may also pass the values to a JsonHandler as they
+ * are parsed instead of building them (see json_parser_init_handler).
+ *
+ * Currently it does not validate utf-8 at all. Numbers which don't fit to a
+ * double become infinite.
  *
  * Because not specified in the standard and due to the current implementation
  * duplicate keys in objects are allowed.
@@ -22,6 +26,11 @@
 #ifndef __JSON_H
 #define __JSON_H
 #include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
 
 // JsonType holds the possible types of Json value.
 typedef enum JsonType {
@@ -38,7 +47,7 @@ typedef struct Json Json;
 // JsonLength is the length type used in various JSON values.
 typedef unsigned int JsonLength;
 
-// JsonString represents json string.
+// JsonString represents json string, such as the keys of objects.
 typedef struct {
     char *str;
     JsonLength len;
@@ -46,43 +55,44 @@ typedef struct {
 
 typedef struct JsonObjectEntry JsonObjectEntry;
 
-// JsonObject represents JSON object type.
-typedef struct {
-    JsonObjectEntry *entries;
-    JsonLength len;
-} JsonObject;
-
-// JsonArray represents JSON array type.
-typedef struct {
-    Json *values;
-    JsonLength len;
-} JsonArray;
-
-// JsonNumber is the type of a JSON number.
-typedef long double JsonNumber;
-
 // JsonBoolean is the type of a JSON boolean.
 typedef int JsonBoolean;
 
 // Json is general JSON value which has specific type. It is returned by
-// json_parse and may be contained in JSON objects and arrays.
+// json_parse and may be contained in JSON objects and arrays. It's 16 bytes on
+// 64 bit platforms: the value itself or a pointer to it, the length of
+// strings, arrays and objects, and the type.
+//
+// Numbers without fraction or exponent are kept exactly in integer if they fit
+// to int64_t, other numbers in real. Parsed objects of at least
+// JSON_INDEX_MIN_LEN entries get a hash index of their keys, which is only
+// allocated and built by the first json_object_get. Objects made by hand
+// should leave indexed false.
 struct Json {
-    JsonType type;
     union {
-        JsonObject object;
-        JsonArray array;
-        JsonString string;
-        JsonNumber number;
+        JsonObjectEntry *entries;  // of JSON_OBJECT.
+        Json *values;              // of JSON_ARRAY.
+        char *str;                 // of JSON_STRING, '\0' terminated.
+        int64_t integer;           // of JSON_NUMBER if isInteger.
+        double real;               // of JSON_NUMBER otherwise.
         JsonBoolean boolean;
     };
+    JsonLength len;                // of entries, values or str.
+    unsigned char type;            // JsonType.
+    bool isInteger;
+    bool indexed;
 };
 
-// JsonObjectEntry is the type of entries in a JsonObject.
+// JsonObjectEntry is the type of entries in a JSON object.
 struct JsonObjectEntry {
     JsonString key;
     Json value;
 };
 
+// JSON_INDEX_MIN_LEN is the number of entries from which parsed objects get a
+// hash index. Smaller objects are faster to search linearly.
+#define JSON_INDEX_MIN_LEN 8
+
 // JsonParseError holds the possible errors returned by the parser.
 typedef enum JsonParseError {
     JSON_ERR_OK = 0,
@@ -102,13 +112,128 @@ typedef enum JsonParseError {
     JSON_ERR_NUMBER_INVALID_DECIMAL,
     JSON_ERR_NUMBER_INVALID_EXPONENT,    
     JSON_ERR_TRAILING_DATA,
+    JSON_ERR_DEPTH_LIMIT,
+    JSON_ERR_SIZE_LIMIT,
+    JSON_ERR_STOPPED,  // by JsonHandler.
 } JsonParseError;
 
+// JSON_DEFAULT_MAX_DEPTH is the default limit of nested objects and arrays.
+#define JSON_DEFAULT_MAX_DEPTH 1024
+// JSON_NO_SIZE_LIMIT is the default document size limit, meaning no limit.
+#define JSON_NO_SIZE_LIMIT 0
+
+typedef struct JsonParserFrame JsonParserFrame;
+
+// JsonHandler receives the values of a parser initialized using
+// json_parser_init_handler in the order of the document. Each function returns
+// false to stop parsing with JSON_ERR_STOPPED.
+typedef struct JsonHandler {
+    // begin is called at the start of each object and array, and end at the
+    // end of it.
+    bool (*begin)(void *data, JsonType type);
+    bool (*end)(void *data);
+    // key is called with each key of an object before its value. The key is
+    // '\0' terminated and only valid during the call.
+    bool (*key)(void *data, const char *key, JsonLength len);
+    // value is called with each string, number, boolean and null. Strings are
+    // only valid during the call.
+    bool (*value)(void *data, Json *value);
+    void *data;  // passed to the functions.
+} JsonHandler;
+
+// JsonParser is the state of incremental parsing. Its fields are private.
+typedef struct JsonParser {
+    Json *root, *slot;
+    Arena *arena;
+    char *text;  // parsed in situ, see json_parse_in_situ.
+    char *stringStart, *stringEnd;
+    const char *cursor;  // current byte of the fed data.
+    JsonParserFrame *stack;
+    JsonLength depth, stackCap, maxDepth;
+    size_t size, maxSize;
+    int state;
+    char *buffer;  // text of the current string or number.
+    size_t bufferLen, bufferCap;
+    JsonString *keys;  // hash set of keys copied to the arena.
+    JsonLength keysLen, keysCap;
+    const char *literal;
+    int count;
+    long rune;
+    bool isKey;
+    JsonHandler *handler;
+    Json value;  // the current value in handler mode.
+    JsonParseError error;
+} JsonParser;
+
+// json_parser_init prepares parser to parse a value to given Json object.
+// Pointers should be valid and non-NULL.
+void json_parser_init(JsonParser *parser, Json *json);
+
+// json_parser_init_arena is the same as json_parser_init, but the parsed value
+// is allocated from given arena (unless it's NULL), see json_parse_arena.
+void json_parser_init_arena(JsonParser *parser, Json *json, Arena *arena);
+
+// json_parser_init_handler prepares parser to pass the parsed values to the
+// handler instead of building them, which is cheaper if the values are only
+// needed once. Parsing errors may be reported after some of the values have
+// already been passed.
+void json_parser_init_handler(JsonParser *parser, JsonHandler *handler);
+
+// json_parser_set_limits sets the maximum depth of nested objects and arrays
+// and the maximum size in bytes of the document (or JSON_NO_SIZE_LIMIT), which
+// otherwise are JSON_DEFAULT_MAX_DEPTH and JSON_NO_SIZE_LIMIT. Exceeding them
+// is an error (JSON_ERR_DEPTH_LIMIT, JSON_ERR_SIZE_LIMIT).
+void json_parser_set_limits(JsonParser *parser, JsonLength maxDepth, size_t maxSize);
+
+// json_parser_feed parses next size bytes of data. Data may be split anywhere,
+// even inside of values. Once an error is returned, the parser stops, the
+// partially parsed value is freed and the same error is returned again.
+JsonParseError json_parser_feed(JsonParser *parser, const char *data, size_t size);
+
+// json_parser_finish checks that the whole value has been fed and releases the
+// resources of the parser, returning parse error. On success, the Json object
+// holds the parsed value, which can be freed using json_cleanup.
+JsonParseError json_parser_finish(JsonParser *parser);
+
+// json_parser_cleanup releases the resources of the parser along with the
+// partially parsed value, in case parsing is abandoned before finishing. It may
+// be called after json_parser_finish as well.
+void json_parser_cleanup(JsonParser *parser);
+
 // json_parse parses given data to given Json object, returning parse error.
 // Pointers should be valid and non-NULL. Resources allocated during parsing can
-// be freed using json_cleanup.
+// be freed using json_cleanup. Every string, object and array is malloc'ed on
+// its own, which makes its speed depend on the state of the heap, so large or
+// deeply nested documents are better parsed using json_parse_arena.
 JsonParseError json_parse(Json *json, const char *data);
 
+// json_parse_arena is the same as json_parse, but all the memory of the parsed
+// value is allocated from given arena, so it's released along with the arena
+// and json_cleanup must not be used. Arena may be NULL to parse as json_parse.
+// Failed parsing may leave unused memory in the arena.
+JsonParseError json_parse_arena(Json *json, const char *data, Arena *arena);
+
+// json_parse_in_situ is the same as json_parse_arena, but strings are not
+// copied. Instead, they are decoded in place, so the parsed value points into
+// data, which is modified and must be kept as long as the value is used. The
+// arena must not be NULL.
+JsonParseError json_parse_in_situ(Json *json, char *data, Arena *arena);
+
+// json_object_get returns the value of given key in the object, or NULL if the
+// key is missing or json is not an object. If there are duplicate keys, the
+// first one is found. The first lookup in an indexed object (see Json)
+// allocates its index from the arena the object was parsed to, so an object
+// should not be searched from several threads at once, nor while its arena is
+// used by another thread.
+Json *json_object_get(Json *json, const char *key);
+
+// json_integer returns the value of a JSON_NUMBER as integer, truncating reals.
+int64_t json_integer(Json *json);
+
+// json_real returns the value of a JSON_NUMBER as double, whether it's an
+// integer or not.
+double json_real(Json *json);
+
 // Releases resources held by JSON object.
 void json_cleanup(Json *json);
 
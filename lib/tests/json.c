@@ -21,38 +21,59 @@ typedef struct TestCase {
 bool approxEquals(double value, double other, double epsilon);
 bool jsonEquals(Json *a, Json *b) ;
 
+// TreeBuilder builds a tree out of the values passed to a JsonHandler, so that
+// handler mode can be tested against the same expected values.
+typedef struct TreeBuilder {
+    Json root;
+    Json *stack[JSON_DEFAULT_MAX_DEPTH];
+    int depth;
+    char *key;
+} TreeBuilder;
+
 bool test(TestCase testCase, int number);
+bool testParse(TestCase testCase, size_t chunkSize, Arena *arena, bool inSitu);
+bool testParseHandler(TestCase testCase, size_t chunkSize);
+Json *builderAdd(TreeBuilder *builder);
+bool builderBegin(void *data, JsonType type);
+bool builderEnd(void *data);
+bool builderKey(void *data, const char *key, JsonLength len);
+bool builderValue(void *data, Json *value);
 
 int main() {
+    // Nested one level deeper than allowed.
+    char tooDeep[JSON_DEFAULT_MAX_DEPTH + 2];
+    memset(tooDeep, '[', JSON_DEFAULT_MAX_DEPTH + 1);
+    tooDeep[JSON_DEFAULT_MAX_DEPTH + 1] = '\0';
+
     TestCase testCases[] = {
         {
             .inputData = "1.2",
-            .expectedJson = &(Json){.type = JSON_NUMBER, .number = 1.2,},
+            .expectedJson = &(Json){.type = JSON_NUMBER, .real = 1.2,},
             .expectedError = JSON_ERR_OK,
         },
         {
             .inputData = "\"Hello world!\"",
-            .expectedJson = &(Json){.type = JSON_STRING, .string = {.str = "Hello world!", .len = 12,},},
+            .expectedJson = &(Json){.type = JSON_STRING, .str = "Hello world!", .len = 12,},
             .expectedError = JSON_ERR_OK,
         },
         {
             .inputData = "{\"a\":{\"b\":{\"c\":{\"1\":10.456e-10, \"2\":\"text\", \"3\":true, \"4\":false, \"5\":null, \"6\":{}, \"7\":[]}}}}",
-            .expectedJson = &(Json){.type = JSON_OBJECT, .object = { .entries = (JsonObjectEntry[]){{.key = {.str = "a", .len = 1,},.value = {.type = JSON_OBJECT, .object = { .entries = (JsonObjectEntry[]){{.key = {.str = "b", .len = 1,},.value = {.type = JSON_OBJECT, .object = { .entries = (JsonObjectEntry[]){{.key = {.str = "c", .len = 1,},.value = {.type = JSON_OBJECT, .object = { .entries = (JsonObjectEntry[]){{.key = {.str = "5", .len = 1,},.value = {.type = JSON_NULL,},},{.key = {.str = "6", .len = 1,},.value = {.type = JSON_OBJECT, .object = { .len = 0,},},},{.key = {.str = "7", .len = 1,},.value = {.type = JSON_ARRAY, .array = { .len = 0,},},},{.key = {.str = "1", .len = 1,},.value = {.type = JSON_NUMBER, .number = 1.0456e-09,},},{.key = {.str = "2", .len = 1,},.value = {.type = JSON_STRING, .string = {.str = "text", .len = 4,},},},{.key = {.str = "3", .len = 1,},.value = {.type = JSON_BOOLEAN, .boolean = true,},},{.key = {.str = "4", .len = 1,},.value = {.type = JSON_BOOLEAN, .boolean = false,},},}, .len = 7,},},},}, .len = 1,},},},}, .len = 1,},},},}, .len = 1,},},
+            .expectedJson = &(Json){.type = JSON_OBJECT, .entries = (JsonObjectEntry[]){{.key = {.str = "a", .len = 1,},.value = {.type = JSON_OBJECT, .entries = (JsonObjectEntry[]){{.key = {.str = "b", .len = 1,},.value = {.type = JSON_OBJECT, .entries = (JsonObjectEntry[]){{.key = {.str = "c", .len = 1,},.value = {.type = JSON_OBJECT, .entries = (JsonObjectEntry[]){{.key = {.str = "5", .len = 1,},.value = {.type = JSON_NULL,},},{.key = {.str = "6", .len = 1,},.value = {.type = JSON_OBJECT, .len = 0,},},{.key = {.str = "7", .len = 1,},.value = {.type = JSON_ARRAY, .len = 0,},},{.key = {.str = "1", .len = 1,},.value = {.type = JSON_NUMBER, .real = 1.0456e-09,},},{.key = {.str = "2", .len = 1,},.value = {.type = JSON_STRING, .str = "text", .len = 4,},},{.key = {.str = "3", .len = 1,},.value = {.type = JSON_BOOLEAN, .boolean = true,},},{.key = {.str = "4", .len = 1,},.value = {.type = JSON_BOOLEAN, .boolean = false,},},}, .len = 7,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},
             .expectedError = JSON_ERR_OK,
         },
         {
             .inputData = "[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]",
-            .expectedJson = &(Json){.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_ARRAY, .array = { .len = 0,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},}, .len = 1,},},
+            .expectedJson = &(Json){.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_ARRAY, .len = 0,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},}, .len = 1,},
             .expectedError = JSON_ERR_OK,
         },
         {
             .inputData = "[\"\\uDADA\"]",
-            .expectedJson = &(Json){.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_STRING, .string = {.str = "�", .len = 3,},},}, .len = 1,},},
+            .expectedJson = &(Json){.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_STRING, .str = "�", .len = 3,},}, .len = 1,},
             .expectedError = JSON_ERR_OK,
         },
         {
             .inputData = "\n\t\t{\n\t\t\t\n\t\t\t\"\\taa\\t\\uDADA\"\n\t\t\t\n\t\t\t:\n\t\t\t\n\t\t\t\n\t\t\t{\n\t\t\t\t\n\t\t\t\t\"\\uBCAA\"\n\t\t\t\t\n\t\t\t\t:\n\t\t\t\t\n\t\t\t\t[\n\t\t\t\t\t]\n\t\t\t}\n\t\t}",
-            .expectedJson = &(Json){.type = JSON_OBJECT, .object = { .entries = (JsonObjectEntry[]){{.key = {.str = "\taa\t�", .len = 7,},.value = {.type = JSON_OBJECT, .object = { .entries = (JsonObjectEntry[]){{.key = {.str = "벪", .len = 3,},.value = {.type = JSON_ARRAY, .array = { .len = 0,},},},}, .len = 1,},},},}, .len = 1,},},
+            .expectedJson = &(Json){.type = JSON_OBJECT, .entries = (JsonObjectEntry[]){{.key = {.str = "\taa\t�", .len = 7,},.value = {.type = JSON_OBJECT, .entries = (JsonObjectEntry[]){{.key = {.str = "벪", .len = 3,},.value = {.type = JSON_ARRAY, .len = 0,},},}, .len = 1,},},}, .len = 1,},
             .expectedError = JSON_ERR_OK,
         },
         {
@@ -72,12 +93,12 @@ int main() {
         },
         {
             .inputData = "[true]",
-            .expectedJson = &(Json){.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_BOOLEAN, .boolean = true,},}, .len = 1,},},
+            .expectedJson = &(Json){.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_BOOLEAN, .boolean = true,},}, .len = 1,},
             .expectedError = JSON_ERR_OK,
         },
         {
             .inputData = "[-0]",
-            .expectedJson = &(Json){.type = JSON_ARRAY, .array = { .values = (Json[]){{.type = JSON_NUMBER, .number = -0,},}, .len = 1,},},
+            .expectedJson = &(Json){.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_NUMBER, .real = -0.0,},}, .len = 1,},
             .expectedError = JSON_ERR_OK,
         },
         {
@@ -97,17 +118,17 @@ int main() {
         },
         {
             .inputData = "-0e0",
-            .expectedJson = &(Json){.type = JSON_NUMBER, .number = -0,},
+            .expectedJson = &(Json){.type = JSON_NUMBER, .real = -0.0,},
             .expectedError = JSON_ERR_OK,
         },
         {
             .inputData = "-0e-0",
-            .expectedJson = &(Json){.type = JSON_NUMBER, .number = -0,},
+            .expectedJson = &(Json){.type = JSON_NUMBER, .real = -0.0,},
             .expectedError = JSON_ERR_OK,
         },
         {
             .inputData = "-0e+0",
-            .expectedJson = &(Json){.type = JSON_NUMBER, .number = -0,},
+            .expectedJson = &(Json){.type = JSON_NUMBER, .real = -0.0,},
             .expectedError = JSON_ERR_OK,
         },
         {
@@ -160,6 +181,26 @@ int main() {
             .expectedJson = NULL,
             .expectedError = JSON_ERR_NUMBER_INVALID_DECIMAL,
         },
+        {
+            .inputData = "[\"A string long enough to be scanned in blocks, \\\"with\\\" escapes\\/ in between.\",                                          \n\t\"\"]",
+            .expectedJson = &(Json){.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_STRING, .str = "A string long enough to be scanned in blocks, \"with\" escapes/ in between.", .len = 73,},{.type = JSON_STRING, .str = "", .len = 0,},}, .len = 2,},
+            .expectedError = JSON_ERR_OK,
+        },
+        {
+            .inputData = "{\"id\":0, \"name\":1, \"b\":2, \"modname\":3, \"a\":4, \"instance\":5, \"visible\":6, \"url\":7, \"b\":8, \"contents\":9}",
+            .expectedJson = &(Json){.type = JSON_OBJECT, .entries = (JsonObjectEntry[]){{.key = {.str = "id", .len = 2,},.value = {.type = JSON_NUMBER, .integer = 0, .isInteger = true,},},{.key = {.str = "name", .len = 4,},.value = {.type = JSON_NUMBER, .integer = 1, .isInteger = true,},},{.key = {.str = "b", .len = 1,},.value = {.type = JSON_NUMBER, .integer = 2, .isInteger = true,},},{.key = {.str = "modname", .len = 7,},.value = {.type = JSON_NUMBER, .integer = 3, .isInteger = true,},},{.key = {.str = "a", .len = 1,},.value = {.type = JSON_NUMBER, .integer = 4, .isInteger = true,},},{.key = {.str = "instance", .len = 8,},.value = {.type = JSON_NUMBER, .integer = 5, .isInteger = true,},},{.key = {.str = "visible", .len = 7,},.value = {.type = JSON_NUMBER, .integer = 6, .isInteger = true,},},{.key = {.str = "url", .len = 3,},.value = {.type = JSON_NUMBER, .integer = 7, .isInteger = true,},},{.key = {.str = "b", .len = 1,},.value = {.type = JSON_NUMBER, .integer = 8, .isInteger = true,},},{.key = {.str = "contents", .len = 8,},.value = {.type = JSON_NUMBER, .integer = 9, .isInteger = true,},},}, .len = 10,},
+            .expectedError = JSON_ERR_OK,
+        },
+        {
+            .inputData = "[0, -1, 9223372036854775807, -9223372036854775808, 9223372036854775808, 123456789012345678901234, 0.1, -25E-4, 1e22, 1e23, 1.7976931348623157e308, 4.9e-324, 0.30000000000000004, 1e400]",
+            .expectedJson = &(Json){.type = JSON_ARRAY, .values = (Json[]){{.type = JSON_NUMBER, .integer = 0, .isInteger = true,},{.type = JSON_NUMBER, .integer = -1, .isInteger = true,},{.type = JSON_NUMBER, .integer = 9223372036854775807, .isInteger = true,},{.type = JSON_NUMBER, .integer = -9223372036854775807 - 1, .isInteger = true,},{.type = JSON_NUMBER, .real = 9223372036854775808.0,},{.type = JSON_NUMBER, .real = 123456789012345678901234.0,},{.type = JSON_NUMBER, .real = 0.1,},{.type = JSON_NUMBER, .real = -2.5e-3,},{.type = JSON_NUMBER, .real = 1e22,},{.type = JSON_NUMBER, .real = 1e23,},{.type = JSON_NUMBER, .real = 1.7976931348623157e308,},{.type = JSON_NUMBER, .real = 4.9e-324,},{.type = JSON_NUMBER, .real = 0.30000000000000004,},{.type = JSON_NUMBER, .real = HUGE_VAL,},}, .len = 14,},
+            .expectedError = JSON_ERR_OK,
+        },
+        {
+            .inputData = tooDeep,
+            .expectedJson = NULL,
+            .expectedError = JSON_ERR_DEPTH_LIMIT,
+        },
     };
     int len = sizeof(testCases) / sizeof(testCases[0]);
     int passed = 0;
@@ -171,21 +212,133 @@ int main() {
 
 bool test(TestCase testCase, int number) {
     printf("Test #%d: ", number);
+    // Whole input at once, then fed to the parser one byte at a time, both
+    // with and without an arena, in situ and finally to a handler.
+    Arena arena;
+    arena_init(&arena);
+    bool success = testParse(testCase, 0, NULL, false) && testParse(testCase, 1, NULL, false) &&
+                   testParse(testCase, 0, &arena, false) && testParse(testCase, 1, &arena, false) &&
+                   testParse(testCase, 0, &arena, true) && testParseHandler(testCase, 0) &&
+                   testParseHandler(testCase, 1);
+    if (success)
+        printf("OK\n");
+    return success;
+}
+
+// testParse parses the input of the test case, feeding it to the parser in
+// chunks of given size, or using json_parse_arena if the size is 0. Arena may
+// be NULL, unless parsing a copy of the input in situ.
+bool testParse(TestCase testCase, size_t chunkSize, Arena *arena, bool inSitu) {
     Json json;
-    JsonParseError error = json_parse(&json, testCase.inputData);
+    JsonParseError error;
+    char *text = NULL;
+    if (inSitu) {
+        text = malloc(strlen(testCase.inputData) + 1);
+        strcpy(text, testCase.inputData);
+        error = json_parse_in_situ(&json, text, arena);
+    } else if (chunkSize == 0) {
+        error = json_parse_arena(&json, testCase.inputData, arena);
+    } else {
+        JsonParser parser;
+        json_parser_init_arena(&parser, &json, arena);
+        size_t len = strlen(testCase.inputData);
+        for (size_t i = 0; i < len; i += chunkSize) {
+            json_parser_feed(&parser, testCase.inputData + i, len - i < chunkSize ? len - i : chunkSize);
+        }
+        error = json_parser_finish(&parser);
+    }
     bool success = false;
     if (!jsonEquals(error == JSON_ERR_OK ? &json : NULL, testCase.expectedJson)) {
-        printf("Fail: Json not as expected\n");
+        printf("Fail: Json not as expected (chunk size %zu%s%s)\n", chunkSize, arena ? ", arena" : "",
+               inSitu ? ", in situ" : "");
     } else if (error != testCase.expectedError) {
-        printf("Fail: Wrong error! expected %d, got %d\n", testCase.expectedError, error);
+        printf("Fail: Wrong error! expected %d, got %d (chunk size %zu%s%s)\n", testCase.expectedError, error, chunkSize,
+               arena ? ", arena" : "", inSitu ? ", in situ" : "");
+    } else {
+        success = true;
+    }
+    if (arena)
+        arena_cleanup(arena);
+    else
+        json_cleanup(&json);
+    free(text);
+    return success;
+}
+
+// testParseHandler parses the input of the test case in handler mode, feeding
+// it in chunks of given size, or all at once if the size is 0.
+bool testParseHandler(TestCase testCase, size_t chunkSize) {
+    TreeBuilder builder = {.root = {.type = JSON_NULL}, .depth = 0, .key = NULL};
+    JsonHandler handler = {builderBegin, builderEnd, builderKey, builderValue, &builder};
+    JsonParser parser;
+    json_parser_init_handler(&parser, &handler);
+    size_t len = strlen(testCase.inputData);
+    if (!chunkSize)
+        chunkSize = len;
+    for (size_t i = 0; i < len; i += chunkSize) {
+        json_parser_feed(&parser, testCase.inputData + i, len - i < chunkSize ? len - i : chunkSize);
+    }
+    JsonParseError error = json_parser_finish(&parser);
+    bool success = false;
+    if (!jsonEquals(error == JSON_ERR_OK ? &builder.root : NULL, testCase.expectedJson)) {
+        printf("Fail: Json not as expected (chunk size %zu, handler)\n", chunkSize);
+    } else if (error != testCase.expectedError) {
+        printf("Fail: Wrong error! expected %d, got %d (chunk size %zu, handler)\n", testCase.expectedError, error,
+               chunkSize);
     } else {
-        printf("OK\n");
         success = true;
     }
-    json_cleanup(&json);
+    json_cleanup(&builder.root);
+    free(builder.key);
     return success;
 }
 
+// builderAdd returns the next value of the innermost container, or the root.
+Json *builderAdd(TreeBuilder *builder) {
+    if (!builder->depth)
+        return &builder->root;
+    Json *container = builder->stack[builder->depth - 1];
+    if (container->type == JSON_ARRAY) {
+        container->values = realloc(container->values, (container->len + 1) * sizeof(Json));
+        return &container->values[container->len++];
+    }
+    container->entries = realloc(container->entries, (container->len + 1) * sizeof(JsonObjectEntry));
+    JsonObjectEntry *entry = &container->entries[container->len++];
+    entry->key = (JsonString){.str = builder->key, .len = strlen(builder->key)};
+    builder->key = NULL;
+    return &entry->value;
+}
+
+bool builderBegin(void *data, JsonType type) {
+    TreeBuilder *builder = data;
+    Json *json = builderAdd(builder);
+    *json = (Json){.type = type, .values = NULL, .len = 0};
+    builder->stack[builder->depth++] = json;
+    return true;
+}
+
+bool builderEnd(void *data) {
+    --((TreeBuilder *)data)->depth;
+    return true;
+}
+
+bool builderKey(void *data, const char *key, JsonLength len) {
+    TreeBuilder *builder = data;
+    builder->key = malloc(len + 1);
+    memcpy(builder->key, key, len + 1);
+    return true;
+}
+
+bool builderValue(void *data, Json *value) {
+    Json *json = builderAdd(data);
+    *json = *value;
+    if (value->type == JSON_STRING) {
+        json->str = malloc(value->len + 1);
+        memcpy(json->str, value->str, value->len + 1);
+    }
+    return true;
+}
+
 bool approxEquals(double value, double other, double epsilon) {
     return fabs(value - other) < epsilon;
 }
@@ -201,36 +354,44 @@ bool jsonEquals(Json *a, Json *b) {
         return false;
     switch (a->type) {
         case JSON_OBJECT:
-            if (a->object.len != b->object.len) {
+            if (a->len != b->len) {
                 return false;
             }
-            for (JsonLength i = 0; i < a->object.len; ++i) {
+            for (JsonLength i = 0; i < a->len; ++i) {
                 bool found = false;
-                for (JsonLength j = 0; j < b->object.len && !found; ++j) {
-                    if (jsonStringEquals(&a->object.entries[i].key, &b->object.entries[j].key)) {
-                        if (jsonEquals(&a->object.entries[i].value, &b->object.entries[j].value)) {
+                for (JsonLength j = 0; j < b->len && !found; ++j) {
+                    if (jsonStringEquals(&a->entries[i].key, &b->entries[j].key)) {
+                        if (jsonEquals(&a->entries[i].value, &b->entries[j].value)) {
                             found = true;
                         }
                     }
                 }
                 if (!found)
                     return false;
+                // Looking the key up must give the same (first) value too.
+                const char *key = a->entries[i].key.str;
+                if (!jsonEquals(json_object_get(a, key), json_object_get(b, key)))
+                    return false;
             }
             return true;
         case JSON_ARRAY:
-            if (a->array.len != b->array.len) {
+            if (a->len != b->len) {
                 return false;
             }
-            for (JsonLength i = 0; i < a->array.len; ++i) {
-                if (!jsonEquals(&a->array.values[i], &b->array.values[i])) {
+            for (JsonLength i = 0; i < a->len; ++i) {
+                if (!jsonEquals(&a->values[i], &b->values[i])) {
                     return false;
                 }
             }
             return true;
         case JSON_STRING:
-            return jsonStringEquals(&a->string, &b->string);
+            return a->len == b->len && memcmp(a->str, b->str, a->len) == 0;
         case JSON_NUMBER:
-            return approxEquals(a->number, b->number, 1e-18);
+            if (a->isInteger != b->isInteger)
+                return false;
+            if (a->isInteger)
+                return a->integer == b->integer;
+            return a->real == b->real || approxEquals(a->real, b->real, 1e-18);
         case JSON_BOOLEAN:
             return a->boolean == b->boolean;
         case JSON_NULL:
@@ -0,0 +1,346 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Custom JSON parser (see json.h) benchmark. Run main to print the throughput
+ * of each way of parsing on a few generated documents, and of looking up keys
+ * of parsed objects.
+ *
+ * The json_parse and chunked columns malloc every object and array, so their
+ * speed depends on the heap left by earlier documents. Each row is therefore
+ * measured by running the benchmark again in its own process, with the name
+ * of the row as the argument.
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "json.h"
+
+// Total amount of input to parse for each measurement.
+#define BENCH_BYTES (64 * 1024 * 1024)
+#define BENCH_CHUNK_SIZE 4096
+// Number of key lookups for each measurement.
+#define BENCH_LOOKUPS (20 * 1000 * 1000)
+
+typedef enum BenchMode {
+    BENCH_PARSE,
+    BENCH_ARENA,
+    BENCH_IN_SITU,
+    BENCH_CHUNKED,
+    BENCH_MODE_COUNT,
+} BenchMode;
+
+const char *modeNames[BENCH_MODE_COUNT] = {"json_parse", "arena", "in situ", "chunked"};
+
+// Buffer is a growing string used to generate documents.
+typedef struct Buffer {
+    char *data;
+    size_t len, cap;
+} Buffer;
+
+// Names of the documents, one per row, see generate.
+const char *documentNames[] = {"small", "contents", "strings", "html", "numbers", "deep"};
+#define BENCH_DOCUMENT_COUNT (int)(sizeof(documentNames) / sizeof(documentNames[0]))
+#define BENCH_LOOKUP "lookup"
+
+void append(Buffer *buffer, const char *format, ...);
+char *generate(int document);
+char *generateSmall();
+char *generateContents(int modules);
+char *generateStrings(int count);
+char *generateHtml(int count);
+char *generateNumbers(int count);
+char *generateDeep(int depth, int count);
+char *generateModules(int count);
+double bench(const char *document, BenchMode mode);
+Json *linearGet(Json *json, const char *key);
+double benchLookup(Json *objects, bool indexed);
+void runRow(const char *name);
+void printRow(int document);
+void printLookup();
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        runRow(argv[1]);
+        return 0;
+    }
+    printf("%-10s %10s", "document", "size");
+    for (int mode = 0; mode < BENCH_MODE_COUNT; ++mode)
+        printf(" %12s", modeNames[mode]);
+    printf("\n");
+    // Output of the processes must not be mixed with buffered output.
+    fflush(stdout);
+    for (int i = 0; i <= BENCH_DOCUMENT_COUNT; ++i) {
+        const char *name = i < BENCH_DOCUMENT_COUNT ? documentNames[i] : BENCH_LOOKUP;
+        char *command = malloc(strlen(argv[0]) + strlen(name) + 4);
+        if (!command)
+            return 1;
+        sprintf(command, "\"%s\" %s", argv[0], name);
+        if (system(command))
+            printf("%-10s %10s\n", name, "error");
+        fflush(stdout);
+        free(command);
+    }
+}
+
+// runRow prints the row of given name, in a process of its own.
+void runRow(const char *name) {
+    for (int i = 0; i < BENCH_DOCUMENT_COUNT; ++i) {
+        if (!strcmp(name, documentNames[i]))
+            printRow(i);
+    }
+    if (!strcmp(name, BENCH_LOOKUP))
+        printLookup();
+}
+
+void printRow(int document) {
+    char *text = generate(document);
+    printf("%-10s %10zu", documentNames[document], strlen(text));
+    for (int mode = 0; mode < BENCH_MODE_COUNT; ++mode) {
+        double speed = bench(text, mode);
+        if (speed < 0)
+            printf(" %12s", "error");
+        else
+            printf(" %7.1f MB/s", speed);
+    }
+    printf("\n");
+    free(text);
+}
+
+void printLookup() {
+    char *modules = generateModules(1000);
+    Json json;
+    if (json_parse(&json, modules) == JSON_ERR_OK) {
+        printf("\n%-10s %10s %12s\n", "lookup", "", "Mlookups/s");
+        printf("%-21s %12.1f\n", "linear", benchLookup(&json, false));
+        printf("%-21s %12.1f\n", "json_object_get", benchLookup(&json, true));
+        json_cleanup(&json);
+    }
+    free(modules);
+}
+
+// generate generates the document of given index in documentNames.
+char *generate(int document) {
+    switch (document) {
+        case 0:
+            return generateSmall();
+        case 1:
+            return generateContents(20000);
+        case 2:
+            return generateStrings(50000);
+        case 3:
+            return generateHtml(2000);
+        case 4:
+            return generateNumbers(200000);
+        default:
+            return generateDeep(JSON_DEFAULT_MAX_DEPTH - 1, 200);
+    }
+}
+
+// linearGet finds the key by comparing it to every key of the object, as
+// objects used to be searched before they had an index.
+Json *linearGet(Json *json, const char *key) {
+    if (json->type != JSON_OBJECT)
+        return NULL;
+    for (JsonLength i = 0; i < json->len; ++i) {
+        if (strcmp(json->entries[i].key.str, key) == 0)
+            return &json->entries[i].value;
+    }
+    return NULL;
+}
+
+// benchLookup looks up the keys read from modules (see generateModules) in
+// each of the array of objects and returns millions of lookups per second.
+double benchLookup(Json *objects, bool indexed) {
+    const char *keys[] = {"uservisible", "modname", "name", "id", "instance", "description", "contents", "url"};
+    int keyCount = sizeof(keys) / sizeof(keys[0]);
+    long rounds = BENCH_LOOKUPS / (objects->len * keyCount) + 1, found = 0;
+    clock_t start = clock();
+    for (long i = 0; i < rounds; ++i) {
+        for (JsonLength j = 0; j < objects->len; ++j) {
+            for (int k = 0; k < keyCount; ++k) {
+                Json *object = &objects->values[j];
+                found += (indexed ? json_object_get(object, keys[k]) : linearGet(object, keys[k])) != NULL;
+            }
+        }
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    if (found != rounds * objects->len * keyCount)
+        return -1;
+    return found / 1e6 / (seconds > 0 ? seconds : 1e-9);
+}
+
+// bench parses the document repeatedly using given mode and returns the
+// throughput in MB/s, or a negative value if parsing failed.
+double bench(const char *document, BenchMode mode) {
+    size_t len = strlen(document);
+    long rounds = BENCH_BYTES / len + 1;
+    char *text = malloc(len + 1);
+    Arena arena;
+    arena_init(&arena);
+    bool failed = false;
+    clock_t start = clock();
+    for (long i = 0; i < rounds && !failed; ++i) {
+        Json json;
+        JsonParser parser;
+        // The in situ parser needs a fresh copy, which is measured too.
+        if (mode == BENCH_IN_SITU)
+            memcpy(text, document, len + 1);
+        switch (mode) {
+            case BENCH_PARSE:
+                failed = json_parse(&json, document) != JSON_ERR_OK;
+                json_cleanup(&json);
+                break;
+            case BENCH_ARENA:
+                failed = json_parse_arena(&json, document, &arena) != JSON_ERR_OK;
+                arena_cleanup(&arena);
+                break;
+            case BENCH_IN_SITU:
+                failed = json_parse_in_situ(&json, text, &arena) != JSON_ERR_OK;
+                arena_cleanup(&arena);
+                break;
+            default:
+                json_parser_init(&parser, &json);
+                for (size_t offset = 0; offset < len; offset += BENCH_CHUNK_SIZE) {
+                    size_t size = len - offset < BENCH_CHUNK_SIZE ? len - offset : BENCH_CHUNK_SIZE;
+                    json_parser_feed(&parser, document + offset, size);
+                }
+                failed = json_parser_finish(&parser) != JSON_ERR_OK;
+                json_cleanup(&json);
+                break;
+        }
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    free(text);
+    if (failed)
+        return -1;
+    return (double)len * rounds / (1024 * 1024) / (seconds > 0 ? seconds : 1e-9);
+}
+
+void append(Buffer *buffer, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (buffer->len + len + 1 > buffer->cap) {
+        buffer->cap = (buffer->len + len + 1) * 2;
+        buffer->data = realloc(buffer->data, buffer->cap);
+        if (!buffer->data) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+    }
+    va_start(args, format);
+    vsnprintf(buffer->data + buffer->len, len + 1, format, args);
+    va_end(args);
+    buffer->len += len;
+}
+
+// generateSmall generates a small object, like most of the test cases.
+char *generateSmall() {
+    Buffer buffer = {NULL, 0, 0};
+    append(&buffer, "{\"id\":12,\"name\":\"Course\",\"visible\":true,\"summary\":null,\"format\":[1,2.5e3,-0.25]}");
+    return buffer.data;
+}
+
+// generateContents generates a document shaped like the response of
+// core_course_get_contents.
+char *generateContents(int modules) {
+    Buffer buffer = {NULL, 0, 0};
+    append(&buffer, "[");
+    for (int i = 0; i < modules; ++i) {
+        append(&buffer,
+               "%s{\"id\":%d,\"url\":\"https:\\/\\/moodle.example.com\\/mod\\/resource\\/view.php?id=%d\","
+               "\"name\":\"Lecture %d slides\",\"instance\":%d,\"visible\":1,\"uservisible\":true,"
+               "\"description\":\"<p>Slides of the lecture, see \\\"Reading\\\" for more.<\\/p>\","
+               "\"modname\":\"resource\",\"completion\":0,\"noviewlink\":false,\"availability\":null,"
+               "\"contents\":[{\"type\":\"file\",\"filename\":\"lecture%d.pdf\",\"filesize\":%d,"
+               "\"timemodified\":%d,\"sortorder\":0,\"isexternalfile\":false}]}",
+               i ? "," : "", 1000 + i, 1000 + i, i, 500 + i, i, 123456 + i * 7, 1600000000 + i);
+    }
+    append(&buffer, "]");
+    return buffer.data;
+}
+
+// generateStrings generates an array of strings with escapes.
+char *generateStrings(int count) {
+    Buffer buffer = {NULL, 0, 0};
+    append(&buffer, "[");
+    for (int i = 0; i < count; ++i) {
+        append(&buffer, "%s\"Line %d\\nTab\\tQuote\\\" \\u00e9\\u0105 and some longer plain text after it\"", i ? "," : "",
+               i);
+    }
+    append(&buffer, "]");
+    return buffer.data;
+}
+
+// generateHtml generates an array of objects with long html summaries, like
+// the ones of courses and sections.
+char *generateHtml(int count) {
+    Buffer buffer = {NULL, 0, 0};
+    append(&buffer, "[");
+    for (int i = 0; i < count; ++i) {
+        append(&buffer, "%s{\"id\":%d,\"summary\":\"<div class=\\\"summary\\\">", i ? "," : "", i);
+        for (int j = 0; j < 8; ++j) {
+            append(&buffer, "<p>Paragraph %d of the section. The lectures take place every week in the main hall, while "
+                            "the exercises are held in smaller groups, see the timetable for details.<\\/p>",
+                   j);
+        }
+        append(&buffer, "<\\/div>\",\"summaryformat\":1}");
+    }
+    append(&buffer, "]");
+    return buffer.data;
+}
+
+// generateNumbers generates an array of integer and real numbers.
+char *generateNumbers(int count) {
+    Buffer buffer = {NULL, 0, 0};
+    append(&buffer, "[");
+    for (int i = 0; i < count; ++i) {
+        if (i % 2)
+            append(&buffer, ",%d", i * 37);
+        else
+            append(&buffer, "%s-%d.%de-3", i ? "," : "", i * 37, i % 1000);
+    }
+    append(&buffer, "]");
+    return buffer.data;
+}
+
+// generateDeep generates an array of count arrays nested depth levels deep.
+char *generateDeep(int depth, int count) {
+    Buffer buffer = {NULL, 0, 0};
+    append(&buffer, "[");
+    for (int i = 0; i < count; ++i) {
+        if (i)
+            append(&buffer, ",");
+        for (int j = 1; j < depth; ++j)
+            append(&buffer, "[");
+        append(&buffer, "%d", i);
+        for (int j = 1; j < depth; ++j)
+            append(&buffer, "]");
+    }
+    append(&buffer, "]");
+    return buffer.data;
+}
+
+// generateModules generates an array of modules with all the keys returned by
+// recent versions of moodle.
+char *generateModules(int count) {
+    Buffer buffer = {NULL, 0, 0};
+    append(&buffer, "[");
+    for (int i = 0; i < count; ++i) {
+        append(&buffer,
+               "%s{\"id\":%d,\"url\":\"https:\\/\\/moodle.example.com\\/mod\\/resource\\/view.php?id=%d\","
+               "\"name\":\"Lecture %d slides\",\"instance\":%d,\"contextid\":%d,\"description\":\"<p>Slides<\\/p>\","
+               "\"visible\":1,\"uservisible\":true,\"visibleoncoursepage\":1,\"modicon\":\"icon.svg\","
+               "\"modname\":\"resource\",\"modplural\":\"Files\",\"availability\":null,\"indent\":0,"
+               "\"onclick\":\"\",\"afterlink\":null,\"customdata\":\"\\\"\\\"\",\"noviewlink\":false,"
+               "\"completion\":0,\"downloadcontent\":1,\"dates\":[],\"contents\":[],\"contentsinfo\":{}}",
+               i ? "," : "", 1000 + i, 1000 + i, i, 500 + i, 2000 + i);
+    }
+    append(&buffer, "]");
+    return buffer.data;
+}
@@ -0,0 +1,191 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * See thread.h
+ */
+
+#if defined(_WIN32)
+#define PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include <stdlib.h>
+#include "thread.h"
+
+// Thread holds the function and argument until the thread starts.
+typedef struct Thread {
+#ifdef PLATFORM_WINDOWS
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    ThreadFunc func;
+    void *arg;
+} Thread;
+
+#ifdef PLATFORM_WINDOWS
+static DWORD WINAPI th_start(LPVOID data) {
+    Thread *thread = data;
+    thread->func(thread->arg);
+    return 0;
+}
+#else
+static void *th_start(void *data) {
+    Thread *thread = data;
+    thread->func(thread->arg);
+    return NULL;
+}
+#endif
+
+void *th_create(ThreadFunc func, void *arg) {
+    Thread *thread = malloc(sizeof(Thread));
+    if (!thread)
+        return NULL;
+    thread->func = func;
+    thread->arg = arg;
+#ifdef PLATFORM_WINDOWS
+    thread->handle = CreateThread(NULL, 0, th_start, thread, 0, NULL);
+    if (!thread->handle) {
+#else
+    if (pthread_create(&thread->handle, NULL, th_start, thread)) {
+#endif
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void th_join(void *data) {
+    Thread *thread = data;
+#ifdef PLATFORM_WINDOWS
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+    free(thread);
+}
+
+void th_sleep(int milliseconds) {
+#ifdef PLATFORM_WINDOWS
+    Sleep(milliseconds);
+#else
+    struct timespec duration = {
+        .tv_sec = milliseconds / 1000,
+        .tv_nsec = (milliseconds % 1000) * 1000000L,
+    };
+    nanosleep(&duration, NULL);
+#endif
+}
+
+long long th_clock() {
+#ifdef PLATFORM_WINDOWS
+    return GetTickCount64();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+}
+
+int th_cpu_count() {
+#ifdef PLATFORM_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = info.dwNumberOfProcessors;
+#else
+    int count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count < 1 ? 1 : count;
+}
+
+void *th_mutex_new() {
+#ifdef PLATFORM_WINDOWS
+    CRITICAL_SECTION *mutex = malloc(sizeof(CRITICAL_SECTION));
+    if (mutex)
+        InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_t *mutex = malloc(sizeof(pthread_mutex_t));
+    if (mutex && pthread_mutex_init(mutex, NULL)) {
+        free(mutex);
+        mutex = NULL;
+    }
+#endif
+    return mutex;
+}
+
+void th_mutex_free(void *mutex) {
+#ifdef PLATFORM_WINDOWS
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+    free(mutex);
+}
+
+void th_mutex_lock(void *mutex) {
+#ifdef PLATFORM_WINDOWS
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void th_mutex_unlock(void *mutex) {
+#ifdef PLATFORM_WINDOWS
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+void *th_cond_new() {
+#ifdef PLATFORM_WINDOWS
+    CONDITION_VARIABLE *cond = malloc(sizeof(CONDITION_VARIABLE));
+    if (cond)
+        InitializeConditionVariable(cond);
+#else
+    pthread_cond_t *cond = malloc(sizeof(pthread_cond_t));
+    if (cond && pthread_cond_init(cond, NULL)) {
+        free(cond);
+        cond = NULL;
+    }
+#endif
+    return cond;
+}
+
+void th_cond_free(void *cond) {
+#ifndef PLATFORM_WINDOWS
+    pthread_cond_destroy(cond);
+#endif
+    free(cond);
+}
+
+void th_cond_wait(void *cond, void *mutex, int milliseconds) {
+#ifdef PLATFORM_WINDOWS
+    SleepConditionVariableCS(cond, mutex, milliseconds);
+#else
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += milliseconds / 1000;
+    deadline.tv_nsec += (milliseconds % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(cond, mutex, &deadline);
+#endif
+}
+
+void th_cond_signal(void *cond) {
+#ifdef PLATFORM_WINDOWS
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
@@ -0,0 +1,57 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * A super simple wrapper library for threads, mutexes and condition variables
+ * using POSIX and Win32 api.
+ */
+
+#ifndef __THREAD_H
+#define __THREAD_H
+
+// ThreadFunc is the function executed by a thread.
+typedef void (*ThreadFunc)(void *arg);
+
+// th_create starts a new thread executing func with given arg, returning
+// handle or NULL. The handle must be released by the caller using th_join.
+void *th_create(ThreadFunc func, void *arg);
+
+// th_join waits for a thread created with th_create to finish and releases it.
+void th_join(void *thread);
+
+// th_sleep suspends the calling thread for given number of milliseconds.
+void th_sleep(int milliseconds);
+
+// th_clock returns the time in milliseconds since an unspecified point, which
+// is not affected by changes of the system time.
+long long th_clock();
+
+// th_cpu_count returns the number of processors available, at least 1.
+int th_cpu_count();
+
+// th_mutex_new creates a new mutex, returning handle or NULL. The handle should
+// be freed by the caller using th_mutex_free.
+void *th_mutex_new();
+
+// th_mutex_free frees a mutex created with th_mutex_new.
+void th_mutex_free(void *mutex);
+
+void th_mutex_lock(void *mutex);
+void th_mutex_unlock(void *mutex);
+
+// th_cond_new creates a new condition variable, returning handle or NULL. The
+// handle should be freed by the caller using th_cond_free.
+void *th_cond_new();
+
+// th_cond_free frees a condition variable created with th_cond_new.
+void th_cond_free(void *cond);
+
+// th_cond_wait releases locked mutex and waits until the condition variable is
+// signaled or given number of milliseconds pass. The mutex is locked again
+// before returning. Like with any condition variable, spurious wakeups are
+// possible.
+void th_cond_wait(void *cond, void *mutex, int milliseconds);
+
+// th_cond_signal wakes up all the threads waiting on the condition variable.
+void th_cond_signal(void *cond);
+
+#endif
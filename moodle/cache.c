@@ -0,0 +1,387 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Part of moodle library (conditional http response cache). See moodle.h
+ *
+ * Responses carrying ETag or Last-Modified validators are kept on disk, one
+ * file per request url (with the token left out), named after a hash of the
+ * url. When the same url is requested again, the validators are sent with
+ * If-None-Match and If-Modified-Since, and if the server answers 304 Not
+ * Modified the body is taken from disk instead. Cached bodies are never used
+ * without the server confirming that they are still valid.
+ *
+ * Each file consists of a header line with format version, the url, both
+ * validators (empty if missing), each followed by a new line, and the body.
+ *
+ * When the folder is set, the oldest files are removed while all of them take
+ * more than MD_HTTP_CACHE_MAX_SIZE, so the cache doesn't grow without bound.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200809L
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#include <curl/curl.h>
+#include <ctype.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmap.h"
+#include "internal.h"
+
+#define MD_HTTP_CACHE_MAGIC "MOOTHTTP 1"
+// Smaller responses are not worth a round trip to disk. This also keeps out
+// most responses of requests that change every time, such as asking for
+// updates since the last sync.
+#define MD_HTTP_CACHE_MIN_SIZE 1024
+#define MD_HTTP_NOT_MODIFIED 304
+#define MD_HTTP_OK 200
+// MD_HTTP_CACHE_MAX_SIZE is the total size in bytes of cached files kept when
+// the cache folder is set.
+#define MD_HTTP_CACHE_MAX_SIZE (64LL * 1024 * 1024)
+#define MD_HTTP_CACHE_NAME_LENGTH 16
+
+// MDHttpCacheFile is a file found in the cache folder.
+typedef struct MDHttpCacheFile {
+    char *path;
+    long long size;
+    long long modified;  // only used to order the files.
+} MDHttpCacheFile;
+
+static char *cacheFolder = NULL;
+static atomic_long cacheHits, cacheMisses;
+
+static void md_http_cache_evict(void);
+
+void md_http_cache_set_folder(cchar *folder, MDError *error) {
+    *error = MD_ERR_NONE;
+    free(cacheFolder);
+    cacheFolder = folder ? clone_str(folder, error) : NULL;
+    if (cacheFolder)
+        md_http_cache_evict();
+}
+
+MDHttpCacheStats md_http_cache_get_stats() {
+    return (MDHttpCacheStats){atomic_load(&cacheHits), atomic_load(&cacheMisses)};
+}
+
+// md_http_cache_key returns allocated copy of url without the values of token
+// parameters, so that tokens don't end up on disk.
+static char *md_http_cache_key(cchar *url, MDError *error) {
+    char *key = clone_str(url, error);
+    if (!key)
+        return NULL;
+    for (char *param = strchr(key, '?'); param; param = strchr(param + 1, '&')) {
+        char *name = param + 1, *end = name + strcspn(name, "&");
+        if (!strncmp(name, "wstoken=", 8) || !strncmp(name, "token=", 6)) {
+            char *value = strchr(name, '=') + 1;
+            memmove(value, end, strlen(end) + 1);
+        }
+    }
+    return key;
+}
+
+// md_http_cache_path returns allocated path of the file for given key, named
+// after its 64 bit FNV-1a hash.
+static char *md_http_cache_path(cchar *key, MDError *error) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (cchar *c = key; *c; ++c) {
+        hash ^= (unsigned char)*c;
+        hash *= 1099511628211ULL;
+    }
+    char *path = md_malloc(strlen(cacheFolder) + 18, error);
+    if (path)
+        sprintf(path, "%s/%016llx", cacheFolder, hash);
+    return path;
+}
+
+// md_http_cache_is_file_name returns true if name is that of a cached response
+// (see md_http_cache_path), or of a temporary file left while storing one.
+static bool md_http_cache_is_file_name(cchar *name) {
+    return strspn(name, "0123456789abcdef") == MD_HTTP_CACHE_NAME_LENGTH &&
+           (!name[MD_HTTP_CACHE_NAME_LENGTH] || !strcmp(name + MD_HTTP_CACHE_NAME_LENGTH, ".tmp"));
+}
+
+// md_http_cache_add_file appends the file of given name in the cache folder to
+// files, returning false on failure.
+static bool md_http_cache_add_file(MDHttpCacheFile **files, int *count, int *capacity, cchar *name,
+                                   long long size, long long modified) {
+    if (*count == *capacity) {
+        int newCapacity = *capacity ? *capacity * 2 : 64;
+        MDHttpCacheFile *newFiles = realloc(*files, newCapacity * sizeof(MDHttpCacheFile));
+        if (!newFiles)
+            return false;
+        *files = newFiles;
+        *capacity = newCapacity;
+    }
+    char *path = malloc(strlen(cacheFolder) + strlen(name) + 2);
+    if (!path)
+        return false;
+    sprintf(path, "%s/%s", cacheFolder, name);
+    (*files)[(*count)++] = (MDHttpCacheFile){.path = path, .size = size, .modified = modified};
+    return true;
+}
+
+// md_http_cache_list_files returns allocated array of the files in the cache
+// folder, setting count to their number, or NULL if they can't be listed.
+static MDHttpCacheFile *md_http_cache_list_files(int *count) {
+    MDHttpCacheFile *files = NULL;
+    int capacity = 0;
+    bool ok = true;
+    *count = 0;
+#ifdef _WIN32
+    char *pattern = malloc(strlen(cacheFolder) + 3);
+    if (!pattern)
+        return NULL;
+    sprintf(pattern, "%s/*", cacheFolder);
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    free(pattern);
+    if (find == INVALID_HANDLE_VALUE)
+        return NULL;
+    do {
+        if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && md_http_cache_is_file_name(data.cFileName)) {
+            long long size = (long long)data.nFileSizeHigh << 32 | data.nFileSizeLow;
+            long long modified = (long long)data.ftLastWriteTime.dwHighDateTime << 32 | data.ftLastWriteTime.dwLowDateTime;
+            ok = md_http_cache_add_file(&files, count, &capacity, data.cFileName, size, modified);
+        }
+    } while (ok && FindNextFileA(find, &data));
+    FindClose(find);
+#else
+    DIR *dir = opendir(cacheFolder);
+    if (!dir)
+        return NULL;
+    for (struct dirent *item = readdir(dir); item && ok; item = readdir(dir)) {
+        if (!md_http_cache_is_file_name(item->d_name))
+            continue;
+        ok = md_http_cache_add_file(&files, count, &capacity, item->d_name, 0, 0);
+        struct stat info;
+        if (ok && !stat(files[*count - 1].path, &info) && S_ISREG(info.st_mode)) {
+            files[*count - 1].size = info.st_size;
+            files[*count - 1].modified = info.st_mtime;
+        } else if (ok) {
+            free(files[--*count].path);
+        }
+    }
+    closedir(dir);
+#endif
+    if (!ok) {
+        for (int i = 0; i < *count; ++i)
+            free(files[i].path);
+        free(files);
+        return NULL;
+    }
+    return files;
+}
+
+static int md_http_cache_compare_files(const void *a, const void *b) {
+    const MDHttpCacheFile *fileA = a, *fileB = b;
+    return (fileA->modified > fileB->modified) - (fileA->modified < fileB->modified);
+}
+
+// md_http_cache_evict removes the least recently stored files from the cache
+// folder until the rest fit in MD_HTTP_CACHE_MAX_SIZE. Failures are ignored,
+// as the cache is not essential.
+static void md_http_cache_evict(void) {
+    int count;
+    MDHttpCacheFile *files = md_http_cache_list_files(&count);
+    if (!files)
+        return;
+    long long total = 0;
+    for (int i = 0; i < count; ++i)
+        total += files[i].size;
+    qsort(files, count, sizeof(MDHttpCacheFile), md_http_cache_compare_files);
+    for (int i = 0; i < count && total > MD_HTTP_CACHE_MAX_SIZE; ++i) {
+        if (!remove(files[i].path))
+            total -= files[i].size;
+    }
+    for (int i = 0; i < count; ++i)
+        free(files[i].path);
+    free(files);
+}
+
+// md_http_cache_read_line returns allocated copy of the next line of the map
+// starting at *it and moves *it past it. NULL is returned if no line is left.
+static char *md_http_cache_read_line(FMap *map, size_t *it) {
+    cchar *start = map->data + *it, *end = memchr(start, '\n', map->size - *it);
+    if (!end)
+        return NULL;
+    char *line = malloc(end - start + 1);
+    if (line) {
+        memcpy(line, start, end - start);
+        line[end - start] = '\0';
+        *it += end - start + 1;
+    }
+    return line;
+}
+
+// md_http_cache_load maps the file of the entry and reads its validators.
+// Missing, broken or colliding entries are ignored.
+static void md_http_cache_load(MDHttpCacheEntry *entry) {
+    if (!fmap_open(&entry->map, entry->path))
+        return;
+    size_t it = 0;
+    char *magic = md_http_cache_read_line(&entry->map, &it);
+    char *key = md_http_cache_read_line(&entry->map, &it);
+    entry->etag = md_http_cache_read_line(&entry->map, &it);
+    entry->lastModified = md_http_cache_read_line(&entry->map, &it);
+    if (!magic || !key || !entry->etag || !entry->lastModified || strcmp(magic, MD_HTTP_CACHE_MAGIC) ||
+        strcmp(key, entry->key)) {
+        fmap_close(&entry->map);
+        free(entry->etag);
+        free(entry->lastModified);
+        entry->etag = entry->lastModified = NULL;
+    } else {
+        entry->bodyOffset = it;
+    }
+    free(magic);
+    free(key);
+}
+
+// md_http_cache_add_header appends header "name: value" to the list of the
+// entry, if the value is not empty.
+static void md_http_cache_add_header(MDHttpCacheEntry *entry, cchar *name, cchar *value) {
+    if (!value || !*value)
+        return;
+    char *header = malloc(strlen(name) + strlen(value) + 3);
+    if (header) {
+        sprintf(header, "%s: %s", name, value);
+        struct curl_slist *headers = curl_slist_append(entry->headers, header);
+        if (headers)
+            entry->headers = headers;
+        free(header);
+    }
+}
+
+// md_http_cache_read_header sets *value to the trimmed value of the header in
+// buffer, if it's named name (compared case insensitively).
+static void md_http_cache_read_header(cchar *buffer, size_t length, cchar *name, char **value) {
+    size_t nameLength = strlen(name);
+    if (length <= nameLength || buffer[nameLength] != ':')
+        return;
+    for (size_t i = 0; i < nameLength; ++i) {
+        if (tolower((unsigned char)buffer[i]) != name[i])
+            return;
+    }
+    cchar *start = buffer + nameLength + 1, *end = buffer + length;
+    while (start < end && isspace((unsigned char)*start))
+        ++start;
+    while (end > start && isspace((unsigned char)end[-1]))
+        --end;
+    free(*value);
+    *value = malloc(end - start + 1);
+    if (*value) {
+        memcpy(*value, start, end - start);
+        (*value)[end - start] = '\0';
+    }
+}
+
+static size_t md_http_cache_header_callback(char *buffer, size_t size, size_t nitems, void *userdata) {
+    size_t length = size * nitems;
+    MDHttpCacheEntry *entry = (MDHttpCacheEntry *)userdata;
+    if (length >= 5 && !memcmp(buffer, "HTTP/", 5)) {
+        // Headers of every response are received when redirects are
+        // followed, only the last ones matter.
+        free(entry->receivedEtag);
+        free(entry->receivedLastModified);
+        entry->receivedEtag = entry->receivedLastModified = NULL;
+        entry->chunk->keep = !entry->chunk->parser;
+    } else {
+        md_http_cache_read_header(buffer, length, "etag", &entry->receivedEtag);
+        md_http_cache_read_header(buffer, length, "last-modified", &entry->receivedLastModified);
+        // Parsed responses are only kept in memory if they can be cached.
+        if (entry->receivedEtag || entry->receivedLastModified)
+            entry->chunk->keep = true;
+    }
+    return length;
+}
+
+// md_http_cache_store writes the received response of the entry to its file.
+// Failures are ignored, as the cache is not essential.
+static void md_http_cache_store(MDHttpCacheEntry *entry) {
+    // The cached file may be replaced below, so it's not needed anymore.
+    fmap_close(&entry->map);
+    char *tmpPath = malloc(strlen(entry->path) + 5);
+    if (!tmpPath)
+        return;
+    sprintf(tmpPath, "%s.tmp", entry->path);
+    FILE *file = md_open_private_file(tmpPath);
+    if (file) {
+        fprintf(file, "%s\n%s\n%s\n%s\n", MD_HTTP_CACHE_MAGIC, entry->key, entry->receivedEtag ? entry->receivedEtag : "",
+                entry->receivedLastModified ? entry->receivedLastModified : "");
+        fwrite(entry->chunk->memory, 1, entry->chunk->size, file);
+        bool failed = ferror(file);
+        failed = fclose(file) || failed;
+#ifdef _WIN32
+        // Rename does not replace existing files on windows.
+        if (!failed)
+            remove(entry->path);
+#endif
+        if (failed || rename(tmpPath, entry->path))
+            remove(tmpPath);
+    }
+    free(tmpPath);
+}
+
+void md_http_cache_prepare(MDHttpCacheEntry *entry, void *handle, cchar *url, Memblock *chunk) {
+    memset(entry, 0, sizeof(MDHttpCacheEntry));
+    entry->chunk = chunk;
+    if (!cacheFolder)
+        return;
+
+    // The cache is not essential, so it's silently disabled for this request
+    // on any failure.
+    MDError error = MD_ERR_NONE;
+    entry->key = md_http_cache_key(url, &error);
+    if (!error)
+        entry->path = md_http_cache_path(entry->key, &error);
+    if (error) {
+        md_http_cache_entry_cleanup(entry);
+        return;
+    }
+    md_http_cache_load(entry);
+    md_http_cache_add_header(entry, "If-None-Match", entry->etag);
+    md_http_cache_add_header(entry, "If-Modified-Since", entry->lastModified);
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, entry->headers);
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, md_http_cache_header_callback);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, entry);
+}
+
+void md_http_cache_finish(MDHttpCacheEntry *entry, void *handle) {
+    if (!entry->path)
+        return;
+    long code = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &code);
+    if (code == MD_HTTP_NOT_MODIFIED && entry->map.data) {
+        // The cached body is received as if it came from the server, so that
+        // it gets parsed in the same way.
+        entry->chunk->keep = !entry->chunk->parser;
+        write_memblock_callback((void *)(entry->map.data + entry->bodyOffset), 1, entry->map.size - entry->bodyOffset,
+                                entry->chunk);
+        atomic_fetch_add(&cacheHits, 1);
+    } else {
+        atomic_fetch_add(&cacheMisses, 1);
+        if (code == MD_HTTP_OK && entry->chunk->size >= MD_HTTP_CACHE_MIN_SIZE &&
+            (entry->receivedEtag || entry->receivedLastModified))
+            md_http_cache_store(entry);
+    }
+}
+
+void md_http_cache_entry_cleanup(MDHttpCacheEntry *entry) {
+    fmap_close(&entry->map);
+    curl_slist_free_all(entry->headers);
+    free(entry->key);
+    free(entry->path);
+    free(entry->etag);
+    free(entry->lastModified);
+    free(entry->receivedEtag);
+    free(entry->receivedLastModified);
+    entry->headers = NULL;
+    entry->key = entry->path = entry->etag = entry->lastModified = NULL;
+    entry->receivedEtag = entry->receivedLastModified = NULL;
+}
@@ -8,6 +8,7 @@
 #include <curl/curl.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,7 +20,6 @@
 #define MD_PARAM_JSON "moodlewsrestformat=json"
 #define MD_WSTOKEN "wstoken"
 #define MD_WSFUNCTION "wsfunction"
-#define MD_URL_LENGTH 4096
 #define MD_NO_IDENTIFIER -1
 #define MD_NO_ITEM_ID 0
 
@@ -28,47 +28,190 @@
 #define MD_CLIENT_STRING_FIELDS(client) \
     { &client->fullName, &client->siteName, &client->token, &client->website }
 
+// MD_MODULE_DATA_FIELDS expands to the fields identifying the module of
+// MDModuleData, with the key of module id (cmid or coursemodule).
+#define MD_MODULE_DATA_FIELDS(moduleIdKey)                                  \
+    {"course", MD_JSON_INT, offsetof(MDModuleData, courseId), true},        \
+        {moduleIdKey, MD_JSON_INT, offsetof(MDModuleData, moduleId), true}, \
+        {"id", MD_JSON_INT, offsetof(MDModuleData, instance), true}
+// MD_MODULE_CONTENTS returns the offset of a member of module contents in
+// MDModuleData.
+#define MD_MODULE_CONTENTS(member) offsetof(MDModuleData, module.contents.member)
+
+static bool md_module_set_visible(void *module, Json *value, MDError *error);
+static bool md_module_set_type(void *module, Json *value, MDError *error);
+static void md_module_drop(MDModule *module);
+static void md_mod_assignment_data_init(MDModuleData *data);
+static void md_mod_workshop_data_init(MDModuleData *data);
+static void md_mod_resource_data_init(MDModuleData *data);
+static void md_mod_url_data_init(MDModuleData *data);
+static void md_module_data_cleanup(MDModuleData *data);
+static bool md_mod_assignment_config_finish(MDModuleData *data, MDClient *client, MDError *error);
+static bool md_mod_workshop_data_finish(MDModuleData *data, MDClient *client, MDError *error);
+
+// Schemas of the responses decoded by md_courses_fetch_topic_contents (see
+// decode.c). Data of each module type is decoded using the dataSchema of its
+// entry in mdModList.
+
+static const MDJsonField mdFileFields[] = {
+    {"filename", MD_JSON_STRING, offsetof(MDFile, filename), true},
+    {"filesize", MD_JSON_LONG, offsetof(MDFile, filesize), true},
+    {"fileurl", MD_JSON_STRING, offsetof(MDFile, url), true},
+    {"timemodified", MD_JSON_TIME, offsetof(MDFile, timeModified), false},
+};
+static const MDJsonSchema mdFileSchema = MD_JSON_SCHEMA(MDFile, md_file_init, md_file_cleanup, NULL, mdFileFields);
+
+static const MDJsonField mdModuleFields[] = {
+    {"uservisible", MD_JSON_CUSTOM, 0, true, NULL, md_module_set_visible},
+    {"modname", MD_JSON_CUSTOM, 0, true, NULL, md_module_set_type},
+    {"name", MD_JSON_STRING, offsetof(MDModule, name), true},
+    {"id", MD_JSON_INT, offsetof(MDModule, id), true},
+    {"instance", MD_JSON_INT, offsetof(MDModule, instance), true},
+};
+static const MDJsonSchema mdModuleSchema = MD_JSON_SCHEMA(MDModule, md_module_init, md_module_drop, NULL, mdModuleFields);
+
+static const MDJsonField mdTopicFields[] = {
+    {"id", MD_JSON_INT, offsetof(MDTopic, id), true},
+    {"name", MD_JSON_STRING, offsetof(MDTopic, name), true},
+    {"summary", MD_JSON_STRING, offsetof(MDTopic, summary.text), true},
+    {"summaryformat", MD_JSON_INT, offsetof(MDTopic, summary.format), true},
+    {"modules", MD_JSON_ARRAY, offsetof(MDTopic, modules), true, &mdModuleSchema},
+};
+static const MDJsonSchema mdTopicSchema = MD_JSON_SCHEMA(MDTopic, md_topic_init, md_topic_cleanup, NULL, mdTopicFields);
+
+static const MDJsonField mdAssignmentConfigFields[] = {
+    {"plugin", MD_JSON_STRING, offsetof(MDModuleData, configPlugin), true},
+    {"name", MD_JSON_STRING, offsetof(MDModuleData, configName), true},
+    {"value", MD_JSON_STRING, offsetof(MDModuleData, configValue), true},
+};
+static const MDJsonSchema mdAssignmentConfigSchema =
+    MD_JSON_SCHEMA(MDModuleData, NULL, NULL, md_mod_assignment_config_finish, mdAssignmentConfigFields);
+
+static const MDJsonField mdAssignmentFields[] = {
+    MD_MODULE_DATA_FIELDS("cmid"),
+    {"allowsubmissionsfromdate", MD_JSON_TIME, MD_MODULE_CONTENTS(assignment.fromDate), true},
+    {"duedate", MD_JSON_TIME, MD_MODULE_CONTENTS(assignment.dueDate), true},
+    {"cutoffdate", MD_JSON_TIME, MD_MODULE_CONTENTS(assignment.cutOffDate), true},
+    {"intro", MD_JSON_STRING, MD_MODULE_CONTENTS(assignment.description.text), true},
+    {"introformat", MD_JSON_INT, MD_MODULE_CONTENTS(assignment.description.format), true},
+    {"introattachments", MD_JSON_ARRAY, MD_MODULE_CONTENTS(assignment.files), true, &mdFileSchema},
+    {"configs", MD_JSON_EACH, 0, true, &mdAssignmentConfigSchema},
+};
+static const MDJsonSchema mdAssignmentSchema =
+    MD_JSON_SCHEMA(MDModuleData, md_mod_assignment_data_init, md_module_data_cleanup, NULL, mdAssignmentFields);
+
+// Assignments are grouped by courses, which are all decoded into the same
+// array.
+static const MDJsonField mdAssignmentCourseFields[] = {
+    {"assignments", MD_JSON_ARRAY, 0, true, &mdAssignmentSchema},
+};
+static const MDJsonSchema mdAssignmentCourseSchema = MD_JSON_SCHEMA(MDArray, NULL, NULL, NULL, mdAssignmentCourseFields);
+static const MDJsonField mdAssignmentResponseFields[] = {
+    {"courses", MD_JSON_EACH, 0, true, &mdAssignmentCourseSchema},
+};
+static const MDJsonSchema mdAssignmentResponseSchema =
+    MD_JSON_SCHEMA(MDArray, NULL, NULL, NULL, mdAssignmentResponseFields);
+
+static const MDJsonField mdWorkshopFields[] = {
+    MD_MODULE_DATA_FIELDS("coursemodule"),
+    {"submissionstart", MD_JSON_TIME, MD_MODULE_CONTENTS(workshop.fromDate), true},
+    {"submissionend", MD_JSON_TIME, MD_MODULE_CONTENTS(workshop.dueDate), true},
+    {"latesubmissions", MD_JSON_BOOL, MD_MODULE_CONTENTS(workshop.lateSubmissions), true},
+    {"intro", MD_JSON_STRING, MD_MODULE_CONTENTS(workshop.description.text), true},
+    {"introformat", MD_JSON_INT, MD_MODULE_CONTENTS(workshop.description.format), true},
+    {"instructauthors", MD_JSON_STRING, MD_MODULE_CONTENTS(workshop.instructions.text), true},
+    {"instructauthorsformat", MD_JSON_INT, MD_MODULE_CONTENTS(workshop.instructions.format), true},
+    {"submissiontypetext", MD_JSON_INT, MD_MODULE_CONTENTS(workshop.textSubmission.status), true},
+    {"submissiontypefile", MD_JSON_INT, MD_MODULE_CONTENTS(workshop.fileSubmission.status), true},
+    // The rest is only used if file submission is enabled.
+    {"submissionfiletypes", MD_JSON_STRING, MD_MODULE_CONTENTS(workshop.fileSubmission.acceptedFileTypes), false},
+    {"maxbytes", MD_JSON_LONG, MD_MODULE_CONTENTS(workshop.fileSubmission.maxSubmissionSize), false},
+    {"nattachments", MD_JSON_INT, MD_MODULE_CONTENTS(workshop.fileSubmission.maxUploadedFiles), false},
+};
+static const MDJsonSchema mdWorkshopSchema = MD_JSON_SCHEMA(MDModuleData, md_mod_workshop_data_init,
+                                                            md_module_data_cleanup, md_mod_workshop_data_finish,
+                                                            mdWorkshopFields);
+static const MDJsonField mdWorkshopResponseFields[] = {
+    {"workshops", MD_JSON_ARRAY, 0, true, &mdWorkshopSchema},
+};
+static const MDJsonSchema mdWorkshopResponseSchema = MD_JSON_SCHEMA(MDArray, NULL, NULL, NULL, mdWorkshopResponseFields);
+
+static const MDJsonField mdResourceFields[] = {
+    MD_MODULE_DATA_FIELDS("coursemodule"),
+    {"intro", MD_JSON_STRING, MD_MODULE_CONTENTS(resource.description.text), true},
+    {"introformat", MD_JSON_INT, MD_MODULE_CONTENTS(resource.description.format), true},
+    {"contentfiles", MD_JSON_ARRAY, MD_MODULE_CONTENTS(resource.files), true, &mdFileSchema},
+};
+static const MDJsonSchema mdResourceSchema =
+    MD_JSON_SCHEMA(MDModuleData, md_mod_resource_data_init, md_module_data_cleanup, NULL, mdResourceFields);
+static const MDJsonField mdResourceResponseFields[] = {
+    {"resources", MD_JSON_ARRAY, 0, true, &mdResourceSchema},
+};
+static const MDJsonSchema mdResourceResponseSchema = MD_JSON_SCHEMA(MDArray, NULL, NULL, NULL, mdResourceResponseFields);
+
+static const MDJsonField mdUrlFields[] = {
+    MD_MODULE_DATA_FIELDS("coursemodule"),
+    {"intro", MD_JSON_STRING, MD_MODULE_CONTENTS(url.description.text), true},
+    {"introformat", MD_JSON_INT, MD_MODULE_CONTENTS(url.description.format), true},
+    {"name", MD_JSON_STRING, MD_MODULE_CONTENTS(url.name), true},
+    {"externalurl", MD_JSON_STRING, MD_MODULE_CONTENTS(url.url), true},
+};
+static const MDJsonSchema mdUrlSchema =
+    MD_JSON_SCHEMA(MDModuleData, md_mod_url_data_init, md_module_data_cleanup, NULL, mdUrlFields);
+static const MDJsonField mdUrlResponseFields[] = {
+    {"urls", MD_JSON_ARRAY, 0, true, &mdUrlSchema},
+};
+static const MDJsonSchema mdUrlResponseSchema = MD_JSON_SCHEMA(MDArray, NULL, NULL, NULL, mdUrlResponseFields);
+
 // List of known modules. Order is important. Indeces should match the types (MDModType).
 static MDMod mdModList[MD_MOD_COUNT] = {
     {
         .type = MD_MOD_ASSIGNMENT,
         .name = "assign",
         .parseWsFunction = "mod_assign_get_assignments",
-        .parseFunc = md_client_courses_set_mod_assignment_data,
+        .dataSchema = &mdAssignmentResponseSchema,
         .statusWsFunction = "mod_assign_get_submission_status",
         .statusInstanceName = "assignid",
         .statusParseFunc = md_mod_assign_parse_status,
         .initFunc = (MDInitFunc)md_mod_assignment_init,
         .cleanupFunc = (MDCleanupFunc)md_mod_assignment_cleanup,
+        .writeFunc = md_mod_assignment_write,
+        .readFunc = md_mod_assignment_read,
     },
     {
         .type = MD_MOD_WORKSHOP,
         .name = "workshop",
         .parseWsFunction = "mod_workshop_get_workshops_by_courses",
-        .parseFunc = md_client_courses_set_mod_workshop_data,
+        .dataSchema = &mdWorkshopResponseSchema,
         .statusWsFunction = "mod_workshop_get_submissions",
         .statusInstanceName = "workshopid",
         .statusParseFunc = md_mod_workshop_parse_status,
         .initFunc = (MDInitFunc)md_mod_workshop_init,
         .cleanupFunc = (MDCleanupFunc)md_mod_workshop_cleanup,
+        .writeFunc = md_mod_workshop_write,
+        .readFunc = md_mod_workshop_read,
     },
     {
         .type = MD_MOD_RESOURCE,
         .name = "resource",
         .parseWsFunction = "mod_resource_get_resources_by_courses",
-        .parseFunc = md_client_courses_set_mod_resource_data,
+        .dataSchema = &mdResourceResponseSchema,
         .statusParseFunc = NULL,
         .initFunc = (MDInitFunc)md_mod_resource_init,
         .cleanupFunc = (MDCleanupFunc)md_mod_resource_cleanup,
+        .writeFunc = md_mod_resource_write,
+        .readFunc = md_mod_resource_read,
     },
     {
         .type = MD_MOD_URL,
         .name = "url",
         .parseWsFunction = "mod_url_get_urls_by_courses",
-        .parseFunc = md_client_courses_set_mod_url_data,
+        .dataSchema = &mdUrlResponseSchema,
         .statusParseFunc = NULL,
         .initFunc = (MDInitFunc)md_mod_url_init,
         .cleanupFunc = (MDCleanupFunc)md_mod_url_cleanup,
+        .writeFunc = md_mod_url_write,
+        .readFunc = md_mod_url_read,
     },
 };
 
@@ -77,6 +220,8 @@ void md_init() {
 }
 
 void md_cleanup() {
+    MDError error;
+    md_http_cache_set_folder(NULL, &error);
     curl_global_cleanup();
 }
 
@@ -87,6 +232,7 @@ MDClient *md_client_new(cchar *token, cchar *website, MDError *error) {
         client->token = clone_str(token, error);
         client->website = clone_str(website, error);
         client->fullName = client->siteName = NULL;
+        client->pool = md_http_pool_new(error);
     }
     return client;
 }
@@ -103,13 +249,17 @@ MDClient *md_client_load_from_file(cchar *filename, MDError *error) {
             char **clientStringFields[] = MD_CLIENT_STRING_FIELDS(client);
             const int fieldCount = sizeof(clientStringFields) / sizeof(clientStringFields[0]);
 
+            bool ok = fread(client, sizeof(MDClient), 1, file);
+            // Saved pointers belonged to another client and are replaced
+            // below.
             for (int i = 0; i < fieldCount; ++i) {
                 *clientStringFields[i] = NULL;
             }
-
-            if (!fread(client, sizeof(MDClient), 1, file)) {
+            client->pool = NULL;
+            if (!ok) {
                 *error = MD_ERR_FILE_OPERATION;
             } else {
+                client->pool = md_http_pool_new(error);
                 for (int i = 0; i < fieldCount && !*error; ++i) {
                     *clientStringFields[i] = fread_string(file, error);
                 }
@@ -130,7 +280,7 @@ MDClient *md_client_load_from_file(cchar *filename, MDError *error) {
 
 void md_client_save_to_file(MDClient *client, cchar *filename, MDError *error) {
     *error = MD_ERR_NONE;
-    FILE *file = fopen(filename, "wb");
+    FILE *file = md_open_private_file(filename);
     if (!file) {
         *error = MD_ERR_FILE_OPERATION;
     } else {
@@ -161,12 +311,10 @@ Json *md_client_do_http_json_request(MDClient *client, MDError *error, char *wsf
     va_end(args);
 
     // printf("<%s>\n", url);
-    char *data = http_get_request(url, error);
+    char *data = http_get_request(client->pool, url, error);
     if (!data)
         return NULL;
-    Json *json = md_parse_moodle_json(data, error);
-    free(data);
-    return json;
+    return md_parse_moodle_json(data, error);
 }
 
 int md_client_write_url_varg(MDClient *client, char *url, cchar *wsfunction, cchar *format, va_list args) {
@@ -200,24 +348,24 @@ static int compareByCourseName(const void *a, const void *b) {
     return strcmp(s1 + strspn(s1, " "), s2 + strspn(s2, " "));
 }
 
-MDArray md_client_fetch_courses(MDClient *client, bool sortByName, MDError *error) {
-    *error = MD_ERR_NONE;
+MDArray md_client_fetch_course_list(MDClient *client, bool sortByName, MDError *error) {
+    ENSURE_EMPTY_ERROR(error);
     Json *jsonCourses = md_client_do_http_json_request(client, error, "core_enrol_get_users_courses", "&userid=%d", client->userid);
 
     MDArray courses;
     md_array_init(&courses);
     if (!*error && jsonCourses->type == JSON_ARRAY) {
-        md_array_init_new(&courses, sizeof(MDCourse), jsonCourses->array.len, (MDInitFunc)md_course_init, error);
+        md_array_init_new(&courses, sizeof(MDCourse), jsonCourses->len, (MDInitFunc)md_course_init, error);
         MDCourse *courseArr = MD_ARR(courses, MDCourse);
         if (!*error) {
-            courses.len = jsonCourses->array.len;
+            courses.len = jsonCourses->len;
 
             for (int i = 0; i < courses.len; ++i)
                 courseArr[i].topics.len = 0;
 
             int skip = 0;
             for (int i = 0; i < courses.len && !*error; ++i) {
-                Json *course = &jsonCourses->array.values[i];
+                Json *course = &jsonCourses->values[i];
                 cchar *format = json_get_string_no_alloc(course, "format", error);
                 // only topics or weeks format courses are supported
                 if (format && strcmp(format, "topics") && strcmp(format, "weeks")) {
@@ -234,22 +382,45 @@ MDArray md_client_fetch_courses(MDClient *client, bool sortByName, MDError *erro
     } else {
         *error = MD_ERR_INVALID_JSON_VALUE;
     }
-    md_courses_fetch_topic_contents(client, courses, error);
     md_cleanup_json(jsonCourses);
-    if (sortByName) {
+    if (sortByName && !*error) {
         sort(courses._data, courses.len, sizeof(MDCourse), compareByCourseName);
     }
     return courses;
 }
 
+MDArray md_client_fetch_courses(MDClient *client, bool sortByName, MDError *error) {
+    *error = MD_ERR_NONE;
+    MDArray courses = md_client_fetch_course_list(client, sortByName, error);
+    if (!*error)
+        md_courses_fetch_topic_contents(client, courses, MD_NO_COURSE, error);
+    if (!*error) {
+        // The courses are built piece by piece, so they are turned into a
+        // snapshot once complete.
+        MDArray snapshot = md_courses_clone(courses, error);
+        md_courses_cleanup(courses);
+        courses = snapshot;
+    }
+    return courses;
+}
+
 void md_courses_cleanup(MDArray courses) {
-    md_array_cleanup(&courses, sizeof(MDCourse), (MDCleanupFunc)md_course_cleanup);
+    if (courses._arena) {
+        // The arena is stored in itself, so it's copied out first.
+        Arena arena = *(Arena *)courses._arena;
+        arena_cleanup(&arena);
+    } else {
+        md_array_cleanup(&courses, sizeof(MDCourse), (MDCleanupFunc)md_course_cleanup);
+    }
 }
 
 void md_array_init_new(MDArray *array, size_t size, int length, MDInitFunc callback, MDError *error) {
     array->len = length;
+    array->_arena = NULL;
     if (size && length) {
         array->_data = md_malloc(length * size, error);
+        if (!array->_data)
+            array->len = 0;
         if (array->_data && callback) {
             for (int i = 0; i < length; ++i) {
                 callback((void *)((char *)array->_data + i * size));
@@ -266,18 +437,19 @@ void md_array_cleanup(MDArray *array, size_t size, MDCleanupFunc callback) {
             callback((void *)((char *)array->_data + i * size));
     }
     free(array->_data);
-    array->len = 0;
-    array->_data = NULL;
+    md_array_init(array);
 }
 
 void md_array_init(MDArray *array) {
     array->len = 0;
     array->_data = NULL;
+    array->_arena = NULL;
 }
 
 void md_course_init(MDCourse *course) {
     course->name = NULL;
     course->id = MD_NO_IDENTIFIER;
+    course->fetchTime = course->syncTime = MD_DATE_NONE;
     md_array_init(&course->topics);
 }
 
@@ -289,6 +461,7 @@ void md_course_cleanup(MDCourse *course) {
 void md_topic_init(MDTopic *topic) {
     topic->name = NULL;
     topic->id = MD_NO_IDENTIFIER;
+    md_rich_text_init(&topic->summary);
     md_array_init(&topic->modules);
 }
 
@@ -313,6 +486,28 @@ void md_module_cleanup(MDModule *module) {
     }
 }
 
+void md_mod_write(MDWriter *writer, MDModule *module) {
+    md_write_integer(writer, module->type);
+    if (module->type != MD_MOD_UNSUPPORTED) {
+        md_write_string(writer, module->name);
+        mdModList[module->type].writeFunc(writer, module);
+    }
+}
+
+void md_mod_read(MDReader *reader, MDModule *module) {
+    long long type = md_read_integer(reader);
+    if (*reader->error || type == MD_MOD_UNSUPPORTED)
+        return;
+    if (type < 0 || type >= MD_MOD_COUNT) {
+        *reader->error = MD_ERR_INVALID_FILE;
+        return;
+    }
+    module->type = type;
+    mdModList[type].initFunc(module);
+    module->name = md_read_string(reader);
+    mdModList[type].readFunc(reader, module);
+}
+
 void md_mod_assignment_init(MDModule *module) {
     MDModAssignment *assignment = &module->contents.assignment;
     assignment->fromDate = assignment->dueDate = assignment->cutOffDate = MD_DATE_NONE;
@@ -320,6 +515,7 @@ void md_mod_assignment_init(MDModule *module) {
     md_file_submission_init(&assignment->fileSubmission);
     md_text_submission_init(&assignment->textSubmission);
     md_array_init(&assignment->files);
+    md_mod_assignment_status_init(&assignment->status);
 }
 
 void md_mod_assignment_cleanup(MDModule *module) {
@@ -328,6 +524,7 @@ void md_mod_assignment_cleanup(MDModule *module) {
     md_file_submission_cleanup(&assignment->fileSubmission);
     md_text_submission_cleanup(&assignment->textSubmission);
     md_array_cleanup(&assignment->files, sizeof(MDFile), (MDCleanupFunc)md_file_cleanup);
+    md_mod_assignment_status_cleanup(&assignment->status);
 }
 
 void md_mod_workshop_init(MDModule *module) {
@@ -338,6 +535,7 @@ void md_mod_workshop_init(MDModule *module) {
     workshop->lateSubmissions = false;
     md_file_submission_init(&workshop->fileSubmission);
     md_text_submission_init(&workshop->textSubmission);
+    md_mod_workshop_status_init(&workshop->status);
 }
 
 void md_mod_workshop_cleanup(MDModule *module) {
@@ -346,6 +544,7 @@ void md_mod_workshop_cleanup(MDModule *module) {
     md_rich_text_cleanup(&workshop->instructions);
     md_file_submission_cleanup(&workshop->fileSubmission);
     md_text_submission_cleanup(&workshop->textSubmission);
+    md_mod_workshop_status_cleanup(&workshop->status);
 }
 
 void md_mod_url_init(MDModule *module) {
@@ -376,6 +575,9 @@ void md_mod_resource_cleanup(MDModule *module) {
 void md_rich_text_init(MDRichText *richText) {
     richText->text = NULL;
     richText->format = MD_FORMAT_PLAIN;
+#ifdef MD_CUSTOM_FIELD_RICH_TEXT
+    richText->MD_CUSTOM_FIELD_RICH_TEXT = NULL;
+#endif
 }
 
 void md_rich_text_cleanup(MDRichText *richText) {
@@ -403,6 +605,9 @@ void md_text_submission_cleanup(MDTextSubmission *submission) {
 }
 
 void md_mod_assignment_status_init(MDModAssignmentStatus *status) {
+    status->state = MD_MOD_ASSIGNMENT_STATE_NEW;
+    status->submitDate = status->gradeDate = MD_DATE_NONE;
+    status->graded = false;
     status->grade = NULL;
     md_rich_text_init(&status->submittedText);
     md_array_init(&status->submittedFiles);
@@ -415,6 +620,8 @@ void md_mod_assignment_status_cleanup(MDModAssignmentStatus *status) {
 }
 
 void md_mod_workshop_status_init(MDModWorkshopStatus *status) {
+    status->submitted = false;
+    status->submitDate = MD_DATE_NONE;
     status->title = NULL;
     md_rich_text_init(&status->submittedText);
     md_array_init(&status->submittedFiles);
@@ -460,6 +667,7 @@ void md_file_init(MDFile *file) {
     file->filename = NULL;
     file->url = NULL;
     file->filesize = 0;
+    file->timeModified = 0;
 }
 
 void md_file_cleanup(MDFile *file) {
@@ -475,95 +683,127 @@ MDModType md_get_mod_type(cchar *module) {
     return MD_MOD_UNSUPPORTED;
 }
 
-// not NULL expected
-MDArray md_parse_modules(Json *json, MDError *error) {
-    MDArray modulesArr;
-    md_array_init(&modulesArr);
-    if (json->type == JSON_ARRAY) {
-        int skip = 0;
-        md_array_init_new(&modulesArr, sizeof(MDModule), json->array.len, (MDInitFunc)md_module_init, error);
-        MDModule *modules = MD_ARR(modulesArr, MDModule);
-
-        for (int i = 0; i < json->array.len && !*error; ++i) {
-            Json *jsonModule = &json->array.values[i];
-            bool userVisible = json_get_bool(jsonModule, "uservisible", error);
-            cchar *type = json_get_string_no_alloc(jsonModule, "modname", error);
-
-            if (*error || !userVisible) {
-                ++skip;
-            } else if (!type || (modules[i - skip].type = md_get_mod_type(type)) == MD_MOD_UNSUPPORTED) {
-                ++skip;
-            } else {
-                mdModList[modules[i - skip].type].initFunc(&modules[i - skip]);
-                modules[i - skip].name = json_get_string(jsonModule, "name", error);
-                modules[i - skip].id = json_get_integer(jsonModule, "id", error);
-                modules[i - skip].instance = json_get_integer(jsonModule, "instance", error);
-            }
-        }
-        modulesArr.len -= skip;
-    } else {
+// md_module_set_visible drops modules which are not visible to the user.
+static bool md_module_set_visible(void *module, Json *value, MDError *error) {
+    if (value->type != JSON_BOOLEAN) {
         *error = MD_ERR_INVALID_JSON_VALUE;
+        return false;
     }
-    return modulesArr;
-}
-
-MDArray md_parse_topics(Json *json, MDError *error) {
-    MDArray topicArr;
-    md_array_init(&topicArr);
-    if (json->type == JSON_ARRAY) {
-        md_array_init_new(&topicArr, sizeof(MDTopic), json->array.len, (MDInitFunc)md_topic_init, error);
-        for (int i = 0; i < json->array.len && (!*error); ++i) {
-            MDTopic *topic = &MD_ARR(topicArr, MDTopic)[i];
-            topic->id = json_get_integer(&json->array.values[i], "id", error);
-            topic->name = json_get_string(&json->array.values[i], "name", error);
-            topic->summary.text = json_get_string(&json->array.values[i], "summary", error);
-            topic->summary.format = json_get_integer(&json->array.values[i], "summaryformat", error);
-            Json *modules = json_get_array(&json->array.values[i], "modules", error);
+    return value->boolean;
+}
 
-            if (*error)
-                break;
-            MD_ARR(topicArr, MDTopic)[i].modules = md_parse_modules(modules, error);
-        }
-    } else {
+// md_module_set_type sets the type of the module from the name of it and
+// initializes its contents. Unsupported modules are dropped.
+static bool md_module_set_type(void *target, Json *value, MDError *error) {
+    MDModule *module = target;
+    if (value->type != JSON_STRING) {
         *error = MD_ERR_INVALID_JSON_VALUE;
+        return false;
     }
-    return topicArr;
+    module->type = md_get_mod_type(value->str);
+    if (module->type == MD_MOD_UNSUPPORTED)
+        return false;
+    mdModList[module->type].initFunc(module);
+    return true;
 }
 
-void md_courses_fetch_topic_contents(MDClient *client, MDArray courses, MDError *error) {
+// md_module_drop releases a module dropped while being decoded, whose name may
+// have been set before its type.
+static void md_module_drop(MDModule *module) {
+    if (module->type == MD_MOD_UNSUPPORTED)
+        free(module->name);
+    md_module_cleanup(module);
+}
+
+static void md_module_data_init(MDModuleData *data, MDModType type) {
+    data->courseId = data->moduleId = data->instance = MD_NO_IDENTIFIER;
+    md_module_init(&data->module);
+    data->module.type = type;
+    mdModList[type].initFunc(&data->module);
+    data->configPlugin = data->configName = data->configValue = NULL;
+}
+
+static void md_mod_assignment_data_init(MDModuleData *data) {
+    md_module_data_init(data, MD_MOD_ASSIGNMENT);
+}
+
+static void md_mod_workshop_data_init(MDModuleData *data) {
+    md_module_data_init(data, MD_MOD_WORKSHOP);
+}
+
+static void md_mod_resource_data_init(MDModuleData *data) {
+    md_module_data_init(data, MD_MOD_RESOURCE);
+}
+
+static void md_mod_url_data_init(MDModuleData *data) {
+    md_module_data_init(data, MD_MOD_URL);
+}
+
+static void md_module_data_cleanup(MDModuleData *data) {
+    md_module_cleanup(&data->module);
+    free(data->configPlugin);
+    free(data->configName);
+    free(data->configValue);
+}
+
+// md_write_course_ids writes courses ids as webservice parameter, so that data
+// is only returned for the given courses. If the parameter doesn't fit, empty
+// string is written and data will be returned for all the courses.
+void md_write_course_ids(char *param, int size, MDArray courses) {
+    int len = 0;
+    param[0] = '\0';
+    for (int i = 0; i < courses.len && len < size; ++i) {
+        len += snprintf(param + len, size - len, "&courseids[%d]=%d", i, MD_COURSES(courses)[i].id);
+    }
+    if (len >= size)
+        param[0] = '\0';
+}
+
+void md_courses_fetch_topic_contents(MDClient *client, MDArray courses, int priorityCourseId, MDError *error) {
+    time_t fetchTime = time(NULL) - MD_SYNC_TIME_MARGIN;
     int count = courses.len + MD_MOD_COUNT;
     char urls[count][MD_URL_LENGTH];
+    MDHttpRequest requests[count];
+    // Topics are decoded straight into the courses, while module data can
+    // only be applied once all the topics are there.
+    MDArray modData[MD_MOD_COUNT];
+    MDJsonDecoder *decoders = md_malloc(count * sizeof(MDJsonDecoder), error);
+    if (!decoders)
+        return;
     for (int i = 0; i < courses.len; ++i) {
-        md_client_write_url(client, urls[i], "core_course_get_contents", "&courseid=%d", MD_ARR(courses, MDCourse)[i].id);
+        MDCourse *course = &MD_COURSES(courses)[i];
+        md_client_write_url(client, urls[i], "core_course_get_contents", "&courseid=%d", course->id);
+        md_json_decoder_init(&decoders[i], MD_JSON_ARRAY, &mdTopicSchema, &course->topics, client);
+        int priority = course->id == priorityCourseId ? MD_HTTP_PRIORITY_HIGH : MD_HTTP_PRIORITY_NORMAL;
+        requests[i] = (MDHttpRequest){.url = urls[i], .priority = priority, .decoder = &decoders[i]};
     }
+    char courseIds[MD_URL_LENGTH / 2];
+    md_write_course_ids(courseIds, sizeof(courseIds), courses);
     for (int i = 0; i < MD_MOD_COUNT; ++i) {
-        md_client_write_url(client, urls[courses.len + i], mdModList[i].parseWsFunction, "");
+        int index = courses.len + i;
+        md_array_init(&modData[i]);
+        md_client_write_url(client, urls[index], mdModList[i].parseWsFunction, "%s", courseIds);
+        md_json_decoder_init(&decoders[index], MD_JSON_OBJECT, mdModList[i].dataSchema, &modData[i], client);
+        requests[index] = (MDHttpRequest){.url = urls[index], .priority = MD_HTTP_PRIORITY_NORMAL, .decoder = &decoders[index]};
     }
 
-    char *urlArray[count];
-    for (int i = 0; i < count; ++i)
-        urlArray[i] = urls[i];
-
-    char **results = http_get_multi_request(urlArray, count, error);
+    http_multi_request(client->pool, requests, count, NULL, NULL, error);
+    free(decoders);
 
-    if (!*error) {
-        for (int i = 0; i < courses.len && (!*error); ++i) {
-            Json *topics = md_parse_moodle_json(results[i], error);
-            if (!*error) {
-                MD_ARR(courses, MDCourse)[i].topics = md_parse_topics(topics, error);
-            }
-            md_cleanup_json(topics);
-        }
-        for (int i = 0; i < MD_MOD_COUNT && (!*error); ++i) {
-            Json *json = md_parse_moodle_json(results[courses.len + i], error);
-            if (!*error)
-                mdModList[i].parseFunc(client, courses, json, error);
-            md_cleanup_json(json);
-        }
-        for (int i = 0; i < count; ++i)
-            free(results[i]);
+    // The topics don't change while the data is applied, so the index stays
+    // valid.
+    MDModuleIndex index;
+    md_module_index_init(&index);
+    if (!*error)
+        md_module_index_build(&index, courses, error);
+    for (int i = 0; i < MD_MOD_COUNT; ++i) {
+        if (!*error)
+            md_courses_apply_module_data(&index, modData[i], error);
+        md_array_cleanup(&modData[i], sizeof(MDModuleData), (MDCleanupFunc)md_module_data_cleanup);
     }
-    free(results);
+    md_module_index_cleanup(&index);
+    for (int i = 0; i < courses.len && !*error; ++i)
+        MD_COURSES(courses)[i].fetchTime = fetchTime;
 }
 
 void md_client_cleanup(MDClient *client) {
@@ -572,6 +812,7 @@ void md_client_cleanup(MDClient *client) {
         free(client->website);
         free(client->fullName);
         free(client->siteName);
+        md_http_pool_cleanup(client->pool);
     }
     free(client);
 }
@@ -580,16 +821,20 @@ void md_client_cleanup(MDClient *client) {
 Json *md_parse_moodle_json(char *data, MDError *error) {
     ENSURE_EMPTY_ERROR(error);
     Json *json = md_parse_json(data, error);
-    if (json) {
-        if (json_get_string_no_alloc(json, "exception", &(MDError){0})) {
-            cchar *msg = json_get_string_no_alloc(json, "message", &(MDError){0});
-            md_error_set_message(msg ? msg : data);
-            *error = MD_ERR_MOODLE_EXCEPTION;
-        }
-    }
+    if (json)
+        md_check_moodle_exception(json, error);
     return json;
 }
 
+void md_check_moodle_exception(Json *json, MDError *error) {
+    cchar *exception = json_get_string_no_alloc(json, "exception", &(MDError){0});
+    if (exception) {
+        cchar *msg = json_get_string_no_alloc(json, "message", &(MDError){0});
+        md_error_set_message(msg ? msg : exception);
+        *error = MD_ERR_MOODLE_EXCEPTION;
+    }
+}
+
 long md_client_upload_file(MDClient *client, cchar *filename, long itemId, MDError *error) {
     *error = MD_ERR_NONE;
     char url[MD_URL_LENGTH];
@@ -599,18 +844,17 @@ long md_client_upload_file(MDClient *client, cchar *filename, long itemId, MDErr
             "?token=%s"
             "&itemid=%ld",
             client->website, MD_UPLOAD_URL, client->token, itemId);
-    char *data = http_post_file(url, filename, "file_box", error);
+    char *data = http_post_file(client->pool, url, filename, "file_box", error);
     if (!*error) {
         Json *json = md_parse_moodle_json(data, error);
         if (!*error) {
-            if (json->type == JSON_ARRAY && json->array.len > 0)
-                resultId = json_get_integer(&json->array.values[0], "itemid", error);
+            if (json->type == JSON_ARRAY && json->len > 0)
+                resultId = json_get_integer(&json->values[0], "itemid", error);
             else
                 *error = MD_ERR_INVALID_JSON_VALUE;
         }
         md_cleanup_json(json);
     }
-    free(data);
     return resultId;
 }
 
@@ -633,9 +877,9 @@ cchar *md_find_moodle_warning(Json *json) {
     if ((warnings = json_get_property_silent(json, "warnings"))) {
         json = warnings;
     }
-    if (json->type == JSON_ARRAY && json->array.len > 0) {
-        if (json_get_property_silent(&json->array.values[0], "warningcode")) {
-            return json_get_string_no_alloc(&json->array.values[0], "message", &(MDError){0});
+    if (json->type == JSON_ARRAY && json->len > 0) {
+        if (json_get_property_silent(&json->values[0], "warningcode")) {
+            return json_get_string_no_alloc(&json->values[0], "message", &(MDError){0});
         }
     }
     return NULL;
@@ -712,7 +956,7 @@ void md_client_mod_workshop_submit(MDClient *client, MDModule *workshop, MDArray
 }
 
 MDModule *md_courses_locate_module(MDArray courses, int courseId, int moduleId, int instance, MDError *error) {
-    // TODO: optimize for log n lookup
+    // Fine for a single lookup, many lookups go through MDModuleIndex.
     for (int i = 0; i < courses.len; ++i) {
         MDCourse *course = &MD_COURSES(courses)[i];
         if (course->id == courseId) {
@@ -731,160 +975,158 @@ MDModule *md_courses_locate_module(MDArray courses, int courseId, int moduleId,
     return NULL;
 }
 
-MDModule *md_courses_locate_json_module(MDArray courses, Json *json, cchar *moduleIdJsonName, MDError *error) {
-    int courseId = json_get_integer(json, "course", error);
-    int moduleId = json_get_integer(json, moduleIdJsonName, error);
-    int instance = json_get_integer(json, "id", error);
-    return *error ? NULL : md_courses_locate_module(courses, courseId, moduleId, instance, error);
+void md_module_index_init(MDModuleIndex *index) {
+    index->entries = NULL;
+    index->capacity = 0;
 }
 
-MDArray md_parse_files(Json *jsonFiles, MDError *error) {
-    MDArray files;
-    md_array_init_new(&files, sizeof(MDFile), jsonFiles->array.len, (MDInitFunc)md_file_init, error);
-    for (int i = 0; i < jsonFiles->array.len && (!*error); ++i) {
-        Json *jsonAttachment = &jsonFiles->array.values[i];
-        MD_ARR(files, MDFile)[i].filename = json_get_string(jsonAttachment, "filename", error);
-        MD_ARR(files, MDFile)[i].filesize = json_get_integer(jsonAttachment, "filesize", error);
-        MD_ARR(files, MDFile)[i].url = json_get_string(jsonAttachment, "fileurl", error);
-    }
-    return files;
+// md_module_index_slot returns the first slot to look for the module at.
+static int md_module_index_slot(MDModuleIndex *index, int courseId, int moduleId, int instance) {
+    unsigned hash = (unsigned)courseId * 0x9e3779b1u;
+    hash = (hash ^ (unsigned)moduleId) * 0x85ebca6bu;
+    hash = (hash ^ (unsigned)instance) * 0xc2b2ae35u;
+    return (hash ^ hash >> 16) & (index->capacity - 1);
 }
 
-void md_parse_mod_assignment_plugins(Json *configs, MDModAssignment *assignment, MDError *error) {
-    for (int i = 0; i < configs->array.len && (!*error); ++i) {
-        Json *config = &configs->array.values[i];
-        cchar *plugin = json_get_string_no_alloc(config, "plugin", error);
-        if (*error)
-            break;
-        if (strcmp(plugin, "file") == 0) {
-            cchar *name = json_get_string_no_alloc(config, "name", error);
-            cchar *value = json_get_string_no_alloc(config, "value", error);
-            if (*error)
-                break;
-            if (strcmp(name, "enabled") == 0)
-                assignment->fileSubmission.status = !atoi(value) ? MD_SUBMISSION_DISABLED : MD_SUBMISSION_REQUIRED;
-            else if (strcmp(name, "maxfilesubmissions") == 0)
-                assignment->fileSubmission.maxUploadedFiles = atoi(value);
-            else if (strcmp(name, "filetypeslist") == 0)
-                assignment->fileSubmission.acceptedFileTypes = clone_str(value, error);
-            else if (strcmp(name, "maxsubmissionsizebytes") == 0)
-                assignment->fileSubmission.maxSubmissionSize = atoll(value);
-        } else if (strcmp(plugin, "onlinetext") == 0) {
-            cchar *name = json_get_string_no_alloc(config, "name", error);
-            cchar *value = json_get_string_no_alloc(config, "value", error);
-            if (*error)
-                break;
-            if (strcmp(name, "enabled") == 0)
-                assignment->textSubmission.status = !atoi(value) ? MD_SUBMISSION_DISABLED : MD_SUBMISSION_REQUIRED;
-            else if (strcmp(name, "wordlimit") == 0)
-                assignment->textSubmission.wordLimit = atoi(value);
+void md_module_index_build(MDModuleIndex *index, MDArray courses, MDError *error) {
+    md_module_index_cleanup(index);
+    int count = 0;
+    for (int i = 0; i < courses.len; ++i) {
+        MDCourse *course = &MD_COURSES(courses)[i];
+        for (int j = 0; j < course->topics.len; ++j)
+            count += MD_TOPICS(course->topics)[j].modules.len;
+    }
+    // At most half of the slots are taken, so that probe sequences are short.
+    int capacity = MD_MODULE_INDEX_MIN_CAPACITY;
+    while (capacity < count * 2)
+        capacity *= 2;
+    index->entries = md_malloc(capacity * sizeof(MDModuleIndexEntry), error);
+    if (!index->entries)
+        return;
+    index->capacity = capacity;
+    memset(index->entries, 0, capacity * sizeof(MDModuleIndexEntry));
+    for (int i = 0; i < courses.len; ++i) {
+        MDCourse *course = &MD_COURSES(courses)[i];
+        for (int j = 0; j < course->topics.len; ++j) {
+            MDTopic *topic = &MD_TOPICS(course->topics)[j];
+            for (int k = 0; k < topic->modules.len; ++k) {
+                MDModule *module = &MD_MODULES(topic->modules)[k];
+                int slot = md_module_index_slot(index, course->id, module->id, module->instance);
+                MDModuleIndexEntry *entry;
+                // The first of duplicate modules is found, as when searching
+                // the courses (see md_courses_locate_module).
+                while ((entry = &index->entries[slot])->module &&
+                       !(entry->courseId == course->id && entry->module->id == module->id &&
+                         entry->module->instance == module->instance))
+                    slot = (slot + 1) & (capacity - 1);
+                if (!entry->module)
+                    *entry = (MDModuleIndexEntry){course->id, module};
+            }
         }
     }
 }
 
-void md_client_courses_set_mod_assignment_data(MDClient *client, MDArray courses, Json *json, MDError *error) {
-    Json *jsonCourses = json_get_array(json, "courses", error);
-    if (!*error) {
-        for (int i = 0; i < jsonCourses->array.len; ++i) {
-            Json *jsonAssignments = json_get_array(&jsonCourses->array.values[i], "assignments", error);
-
-            // Parse the actual assignment details.
-            for (int j = 0; j < jsonAssignments->array.len && (!*error); ++j) {
-                Json *jsonAssignment = &jsonAssignments->array.values[j];
-                MDModule *module = md_courses_locate_json_module(courses, jsonAssignment, "cmid", error);
-                if (*error)
-                    break;
-                module->type = MD_MOD_ASSIGNMENT;
-                MDModAssignment *assignment = &module->contents.assignment;
-                assignment->fromDate = json_get_integer(jsonAssignment, "allowsubmissionsfromdate", error);
-                assignment->dueDate = json_get_integer(jsonAssignment, "duedate", error);
-                assignment->cutOffDate = json_get_integer(jsonAssignment, "cutoffdate", error);
-                assignment->description.text = json_get_string(jsonAssignment, "intro", error);
-                assignment->description.format = json_get_integer(jsonAssignment, "introformat", error);
-                Json *jsonAttachments = json_get_array(jsonAssignment, "introattachments", error);
-                if (jsonAttachments)
-                    assignment->files = md_parse_files(jsonAttachments, error);
-                Json *configs = json_get_array(jsonAssignment, "configs", error);
-                if (configs)
-                    md_parse_mod_assignment_plugins(configs, assignment, error);
-            }
+MDModule *md_module_index_get(MDModuleIndex *index, int courseId, int moduleId, int instance, MDError *error) {
+    if (index->capacity) {
+        int slot = md_module_index_slot(index, courseId, moduleId, instance);
+        for (MDModuleIndexEntry *entry; (entry = &index->entries[slot])->module;
+             slot = (slot + 1) & (index->capacity - 1)) {
+            if (entry->courseId == courseId && entry->module->id == moduleId && entry->module->instance == instance)
+                return entry->module;
         }
     }
+    *error = MD_ERR_MISMACHING_MOODLE_DATA;
+    return NULL;
 }
 
-void md_client_courses_set_mod_workshop_data(MDClient *client, MDArray courses, Json *json, MDError *error) {
-    Json *jsonWorkshops = json_get_array(json, "workshops", error);
-    if (!*error) {
-        for (int i = 0; i < jsonWorkshops->array.len; ++i) {
-            Json *jsonWorkshop = &jsonWorkshops->array.values[i];
-            MDModule *module = md_courses_locate_json_module(courses, jsonWorkshop, "coursemodule", error);
-            if (*error)
-                break;
-            module->type = MD_MOD_WORKSHOP;
-            MDModWorkshop *workshop = &module->contents.workshop;
-            workshop->fromDate = json_get_integer(jsonWorkshop, "submissionstart", error);
-            workshop->dueDate = json_get_integer(jsonWorkshop, "submissionend", error);
-            workshop->lateSubmissions = json_get_bool(jsonWorkshop, "latesubmissions", error);
-            workshop->description.text = json_get_string(jsonWorkshop, "intro", error);
-            workshop->description.format = json_get_integer(jsonWorkshop, "introformat", error);
-            workshop->instructions.text = json_get_string(jsonWorkshop, "instructauthors", error);
-            workshop->instructions.format = json_get_integer(jsonWorkshop, "instructauthorsformat", error);
-            workshop->textSubmission.status = json_get_integer(jsonWorkshop, "submissiontypetext", error);
-            workshop->textSubmission.wordLimit = MD_NO_WORD_LIMIT;
-            workshop->fileSubmission.status = json_get_integer(jsonWorkshop, "submissiontypefile", error);
-            if (workshop->fileSubmission.status != MD_SUBMISSION_DISABLED) {
-                workshop->fileSubmission.acceptedFileTypes = json_get_string(jsonWorkshop, "submissionfiletypes", error);
-                workshop->fileSubmission.maxSubmissionSize = json_get_integer(jsonWorkshop, "maxbytes", error);
-                if (workshop->fileSubmission.maxSubmissionSize == 0)
-                    workshop->fileSubmission.maxSubmissionSize = client->uploadLimit;
-                workshop->fileSubmission.maxUploadedFiles = json_get_integer(jsonWorkshop, "nattachments", error);
-            }
-        }
+void md_module_index_cleanup(MDModuleIndex *index) {
+    free(index->entries);
+    md_module_index_init(index);
+}
+
+void md_courses_apply_module_data(MDModuleIndex *index, MDArray data, MDError *error) {
+    for (int i = 0; i < data.len && !*error; ++i) {
+        MDModuleData *item = &MD_ARR(data, MDModuleData)[i];
+        MDModule *module = md_module_index_get(index, item->courseId, item->moduleId, item->instance, error);
+        if (*error)
+            break;
+        if (module->type != MD_MOD_UNSUPPORTED)
+            mdModList[module->type].cleanupFunc(module);
+        module->type = item->module.type;
+        module->contents = item->module.contents;
+        // The contents now belong to the module.
+        item->module.type = MD_MOD_UNSUPPORTED;
     }
 }
 
-void md_client_courses_set_mod_resource_data(MDClient *client, MDArray courses, Json *json, MDError *error) {
-    Json *jsonResources = json_get_array(json, "resources", error);
-    if (!*error) {
-        for (int i = 0; i < jsonResources->array.len; ++i) {
-            Json *jsonResource = &jsonResources->array.values[i];
-            MDModule *module = md_courses_locate_json_module(courses, jsonResource, "coursemodule", error);
-            if (*error)
-                break;
-            module->type = MD_MOD_RESOURCE;
-            MDModResource *resource = &module->contents.resource;
-            resource->description.text = json_get_string(jsonResource, "intro", error);
-            resource->description.format = json_get_integer(jsonResource, "introformat", error);
-            Json *jsonFiles = json_get_array(jsonResource, "contentfiles", error);
-            if (jsonFiles)
-                resource->files = md_parse_files(jsonFiles, error);
-        }
+MDArray md_parse_files(Json *jsonFiles, MDError *error) {
+    MDArray files;
+    md_array_init_new(&files, sizeof(MDFile), jsonFiles->len, (MDInitFunc)md_file_init, error);
+    for (int i = 0; i < jsonFiles->len && (!*error); ++i) {
+        Json *jsonAttachment = &jsonFiles->values[i];
+        MD_ARR(files, MDFile)[i].filename = json_get_string(jsonAttachment, "filename", error);
+        MD_ARR(files, MDFile)[i].filesize = json_get_integer(jsonAttachment, "filesize", error);
+        MD_ARR(files, MDFile)[i].url = json_get_string(jsonAttachment, "fileurl", error);
+        Json *timeModified = json_object_get(jsonAttachment, "timemodified");
+        if (timeModified && timeModified->type == JSON_NUMBER)
+            MD_ARR(files, MDFile)[i].timeModified = json_integer(timeModified);
     }
+    return files;
 }
 
-void md_client_courses_set_mod_url_data(MDClient *client, MDArray courses, Json *json, MDError *error) {
-    Json *jsonUrls = json_get_array(json, "urls", error);
-    if (!*error) {
-        for (int i = 0; i < jsonUrls->array.len; ++i) {
-            Json *jsonUrl = &jsonUrls->array.values[i];
-            MDModule *module = md_courses_locate_json_module(courses, jsonUrl, "coursemodule", error);
-            if (*error)
-                break;
-            module->type = MD_MOD_URL;
-            MDModUrl *url = &module->contents.url;
-            url->description.text = json_get_string(jsonUrl, "intro", error);
-            url->description.format = json_get_integer(jsonUrl, "introformat", error);
-            url->name = json_get_string(jsonUrl, "name", error);
-            url->url = json_get_string(jsonUrl, "externalurl", error);
+void md_mod_assignment_apply_config(MDModAssignment *assignment, cchar *plugin, cchar *name, cchar *value,
+                                    MDError *error) {
+    if (!plugin || !name || !value)
+        return;
+    if (strcmp(plugin, "file") == 0) {
+        if (strcmp(name, "enabled") == 0) {
+            assignment->fileSubmission.status = !atoi(value) ? MD_SUBMISSION_DISABLED : MD_SUBMISSION_REQUIRED;
+        } else if (strcmp(name, "maxfilesubmissions") == 0) {
+            assignment->fileSubmission.maxUploadedFiles = atoi(value);
+        } else if (strcmp(name, "filetypeslist") == 0) {
+            free(assignment->fileSubmission.acceptedFileTypes);
+            assignment->fileSubmission.acceptedFileTypes = clone_str(value, error);
+        } else if (strcmp(name, "maxsubmissionsizebytes") == 0) {
+            assignment->fileSubmission.maxSubmissionSize = atoll(value);
         }
+    } else if (strcmp(plugin, "onlinetext") == 0) {
+        if (strcmp(name, "enabled") == 0)
+            assignment->textSubmission.status = !atoi(value) ? MD_SUBMISSION_DISABLED : MD_SUBMISSION_REQUIRED;
+        else if (strcmp(name, "wordlimit") == 0)
+            assignment->textSubmission.wordLimit = atoi(value);
     }
 }
 
+// md_mod_assignment_config_finish applies a decoded config of an assignment.
+static bool md_mod_assignment_config_finish(MDModuleData *data, MDClient *client, MDError *error) {
+    md_mod_assignment_apply_config(&data->module.contents.assignment, data->configPlugin, data->configName,
+                                   data->configValue, error);
+    free(data->configPlugin);
+    free(data->configName);
+    free(data->configValue);
+    data->configPlugin = data->configName = data->configValue = NULL;
+    return true;
+}
+
+// md_mod_workshop_data_finish completes settings of a decoded workshop, which
+// depend on each other.
+static bool md_mod_workshop_data_finish(MDModuleData *data, MDClient *client, MDError *error) {
+    MDModWorkshop *workshop = &data->module.contents.workshop;
+    workshop->textSubmission.wordLimit = MD_NO_WORD_LIMIT;
+    if (workshop->fileSubmission.status == MD_SUBMISSION_DISABLED) {
+        md_file_submission_cleanup(&workshop->fileSubmission);
+        md_file_submission_init(&workshop->fileSubmission);
+    } else if (workshop->fileSubmission.maxSubmissionSize == 0) {
+        workshop->fileSubmission.maxSubmissionSize = client->uploadLimit;
+    }
+    return true;
+}
+
 void md_client_download_file(MDClient *client, MDFile *file, FILE *stream, MDError *error) {
     *error = MD_ERR_NONE;
     char url[MD_URL_LENGTH];
     snprintf(url, MD_URL_LENGTH, "%s?token=%s", file->url, client->token);
-    http_get_request_to_file(url, stream, error);
+    http_get_request_to_file(client->pool, url, stream, error);
 }
 
 MDLoadedStatus md_courses_load_status(MDClient *client, MDArray courses, MDError *error) {
@@ -893,60 +1135,76 @@ MDLoadedStatus md_courses_load_status(MDClient *client, MDArray courses, MDError
     for (int i = 0; i < courses.len; ++i) {
         MDCourse *course = &MD_COURSES(courses)[i];
         for (int j = 0; j < course->topics.len; ++j) {
-            MDTopic *topic = &MD_TOPICS(course->topics)[j];
-            for (int k = 0; k < topic->modules.len; ++k) {
-                MDModule *module = &MD_MODULES(topic->modules)[k];
-                if (mdModList[module->type].statusParseFunc) {
-                    ++count;
-                }
-            }
+            count += MD_TOPICS(course->topics)[j].modules.len;
         }
     }
+    MDArray modules;
+    md_array_init_new(&modules, sizeof(MDModule *), count, NULL, error);
     MDLoadedStatus result;
-    md_array_init_new(&result.internalReferences, sizeof(MDStatusRef), count, NULL, error);
-    char urls[count][MD_URL_LENGTH], *urlArray[count];
-    int index = 0;
+    md_array_init(&result.internalReferences);
     if (*error)
         return result;
+    int index = 0;
     for (int i = 0; i < courses.len; ++i) {
         MDCourse *course = &MD_COURSES(courses)[i];
         for (int j = 0; j < course->topics.len; ++j) {
             MDTopic *topic = &MD_TOPICS(course->topics)[j];
             for (int k = 0; k < topic->modules.len; ++k) {
-                MDModule *module = &MD_MODULES(topic->modules)[k];
-                if (mdModList[module->type].statusParseFunc) {
-                    MDStatusRef *statusRef = &MD_ARR(result.internalReferences, MDStatusRef)[index];
-                    statusRef->module = module;
-                    md_status_ref_init(statusRef);
-                    md_client_write_url(client, urls[index], mdModList[module->type].statusWsFunction, "&%s=%d", mdModList[module->type].statusInstanceName, module->instance);
-                    urlArray[index] = urls[index];
-                    ++index;
-                }
+                MD_ARR(modules, MDModule *)[index++] = &MD_MODULES(topic->modules)[k];
             }
         }
     }
-    char **data = http_get_multi_request(urlArray, count, error);
-    if (!*error) {
-        for (int i = 0; i < count && !*error; ++i) {
-            // printf("<%s>\n[%s]\n", urls[i], data[i]);
-            MDStatusRef *statusRef = &MD_ARR(result.internalReferences, MDStatusRef)[i];
-            Json *json = md_parse_moodle_json(data[i], error);
-            if (!*error) {
-                mdModList[statusRef->module->type].statusParseFunc(json, statusRef, error);
-            }
-            md_cleanup_json(json);
+    result = md_modules_load_status(client, modules, error);
+    for (int i = 0; i < result.internalReferences.len; ++i)
+        MD_ARR(result.internalReferences, MDStatusRef)[i].arena = courses._arena;
+    md_array_cleanup(&modules, sizeof(MDModule *), NULL);
+    return result;
+}
+
+void md_modules_load_status_callback(void *data, int index, Json *json, MDError *error) {
+    MDLoadedStatus *result = data;
+    if (*error)
+        return;
+    MDStatusRef *statusRef = &MD_ARR(result->internalReferences, MDStatusRef)[index];
+    md_check_moodle_exception(json, error);
+    if (!*error)
+        mdModList[statusRef->module->type].statusParseFunc(json, statusRef, error);
+    md_cleanup_json(json);
+}
+
+MDLoadedStatus md_modules_load_status(MDClient *client, MDArray modules, MDError *error) {
+    int count = 0;
+    for (int i = 0; i < modules.len; ++i) {
+        if (mdModList[MD_ARR(modules, MDModule *)[i]->type].statusParseFunc) {
+            ++count;
         }
-        for (int i = 0; i < count; ++i) {
-            free(data[i]);
+    }
+    MDLoadedStatus result;
+    md_array_init_new(&result.internalReferences, sizeof(MDStatusRef), count, NULL, error);
+    if (*error || !count)
+        return result;
+    char urls[count][MD_URL_LENGTH];
+    MDHttpRequest requests[count];
+    int index = 0;
+    for (int i = 0; i < modules.len; ++i) {
+        MDModule *module = MD_ARR(modules, MDModule *)[i];
+        if (mdModList[module->type].statusParseFunc) {
+            MDStatusRef *statusRef = &MD_ARR(result.internalReferences, MDStatusRef)[index];
+            statusRef->module = module;
+            statusRef->arena = NULL;
+            md_status_ref_init(statusRef);
+            md_client_write_url(client, urls[index], mdModList[module->type].statusWsFunction, "&%s=%d", mdModList[module->type].statusInstanceName, module->instance);
+            requests[index] = (MDHttpRequest){.url = urls[index], .priority = MD_HTTP_PRIORITY_NORMAL, .decoder = NULL};
+            ++index;
         }
-        free(data);
     }
+    http_multi_request(client->pool, requests, count, md_modules_load_status_callback, &result, error);
     return result;
 }
 
 void md_parse_mod_assignment_status_plugins(Json *configs, MDModAssignment *assignment, MDError *error) {
-    for (int i = 0; i < configs->array.len && (!*error); ++i) {
-        Json *config = &configs->array.values[i];
+    for (int i = 0; i < configs->len && (!*error); ++i) {
+        Json *config = &configs->values[i];
         cchar *plugin = json_get_string_no_alloc(config, "plugin", error);
         if (*error)
             break;
@@ -1001,17 +1259,17 @@ void md_mod_assign_parse_status(Json *json, MDStatusRef *statusRef, MDError *err
         status->graded = json_get_bool(lastAttempt, "graded", error);
         status->submitDate = json_get_integer(submission, "timecreated", error);
         Json *plugins = json_get_array(submission, "plugins", error);
-        for (int i = 0; i < plugins->array.len && !*error; ++i) {
-            cchar *type = json_get_string_no_alloc(&plugins->array.values[i], "type", error);
+        for (int i = 0; i < plugins->len && !*error; ++i) {
+            cchar *type = json_get_string_no_alloc(&plugins->values[i], "type", error);
 
             if (!*error && !strcmp(type, "file")) {
 
-                Json *fileareas = json_get_array(&plugins->array.values[i], "fileareas", error);
-                for (int j = 0; j < fileareas->array.len && !*error; ++j) {
+                Json *fileareas = json_get_array(&plugins->values[i], "fileareas", error);
+                for (int j = 0; j < fileareas->len && !*error; ++j) {
 
-                    cchar *area = json_get_string_no_alloc(&fileareas->array.values[j], "area", error);
+                    cchar *area = json_get_string_no_alloc(&fileareas->values[j], "area", error);
                     if (!*error && !strcmp(area, "submission_files")) {
-                        Json *files = json_get_array(&fileareas->array.values[j], "files", error);
+                        Json *files = json_get_array(&fileareas->values[j], "files", error);
                         if (!*error) {
                             status->submittedFiles = md_parse_files(files, error);
                         }
@@ -1019,9 +1277,9 @@ void md_mod_assign_parse_status(Json *json, MDStatusRef *statusRef, MDError *err
                 }
             } else if (!*error && !strcmp(type, "onlinetext")) {
 
-                Json *editorfields = json_get_array(&plugins->array.values[i], "editorfields", error);
-                for (int j = 0; j < editorfields->array.len && !*error; ++j) {
-                    Json *jsonField = &editorfields->array.values[j];
+                Json *editorfields = json_get_array(&plugins->values[i], "editorfields", error);
+                for (int j = 0; j < editorfields->len && !*error; ++j) {
+                    Json *jsonField = &editorfields->values[j];
                     cchar *name = json_get_string_no_alloc(jsonField, "name", error);
 
                     if (!*error && !strcmp(name, "onlinetext")) {
@@ -1047,9 +1305,9 @@ void md_mod_workshop_parse_status(Json *json, MDStatusRef *statusRef, MDError *e
     if (*error)
         return;
     MDModWorkshopStatus *status = &statusRef->status.workshop;
-    status->submitted = submissions->array.len > 0;
+    status->submitted = submissions->len > 0;
     if (status->submitted) {
-        Json *submission = &submissions->array.values[0];
+        Json *submission = &submissions->values[0];
         status->submitDate = json_get_integer(submission, "timecreated", error);
         status->title = json_get_string(submission, "title", error);
         status->submittedText.text = json_get_string(submission, "content", error);
@@ -1064,13 +1322,24 @@ void md_mod_workshop_parse_status(Json *json, MDStatusRef *statusRef, MDError *e
 void md_loaded_status_apply(MDLoadedStatus status) {
     for (int i = 0; i < status.internalReferences.len; ++i) {
         MDStatusRef *statusRef = &MD_ARR(status.internalReferences, MDStatusRef)[i];
+        if (statusRef->arena) {
+            // Modules of snapshots can't own separately allocated statuses.
+            md_status_ref_copy_to_arena(statusRef);
+            continue;
+        }
         switch (statusRef->module->type) {
+            // The module takes the ownership of the status, so the reference
+            // is reset to avoid freeing it twice.
             case MD_MOD_ASSIGNMENT:
+                md_mod_assignment_status_cleanup(&statusRef->module->contents.assignment.status);
                 statusRef->module->contents.assignment.status = statusRef->status.assignment;
+                md_mod_assignment_status_init(&statusRef->status.assignment);
                 break;
 
             case MD_MOD_WORKSHOP:
+                md_mod_workshop_status_cleanup(&statusRef->module->contents.workshop.status);
                 statusRef->module->contents.workshop.status = statusRef->status.workshop;
+                md_mod_workshop_status_init(&statusRef->status.workshop);
                 break;
 
             default:
@@ -1079,6 +1348,33 @@ void md_loaded_status_apply(MDLoadedStatus status) {
     }
 }
 
+void md_module_share_status(MDModule *to, MDModule *from, bool share) {
+    if (!from || from->type != to->type)
+        return;
+    switch (to->type) {
+        case MD_MOD_ASSIGNMENT:
+            if (share) {
+                md_mod_assignment_status_cleanup(&to->contents.assignment.status);
+                to->contents.assignment.status = from->contents.assignment.status;
+            } else {
+                md_mod_assignment_status_init(&to->contents.assignment.status);
+            }
+            break;
+
+        case MD_MOD_WORKSHOP:
+            if (share) {
+                md_mod_workshop_status_cleanup(&to->contents.workshop.status);
+                to->contents.workshop.status = from->contents.workshop.status;
+            } else {
+                md_mod_workshop_status_init(&to->contents.workshop.status);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
 void md_loaded_status_cleanup(MDLoadedStatus status) {
     md_array_cleanup(&status.internalReferences, sizeof(MDStatusRef), (MDCleanupFunc)md_status_ref_cleanup);
 }
@@ -0,0 +1,297 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Part of moodle library (schema directed json decoding). See internal.h
+ *
+ * Responses are decoded into the structs of the library while they are being
+ * parsed, using the handler mode of the json parser, so that no json tree of
+ * the whole response is built and strings are copied only once. Schemas tell
+ * which keys of an object go to which fields of a struct, and the decoder
+ * keeps a stack of the objects and arrays being decoded, along with the struct
+ * or MDArray each of them goes to. Values which have no field are skipped by
+ * counting their depth.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal.h"
+
+// Keys of Moodle exceptions, which are looked for at the root of responses.
+#define MD_JSON_EXCEPTION_KEY "exception"
+#define MD_JSON_MESSAGE_KEY "message"
+#define MD_JSON_ROOT_KEY "response"
+#define MD_JSON_MIN_CAPACITY 8
+
+static bool md_json_decoder_begin(void *data, JsonType type);
+static bool md_json_decoder_end(void *data);
+static bool md_json_decoder_key(void *data, cchar *key, JsonLength len);
+static bool md_json_decoder_value(void *data, Json *value);
+
+void md_json_decoder_init(MDJsonDecoder *decoder, MDJsonFieldType type, const MDJsonSchema *schema, void *target,
+                          void *context) {
+    decoder->handler = (JsonHandler){md_json_decoder_begin, md_json_decoder_end, md_json_decoder_key,
+                                     md_json_decoder_value, decoder};
+    decoder->root = (MDJsonField){.key = MD_JSON_ROOT_KEY, .type = type, .offset = 0, .schema = schema};
+    decoder->target = target;
+    decoder->context = context;
+    decoder->depth = decoder->skip = 0;
+    decoder->field = &decoder->root;
+    decoder->capture = NULL;
+    decoder->exception = decoder->message = NULL;
+    decoder->mismatch = false;
+    decoder->error = MD_ERR_NONE;
+}
+
+// md_json_decoder_fail stops decoding with given error about the key.
+static bool md_json_decoder_fail(MDJsonDecoder *decoder, MDError error, cchar *key) {
+    decoder->error = error;
+    md_error_set_message(key);
+    return false;
+}
+
+static bool md_json_decoder_push(MDJsonDecoder *decoder, MDJsonDecoderFrame frame) {
+    if (decoder->depth == MD_JSON_DECODER_MAX_DEPTH)
+        return md_json_decoder_fail(decoder, MD_ERR_INVALID_JSON_VALUE, frame.field ? frame.field->key : "");
+    decoder->frames[decoder->depth++] = frame;
+    decoder->field = NULL;
+    return true;
+}
+
+// md_json_decoder_add_element makes room for one more element in the array of
+// the innermost frame and initializes it, but the array only gets longer once
+// the element is decoded.
+static char *md_json_decoder_add_element(MDJsonDecoder *decoder, MDJsonDecoderFrame *frame) {
+    const MDJsonSchema *schema = frame->field->schema;
+    MDArray *array = frame->array;
+    if (array->len == frame->capacity) {
+        int capacity = frame->capacity < MD_JSON_MIN_CAPACITY ? MD_JSON_MIN_CAPACITY : frame->capacity * 2;
+        void *data = md_realloc(array->_data, capacity * schema->size, &decoder->error);
+        if (!data)
+            return NULL;
+        array->_data = data;
+        frame->capacity = capacity;
+    }
+    char *element = (char *)array->_data + array->len * schema->size;
+    if (schema->init)
+        schema->init(element);
+    else
+        memset(element, 0, schema->size);
+    return element;
+}
+
+static bool md_json_decoder_begin(void *data, JsonType type) {
+    MDJsonDecoder *decoder = data;
+    if (decoder->skip) {
+        ++decoder->skip;
+        return true;
+    }
+    MDJsonDecoderFrame *top = decoder->depth ? &decoder->frames[decoder->depth - 1] : NULL;
+    if (top && top->isArray) {
+        // Elements of arrays are always objects.
+        if (type != JSON_OBJECT)
+            return md_json_decoder_fail(decoder, MD_ERR_INVALID_JSON_VALUE, top->field->key);
+        char *element = top->target;
+        if (top->array && !(element = md_json_decoder_add_element(decoder, top)))
+            return false;
+        return md_json_decoder_push(decoder, (MDJsonDecoderFrame){.field = top->field, .target = element, .isElement = true});
+    }
+
+    const MDJsonField *field = decoder->field;
+    if (!field) {
+        decoder->skip = 1;
+        return true;
+    }
+    char *target = (top ? top->target : (char *)decoder->target) + field->offset;
+    bool isArray = field->type == MD_JSON_ARRAY || field->type == MD_JSON_EACH;
+    if (field->type != MD_JSON_OBJECT && !isArray)
+        return md_json_decoder_fail(decoder, MD_ERR_INVALID_JSON_VALUE, field->key);
+    if (isArray != (type == JSON_ARRAY)) {
+        // Moodle exceptions are objects, which can only be told apart by
+        // their keys, so the response is only looked through for them.
+        if (top || type != JSON_OBJECT)
+            return md_json_decoder_fail(decoder, MD_ERR_INVALID_JSON_VALUE, field->key);
+        decoder->mismatch = true;
+        return md_json_decoder_push(decoder, (MDJsonDecoderFrame){.field = NULL});
+    }
+    MDJsonDecoderFrame frame = {.field = field, .target = target, .isArray = isArray};
+    if (field->type == MD_JSON_ARRAY) {
+        frame.array = (MDArray *)target;
+        frame.capacity = frame.array->len;
+    }
+    return md_json_decoder_push(decoder, frame);
+}
+
+static bool md_json_decoder_end(void *data) {
+    MDJsonDecoder *decoder = data;
+    if (decoder->skip) {
+        --decoder->skip;
+        return true;
+    }
+    MDJsonDecoderFrame *frame = &decoder->frames[decoder->depth - 1];
+    if (frame->isArray) {
+        MDArray *array = frame->array;
+        // The spare capacity is given back.
+        if (array && !array->len) {
+            free(array->_data);
+            array->_data = NULL;
+        } else if (array && array->len < frame->capacity) {
+            void *shrunk = realloc(array->_data, array->len * frame->field->schema->size);
+            if (shrunk)
+                array->_data = shrunk;
+        }
+        --decoder->depth;
+        return true;
+    }
+    if (!frame->field) {
+        --decoder->depth;
+        return true;
+    }
+
+    const MDJsonSchema *schema = frame->field->schema;
+    bool keep = !frame->drop;
+    for (int i = 0; i < schema->count && keep; ++i) {
+        if (schema->fields[i].required && !(frame->seen & 1ULL << i))
+            return md_json_decoder_fail(decoder, MD_ERR_MISSING_JSON_KEY, schema->fields[i].key);
+    }
+    if (keep && frame->isElement && schema->finish) {
+        keep = schema->finish(frame->target, decoder->context, &decoder->error);
+        if (decoder->error)
+            return false;
+    }
+    --decoder->depth;
+    if (frame->isElement && frame->field->type == MD_JSON_ARRAY) {
+        if (keep)
+            ++decoder->frames[decoder->depth - 1].array->len;
+        else if (schema->cleanup)
+            schema->cleanup(frame->target);
+    }
+    return true;
+}
+
+static bool md_json_decoder_key(void *data, cchar *key, JsonLength len) {
+    MDJsonDecoder *decoder = data;
+    if (decoder->skip)
+        return true;
+    MDJsonDecoderFrame *frame = &decoder->frames[decoder->depth - 1];
+    decoder->field = NULL;
+    decoder->capture = NULL;
+    if (frame->field && !frame->drop) {
+        const MDJsonSchema *schema = frame->field->schema;
+        for (int i = 0; i < schema->count; ++i) {
+            if (!strcmp(schema->fields[i].key, key)) {
+                if (!(frame->seen & 1ULL << i)) {
+                    frame->seen |= 1ULL << i;
+                    decoder->field = &schema->fields[i];
+                }
+                break;
+            }
+        }
+    }
+    if (!decoder->field && decoder->depth == 1) {
+        if (!strcmp(key, MD_JSON_EXCEPTION_KEY) && !decoder->exception)
+            decoder->capture = &decoder->exception;
+        else if (!strcmp(key, MD_JSON_MESSAGE_KEY) && !decoder->message)
+            decoder->capture = &decoder->message;
+    }
+    return true;
+}
+
+// md_json_decoder_copy returns allocated copy of the string value.
+static char *md_json_decoder_copy(MDJsonDecoder *decoder, Json *value) {
+    char *copy = md_malloc(value->len + 1, &decoder->error);
+    if (copy)
+        memcpy(copy, value->str, value->len + 1);
+    return copy;
+}
+
+static bool md_json_decoder_value(void *data, Json *value) {
+    MDJsonDecoder *decoder = data;
+    if (decoder->skip)
+        return true;
+    if (!decoder->depth)
+        return md_json_decoder_fail(decoder, MD_ERR_INVALID_JSON_VALUE, MD_JSON_ROOT_KEY);
+    MDJsonDecoderFrame *frame = &decoder->frames[decoder->depth - 1];
+    if (frame->isArray)
+        return md_json_decoder_fail(decoder, MD_ERR_INVALID_JSON_VALUE, frame->field->key);
+    if (decoder->capture) {
+        if (value->type == JSON_STRING)
+            *decoder->capture = md_json_decoder_copy(decoder, value);
+        decoder->capture = NULL;
+        return !decoder->error;
+    }
+
+    const MDJsonField *field = decoder->field;
+    decoder->field = NULL;
+    if (!field)
+        return true;
+    void *target = frame->target + field->offset;
+    JsonType expected = JSON_NUMBER;
+    switch (field->type) {
+        case MD_JSON_INT:
+            if (value->type == JSON_NUMBER)
+                *(int *)target = json_integer(value);
+            break;
+        case MD_JSON_LONG:
+            if (value->type == JSON_NUMBER)
+                *(long *)target = json_integer(value);
+            break;
+        case MD_JSON_TIME:
+            if (value->type == JSON_NUMBER)
+                *(time_t *)target = json_integer(value);
+            break;
+        case MD_JSON_BOOL:
+            expected = JSON_BOOLEAN;
+            if (value->type == JSON_BOOLEAN)
+                *(bool *)target = value->boolean;
+            break;
+        case MD_JSON_STRING:
+            expected = value->type == JSON_NULL ? JSON_NULL : JSON_STRING;
+            if (value->type == expected) {
+                free(*(char **)target);
+                *(char **)target = expected == JSON_STRING ? md_json_decoder_copy(decoder, value) : NULL;
+                if (decoder->error)
+                    return false;
+            }
+            break;
+        case MD_JSON_CUSTOM:
+            expected = value->type;
+            if (!field->set(frame->target, value, &decoder->error))
+                frame->drop = true;
+            if (decoder->error)
+                return md_json_decoder_fail(decoder, decoder->error, field->key);
+            break;
+        default:
+            // Objects and arrays can't be scalars, not even null.
+            expected = JSON_OBJECT;
+            break;
+    }
+    if (value->type != expected)
+        return md_json_decoder_fail(decoder, MD_ERR_INVALID_JSON_VALUE, field->key);
+    return true;
+}
+
+void md_json_decoder_finish(MDJsonDecoder *decoder, MDError *error) {
+    if (decoder->exception) {
+        md_error_set_message(decoder->message ? decoder->message : decoder->exception);
+        *error = MD_ERR_MOODLE_EXCEPTION;
+    } else if (decoder->error) {
+        *error = decoder->error;
+    } else if (!*error && decoder->mismatch) {
+        md_error_set_message(MD_JSON_ROOT_KEY);
+        *error = MD_ERR_INVALID_JSON_VALUE;
+    }
+    md_json_decoder_cleanup(decoder);
+}
+
+void md_json_decoder_cleanup(MDJsonDecoder *decoder) {
+    for (int i = decoder->depth; i > 0; --i) {
+        MDJsonDecoderFrame *frame = &decoder->frames[i - 1];
+        if (frame->isElement && frame->field->type == MD_JSON_ARRAY && frame->field->schema->cleanup)
+            frame->field->schema->cleanup(frame->target);
+    }
+    decoder->depth = decoder->skip = 0;
+    free(decoder->exception);
+    free(decoder->message);
+    decoder->exception = decoder->message = NULL;
+}
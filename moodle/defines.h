@@ -7,7 +7,8 @@
  * For the users of library convenience, it was decided to add customisible
  * fields to every exposed struct of moodle library. The name of the fields needs
  * to be defined at compile time (e. g. -DMD_CUSTOM_FIELD_ARRAY=data) and it
- * will have type of void *. No fields are added by default.
+ * will have type of void *. No fields are added by default. The custom field
+ * of MDRichText is set to NULL whenever one is created.
 */
 
 #ifndef __DEFINES_H
@@ -0,0 +1,872 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Part of moodle library (background downloading of files). See moodle.h
+ *
+ * The downloader thread drives all the transfers using a single curl multi
+ * handle. A download starts with a HEAD request, which tells the size of the
+ * file and whether the server supports ranges. The file is then split into
+ * segments, each transferred with a range request to its own partial file, so
+ * that a segment can resume from the size of its partial file and no segment
+ * has to seek. Once all the segments are done, the partial files are joined.
+ * Partial files are only resumed if the file on the server is still the same
+ * version, as told by the validators of the HEAD response (ETag and
+ * Last-Modified) and the size and time of the file, which are kept in an info
+ * file next to them. Ranges are also requested with If-Range, so that a file
+ * changed after the HEAD request is sent whole instead of mixing versions. A
+ * download of several segments then fails and drops its partial files.
+ *
+ * Downloads are kept in a list guarded by the mutex, along with their
+ * reported progress. The rest of a download is only used by the thread until
+ * the download is done or has failed, and only by md_downloader_poll after.
+ *
+ * Mirroring a course walks its files and only adds downloads of the ones
+ * missing locally. Downloaded files get the modification time of the file on
+ * the server, so that a file of the same size and time is known to be up to
+ * date without reading it.
+ */
+
+#include <curl/curl.h>
+#include <ctype.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include "internal.h"
+#include "thread.h"
+
+#define MD_DOWNLOAD_PARALLEL 2  // downloads transferred at once by default.
+#define MD_DOWNLOAD_MAX_PARALLEL 16
+#define MD_DOWNLOAD_MAX_SEGMENTS 4
+// Files are only split into segments of at least MD_DOWNLOAD_SEGMENT_SIZE
+// bytes, as smaller ones gain nothing from parallel transfers.
+#define MD_DOWNLOAD_SEGMENT_SIZE (8LL * 1024 * 1024)
+#define MD_DOWNLOAD_CONNECT_TIMEOUT 30  // in seconds.
+// MD_DOWNLOAD_STALL_TIMEOUT is the time in seconds after which a transfer
+// receiving nothing fails.
+#define MD_DOWNLOAD_STALL_TIMEOUT 60
+#define MD_DOWNLOAD_POLL_TIMEOUT 100  // in milliseconds.
+#define MD_DOWNLOAD_COPY_SIZE (64 * 1024)
+#define MD_DOWNLOAD_RANGES_HEADER "accept-ranges: bytes"
+#define MD_DOWNLOAD_ETAG_HEADER "etag:"
+#define MD_DOWNLOAD_LAST_MODIFIED_HEADER "last-modified:"
+#define MD_DOWNLOAD_VALIDATOR_SIZE 256  // longer validators are ignored.
+#define MD_DOWNLOAD_INFO_SIZE 1024
+#define MD_DOWNLOAD_INFO_SUFFIX ".partinfo"
+// Files submitted to a module are mirrored into a folder of this name inside
+// the folder of the module.
+#define MD_MIRROR_SUBMISSION_FOLDER "submission"
+// Characters replaced in names of mirrored files and folders, as they are not
+// allowed in file names on some systems.
+#define MD_MIRROR_RESERVED_CHARS "/\\:*?\"<>|"
+
+typedef struct MDDownload MDDownload;
+
+// MDSegment is a range of a file, which is transferred to its own partial file.
+typedef struct MDSegment {
+    MDDownload *download;
+    char *path;  // of the partial file.
+    FILE *file;
+    CURL *handle;
+    struct curl_slist *headers;  // of the transfer, while it runs.
+    long long start, end;  // range of the file, end is -1 if the size is unknown.
+    long long received;    // bytes in the partial file.
+    bool ranged;           // a range was requested.
+    bool checked;          // the response code was checked.
+    bool done;
+} MDSegment;
+
+struct MDDownload {
+    MDDownload *next;
+    char *url, *filename;
+    time_t timeModified;  // set to the file once it's downloaded, unless 0.
+    long fileSize;        // as told by moodle, may be 0 if not known.
+    CURL *probe;          // the HEAD request, while it runs.
+    bool ranges;  // whether the server supports ranges.
+    // Validators of the file from the HEAD request, empty if not sent.
+    char etag[MD_DOWNLOAD_VALIDATOR_SIZE], lastModified[MD_DOWNLOAD_VALIDATOR_SIZE];
+    bool resume;     // partial files are of the same version of the file.
+    bool discard;    // partial files are of a mix of versions, see md_download_stop.
+    char *infoPath;  // of the file describing the version of partial files.
+    long long size;
+    MDSegment segments[MD_DOWNLOAD_MAX_SEGMENTS];
+    int segmentCount;
+    MDError error;
+    char *message;  // details of the error.
+    MDDownloadProgress progress;  // guarded by the mutex.
+    bool changed;                 // guarded by the mutex.
+};
+
+struct MDDownloader {
+    MDClient *client;
+    CURLM *multi;
+    void *thread, *mutex;
+    atomic_bool stop;
+    atomic_int parallel;
+    int nextId;                                    // guarded by the mutex.
+    MDDownload *first, *last;                      // guarded by the mutex.
+    MDDownload *active[MD_DOWNLOAD_MAX_PARALLEL];  // only used by the thread.
+};
+
+// md_download_fail sets the error of the download, if it has none yet.
+static void md_download_fail(MDDownload *download, MDError error, cchar *message) {
+    if (download->error)
+        return;
+    download->error = error;
+    MDError ignored = MD_ERR_NONE;
+    download->message = clone_str(message, &ignored);
+}
+
+static void md_download_free(MDDownload *download) {
+    for (int i = 0; i < MD_DOWNLOAD_MAX_SEGMENTS; ++i)
+        free(download->segments[i].path);
+    free(download->url);
+    free(download->filename);
+    free(download->infoPath);
+    free(download->message);
+    free(download);
+}
+
+// md_segment_open opens the partial file of the segment, keeping the data
+// already in it, unless truncate is set.
+static bool md_segment_open(MDSegment *segment, bool truncate) {
+    if (segment->file)
+        fclose(segment->file);
+    segment->file = fopen(segment->path, truncate ? "wb" : "ab");
+    segment->received = 0;
+    if (!segment->file) {
+        md_download_fail(segment->download, MD_ERR_FILE_OPERATION, segment->path);
+        return false;
+    }
+    if (!truncate && !fseek(segment->file, 0, SEEK_END)) {
+        long size = ftell(segment->file);
+        segment->received = size > 0 ? size : 0;
+    }
+    return true;
+}
+
+static size_t md_segment_write(void *contents, size_t size, size_t nmemb, void *data) {
+    MDSegment *segment = data;
+    size_t bytes = size * nmemb;
+    if (!segment->checked) {
+        segment->checked = true;
+        long code = 0;
+        curl_easy_getinfo(segment->handle, CURLINFO_RESPONSE_CODE, &code);
+        if (segment->ranged && code != 206) {
+            // The range was ignored, so the whole file is coming. Either the
+            // server doesn't support ranges after all, or the file has changed
+            // (see md_segment_set_if_range), so other segments may hold a
+            // different version. That's only of use to a single segment.
+            if (segment->download->segmentCount > 1) {
+                segment->download->discard = true;
+                md_download_fail(segment->download, MD_ERR_HTTP_REQUEST_FAIL, "range not satisfied");
+                return 0;
+            }
+            segment->ranged = false;
+            if (!md_segment_open(segment, true))
+                return 0;
+        }
+    }
+    if (segment->ranged && segment->end >= 0) {
+        // The server may send more than asked, which belongs to the next
+        // segment.
+        long long left = segment->end - segment->start - segment->received;
+        bytes = (long long)bytes > left ? (left > 0 ? left : 0) : bytes;
+    }
+    if (bytes && fwrite(contents, 1, bytes, segment->file) != bytes) {
+        md_download_fail(segment->download, MD_ERR_FILE_OPERATION, segment->path);
+        return 0;
+    }
+    segment->received += bytes;
+    return size * nmemb;
+}
+
+// md_header_matches returns true if the header starts with expected, which
+// must be lower case, ignoring case of the header.
+static bool md_header_matches(cchar *header, size_t len, cchar *expected) {
+    size_t expectedLen = strlen(expected);
+    bool match = len >= expectedLen;
+    for (size_t i = 0; i < expectedLen && match; ++i)
+        match = tolower((unsigned char)header[i]) == expected[i];
+    return match;
+}
+
+// md_header_value copies the value of the header after the name of given
+// length to value, without surrounding whitespace. The value is left empty if
+// it does not fit.
+static void md_header_value(cchar *header, size_t len, size_t nameLen, char *value) {
+    size_t begin = nameLen, end = len;
+    while (begin < end && isspace((unsigned char)header[begin]))
+        ++begin;
+    while (end > begin && isspace((unsigned char)header[end - 1]))
+        --end;
+    value[0] = '\0';
+    if (end - begin < MD_DOWNLOAD_VALIDATOR_SIZE) {
+        memcpy(value, header + begin, end - begin);
+        value[end - begin] = '\0';
+    }
+}
+
+// md_download_header looks for the header telling that the server supports
+// ranges and for the validators of the file. Headers of every response (e. g.
+// redirects) are seen, so the status line starts over.
+static size_t md_download_header(char *header, size_t size, size_t nmemb, void *data) {
+    MDDownload *download = data;
+    size_t len = size * nmemb;
+    if (len >= 5 && !strncmp(header, "HTTP/", 5)) {
+        download->ranges = false;
+        download->etag[0] = download->lastModified[0] = '\0';
+    } else if (md_header_matches(header, len, MD_DOWNLOAD_RANGES_HEADER)) {
+        download->ranges = true;
+    } else if (md_header_matches(header, len, MD_DOWNLOAD_ETAG_HEADER)) {
+        md_header_value(header, len, strlen(MD_DOWNLOAD_ETAG_HEADER), download->etag);
+    } else if (md_header_matches(header, len, MD_DOWNLOAD_LAST_MODIFIED_HEADER)) {
+        md_header_value(header, len, strlen(MD_DOWNLOAD_LAST_MODIFIED_HEADER), download->lastModified);
+    }
+    return len;
+}
+
+static size_t md_download_discard(void *contents, size_t size, size_t nmemb, void *data) {
+    return size * nmemb;
+}
+
+// md_downloader_create_curl creates a handle for a transfer of the download,
+// with timeouts for transfers which stall.
+static CURL *md_downloader_create_curl(MDDownloader *downloader, MDDownload *download, void *data, WriteCallback callback) {
+    MDError error = MD_ERR_NONE;
+    CURL *handle = create_curl(downloader->client->pool, download->url, data, callback, &error);
+    if (!handle) {
+        md_download_fail(download, error, "");
+        return NULL;
+    }
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, (long)MD_DOWNLOAD_CONNECT_TIMEOUT);
+    curl_easy_setopt(handle, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(handle, CURLOPT_LOW_SPEED_TIME, (long)MD_DOWNLOAD_STALL_TIMEOUT);
+    return handle;
+}
+
+// md_downloader_add_handle adds the handle to the transfers, releasing it on
+// failure.
+static CURL *md_downloader_add_handle(MDDownloader *downloader, MDDownload *download, CURL *handle) {
+    if (handle && curl_multi_add_handle(downloader->multi, handle) != CURLM_OK) {
+        release_curl(downloader->client->pool, handle);
+        md_download_fail(download, MD_ERR_CURL_FAIL, "");
+        handle = NULL;
+    }
+    return handle;
+}
+
+static void md_downloader_remove_handle(MDDownloader *downloader, CURL **handle) {
+    if (*handle) {
+        curl_multi_remove_handle(downloader->multi, *handle);
+        release_curl(downloader->client->pool, *handle);
+        *handle = NULL;
+    }
+}
+
+static void md_segment_remove_handle(MDDownloader *downloader, MDSegment *segment) {
+    md_downloader_remove_handle(downloader, &segment->handle);
+    curl_slist_free_all(segment->headers);
+    segment->headers = NULL;
+}
+
+// md_segment_set_if_range makes the range request of the segment conditional
+// on the file being the version seen by the HEAD request, so that a changed
+// file is sent whole (and fails the segment unless it's the first one).
+// Strong ETags are preferred, as weak ones can't be used with If-Range.
+static void md_segment_set_if_range(MDSegment *segment, CURL *handle) {
+    MDDownload *download = segment->download;
+    cchar *validator = download->etag[0] && strncmp(download->etag, "W/", 2) ? download->etag : download->lastModified;
+    if (!validator[0])
+        return;
+    char header[sizeof("If-Range: ") + MD_DOWNLOAD_VALIDATOR_SIZE];
+    sprintf(header, "If-Range: %s", validator);
+    segment->headers = curl_slist_append(NULL, header);
+    if (segment->headers)
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, segment->headers);
+}
+
+static void md_segment_start(MDDownloader *downloader, MDSegment *segment) {
+    MDDownload *download = segment->download;
+    // Partial files are only of use if the transfer can continue after them
+    // and they are of the same version of the file.
+    if (!md_segment_open(segment, !download->ranges || !download->resume))
+        return;
+    long long length = segment->end - segment->start;
+    if (segment->end >= 0 && segment->received > length && !md_segment_open(segment, true))
+        return;
+    if (segment->end >= 0 && segment->received == length) {
+        segment->done = true;
+        return;
+    }
+
+    CURL *handle = md_downloader_create_curl(downloader, download, segment, md_segment_write);
+    if (!handle)
+        return;
+    segment->ranged = segment->received || download->segmentCount > 1;
+    if (segment->ranged) {
+        char range[64];
+        if (segment->end >= 0)
+            sprintf(range, "%lld-%lld", segment->start + segment->received, segment->end - 1);
+        else
+            sprintf(range, "%lld-", segment->received);
+        curl_easy_setopt(handle, CURLOPT_RANGE, range);
+        md_segment_set_if_range(segment, handle);
+    }
+    if (download->segmentCount > 1) {
+        // Multiplexed transfers would share a single connection, while the
+        // point of segments is to use several.
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_1_1);
+        curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 0L);
+    }
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, segment);
+    segment->checked = false;
+    segment->handle = md_downloader_add_handle(downloader, download, handle);
+}
+
+// md_download_describe writes the version of the file to info, returning false
+// if nothing identifies the version, besides the size.
+static bool md_download_describe(MDDownload *download, char *info) {
+    snprintf(info, MD_DOWNLOAD_INFO_SIZE, "size %lld\nfilesize %ld\ntime %lld\netag %s\nlast-modified %s\n",
+             download->size, download->fileSize, (long long)download->timeModified, download->etag,
+             download->lastModified);
+    return download->etag[0] || download->lastModified[0] || download->timeModified;
+}
+
+// md_download_check_parts sets whether the partial files left by an earlier
+// download may be resumed, which is only if they are of the same version of
+// the file, and records the version of the partial files of this download.
+static void md_download_check_parts(MDDownload *download) {
+    char info[MD_DOWNLOAD_INFO_SIZE], old[MD_DOWNLOAD_INFO_SIZE];
+    bool known = md_download_describe(download, info);
+    download->resume = false;
+    download->infoPath = md_malloc(strlen(download->filename) + sizeof(MD_DOWNLOAD_INFO_SUFFIX), &download->error);
+    if (!download->infoPath)
+        return;
+    sprintf(download->infoPath, "%s%s", download->filename, MD_DOWNLOAD_INFO_SUFFIX);
+    FILE *file = fopen(download->infoPath, "rb");
+    if (file) {
+        size_t read = fread(old, 1, sizeof(old) - 1, file);
+        old[read] = '\0';
+        download->resume = known && !strcmp(info, old);
+        fclose(file);
+    }
+    // Without a version to compare, partial files are never resumed.
+    file = known ? fopen(download->infoPath, "wb") : NULL;
+    bool saved = file && fputs(info, file) != EOF;
+    saved = file && !fclose(file) && saved;
+    if (!saved)
+        remove(download->infoPath);
+}
+
+// md_download_split splits the file into segments, once its size is known,
+// and starts them.
+static void md_download_split(MDDownloader *downloader, MDDownload *download) {
+    long long size = download->size;
+    md_download_check_parts(download);
+    int count = 1;
+    if (download->ranges && size >= 2 * MD_DOWNLOAD_SEGMENT_SIZE) {
+        count = size / MD_DOWNLOAD_SEGMENT_SIZE;
+        count = count > MD_DOWNLOAD_MAX_SEGMENTS ? MD_DOWNLOAD_MAX_SEGMENTS : count;
+    }
+    download->segmentCount = count;
+    for (int i = 0; i < count && !download->error; ++i) {
+        MDSegment *segment = &download->segments[i];
+        segment->start = size < 0 ? 0 : size * i / count;
+        segment->end = size < 0 ? -1 : size * (i + 1) / count;
+        segment->path = md_malloc(strlen(download->filename) + sizeof(".part") + 12, &download->error);
+        if (!segment->path)
+            break;
+        sprintf(segment->path, "%s.part%d", download->filename, i);
+        md_segment_start(downloader, segment);
+    }
+}
+
+static void md_download_start(MDDownloader *downloader, MDDownload *download) {
+    CURL *handle = md_downloader_create_curl(downloader, download, NULL, md_download_discard);
+    if (!handle)
+        return;
+    curl_easy_setopt(handle, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, md_download_header);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, download);
+    download->probe = md_downloader_add_handle(downloader, download, handle);
+}
+
+// md_download_probed starts the segments once the HEAD request is done.
+static void md_download_probed(MDDownloader *downloader, MDDownload *download, CURLcode result) {
+    curl_off_t size = -1;
+    if (result == CURLE_OK) {
+        curl_easy_getinfo(download->probe, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &size);
+    } else {
+        // Some servers refuse HEAD requests, so the file is just downloaded
+        // as a whole, which also reports the actual error if there's one.
+        download->ranges = false;
+    }
+    download->size = size;
+    md_downloader_remove_handle(downloader, &download->probe);
+    md_download_split(downloader, download);
+}
+
+static void md_segment_finish(MDDownloader *downloader, MDSegment *segment, CURLcode result) {
+    MDDownload *download = segment->download;
+    md_segment_remove_handle(downloader, segment);
+    if (result != CURLE_OK)
+        md_download_fail(download, MD_ERR_HTTP_REQUEST_FAIL, curl_easy_strerror(result));
+    else if (segment->ranged && segment->end >= 0 && segment->received != segment->end - segment->start)
+        md_download_fail(download, MD_ERR_HTTP_REQUEST_FAIL, "incomplete response");
+    segment->done = !download->error;
+}
+
+// md_download_remove_info removes the info file of partial files, once there
+// are none.
+static void md_download_remove_info(MDDownload *download) {
+    if (download->infoPath)
+        remove(download->infoPath);
+}
+
+// md_download_join joins the partial files into the file, removing them.
+static void md_download_join(MDDownload *download) {
+    for (int i = 0; i < download->segmentCount; ++i) {
+        MDSegment *segment = &download->segments[i];
+        if (segment->file && fclose(segment->file))
+            md_download_fail(download, MD_ERR_FILE_OPERATION, segment->path);
+        segment->file = NULL;
+    }
+    if (download->error)
+        return;
+    if (download->segmentCount == 1) {
+#ifdef _WIN32
+        // Rename does not replace existing files on windows.
+        remove(download->filename);
+#endif
+        if (rename(download->segments[0].path, download->filename))
+            md_download_fail(download, MD_ERR_FILE_OPERATION, download->filename);
+        else
+            md_download_remove_info(download);
+        return;
+    }
+
+    FILE *file = fopen(download->filename, "wb");
+    char *buffer = md_malloc(MD_DOWNLOAD_COPY_SIZE, &download->error);
+    if (!file)
+        md_download_fail(download, MD_ERR_FILE_OPERATION, download->filename);
+    for (int i = 0; i < download->segmentCount && !download->error; ++i) {
+        FILE *part = fopen(download->segments[i].path, "rb");
+        size_t read = 0;
+        while (part && (read = fread(buffer, 1, MD_DOWNLOAD_COPY_SIZE, part))) {
+            if (fwrite(buffer, 1, read, file) != read)
+                break;
+        }
+        if (!part || read || ferror(part))
+            md_download_fail(download, MD_ERR_FILE_OPERATION, download->filename);
+        if (part)
+            fclose(part);
+    }
+    if (file && fclose(file))
+        md_download_fail(download, MD_ERR_FILE_OPERATION, download->filename);
+    free(buffer);
+    for (int i = 0; i < download->segmentCount && !download->error; ++i)
+        remove(download->segments[i].path);
+    if (!download->error)
+        md_download_remove_info(download);
+}
+
+// md_download_set_time sets the modification time of the downloaded file to
+// the one of the file on the server. Failures are ignored, as the file is
+// downloaded either way and would only be downloaded again when mirroring.
+static void md_download_set_time(MDDownload *download) {
+    struct utimbuf times = {.actime = download->timeModified, .modtime = download->timeModified};
+    utime(download->filename, &times);
+}
+
+// md_download_stop stops all the transfers of the download, keeping the
+// partial files which have some data, unless they are to be discarded.
+static void md_download_stop(MDDownloader *downloader, MDDownload *download) {
+    md_downloader_remove_handle(downloader, &download->probe);
+    bool kept = false;
+    for (int i = 0; i < download->segmentCount; ++i) {
+        MDSegment *segment = &download->segments[i];
+        md_segment_remove_handle(downloader, segment);
+        if (segment->file)
+            fclose(segment->file);
+        if (segment->path && (download->discard || (segment->file && !segment->received)))
+            remove(segment->path);
+        kept = kept || (segment->received && !download->discard);
+        segment->file = NULL;
+    }
+    if (!kept)
+        md_download_remove_info(download);
+}
+
+// md_download_update finishes the download if it has failed or all its
+// segments are done, and publishes its progress. Returns true if it's
+// finished.
+static bool md_download_update(MDDownloader *downloader, MDDownload *download) {
+    MDDownloadState state = MD_DOWNLOAD_ACTIVE;
+    bool done = !download->probe && download->segmentCount > 0;
+    for (int i = 0; i < download->segmentCount; ++i)
+        done = done && download->segments[i].done;
+    if (done && !download->error)
+        md_download_join(download);
+    if (done && !download->error && download->timeModified)
+        md_download_set_time(download);
+    if (download->error) {
+        md_download_stop(downloader, download);
+        state = MD_DOWNLOAD_FAILED;
+    } else if (done) {
+        state = MD_DOWNLOAD_DONE;
+    }
+
+    long long received = 0;
+    for (int i = 0; i < download->segmentCount; ++i)
+        received += download->segments[i].received;
+    th_mutex_lock(downloader->mutex);
+    MDDownloadProgress *progress = &download->progress;
+    if (progress->state != state || progress->received != received || progress->size != download->size ||
+        progress->segments != download->segmentCount) {
+        progress->state = state;
+        progress->received = received;
+        progress->size = download->size;
+        progress->segments = download->segmentCount;
+        progress->error = download->error;
+        download->changed = true;
+    }
+    th_mutex_unlock(downloader->mutex);
+    return state != MD_DOWNLOAD_ACTIVE;
+}
+
+// md_downloader_start_queued starts queued downloads while there's room.
+static void md_downloader_start_queued(MDDownloader *downloader) {
+    MDDownload *started[MD_DOWNLOAD_MAX_PARALLEL] = {NULL};
+    int room = atomic_load(&downloader->parallel);
+    for (int i = 0; i < MD_DOWNLOAD_MAX_PARALLEL; ++i)
+        room -= downloader->active[i] != NULL;
+    th_mutex_lock(downloader->mutex);
+    MDDownload *download = downloader->first;
+    for (int i = 0; i < MD_DOWNLOAD_MAX_PARALLEL && room > 0; ++i) {
+        if (downloader->active[i])
+            continue;
+        while (download && download->progress.state != MD_DOWNLOAD_QUEUED)
+            download = download->next;
+        if (!download)
+            break;
+        download->progress.state = MD_DOWNLOAD_ACTIVE;
+        download->changed = true;
+        downloader->active[i] = started[i] = download;
+        --room;
+    }
+    th_mutex_unlock(downloader->mutex);
+    for (int i = 0; i < MD_DOWNLOAD_MAX_PARALLEL; ++i) {
+        if (started[i])
+            md_download_start(downloader, started[i]);
+    }
+}
+
+static void md_downloader_run(void *data) {
+    MDDownloader *downloader = data;
+    while (!atomic_load(&downloader->stop)) {
+        md_downloader_start_queued(downloader);
+        int running;
+        curl_multi_perform(downloader->multi, &running);
+        CURLMsg *msg;
+        int left;
+        while ((msg = curl_multi_info_read(downloader->multi, &left))) {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+            bool probe = false;
+            for (int i = 0; i < MD_DOWNLOAD_MAX_PARALLEL && !probe; ++i) {
+                MDDownload *download = downloader->active[i];
+                if ((probe = download && download->probe == msg->easy_handle))
+                    md_download_probed(downloader, download, msg->data.result);
+            }
+            MDSegment *segment = NULL;
+            if (!probe && curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&segment) == CURLE_OK && segment)
+                md_segment_finish(downloader, segment, msg->data.result);
+        }
+        for (int i = 0; i < MD_DOWNLOAD_MAX_PARALLEL; ++i) {
+            if (downloader->active[i] && md_download_update(downloader, downloader->active[i]))
+                downloader->active[i] = NULL;
+        }
+        curl_multi_poll(downloader->multi, NULL, 0, MD_DOWNLOAD_POLL_TIMEOUT, NULL);
+    }
+    for (int i = 0; i < MD_DOWNLOAD_MAX_PARALLEL; ++i) {
+        if (downloader->active[i])
+            md_download_stop(downloader, downloader->active[i]);
+    }
+}
+
+MDDownloader *md_downloader_new(MDClient *client, MDError *error) {
+    *error = MD_ERR_NONE;
+    MDDownloader *downloader = md_malloc(sizeof(MDDownloader), error);
+    if (!downloader)
+        return NULL;
+    downloader->client = client;
+    downloader->multi = md_http_pool_take_multi(client->pool, error);
+    downloader->mutex = th_mutex_new();
+    downloader->thread = NULL;
+    atomic_init(&downloader->stop, false);
+    atomic_init(&downloader->parallel, MD_DOWNLOAD_PARALLEL);
+    downloader->nextId = 0;
+    downloader->first = downloader->last = NULL;
+    for (int i = 0; i < MD_DOWNLOAD_MAX_PARALLEL; ++i)
+        downloader->active[i] = NULL;
+    if (!*error && downloader->mutex)
+        downloader->thread = th_create(md_downloader_run, downloader);
+    if (!downloader->thread) {
+        if (!*error)
+            *error = MD_ERR_ALLOC;
+        md_downloader_cleanup(downloader);
+        downloader = NULL;
+    }
+    return downloader;
+}
+
+int md_downloader_add(MDDownloader *downloader, MDFile *file, cchar *filename, bool *queued, MDError *error) {
+    *error = MD_ERR_NONE;
+    if (queued)
+        *queued = false;
+    MDDownload *download = md_malloc(sizeof(MDDownload), error);
+    if (!download)
+        return -1;
+    memset(download, 0, sizeof(MDDownload));
+    cchar *token = downloader->client->token;
+    download->url = md_malloc(strlen(file->url) + strlen(token) + sizeof("?token="), error);
+    if (download->url)
+        sprintf(download->url, "%s?token=%s", file->url, token);
+    download->filename = clone_str(filename, error);
+    if (*error) {
+        md_download_free(download);
+        return -1;
+    }
+    download->size = -1;
+    download->timeModified = file->timeModified;
+    download->fileSize = file->filesize;
+    for (int i = 0; i < MD_DOWNLOAD_MAX_SEGMENTS; ++i)
+        download->segments[i].download = download;
+
+    th_mutex_lock(downloader->mutex);
+    // Two downloads to the same file would write to the same partial files, so
+    // the file is only added if it's not being downloaded already.
+    MDDownload *same = downloader->first;
+    while (same && strcmp(same->filename, download->filename))
+        same = same->next;
+    int id = same ? same->progress.id : downloader->nextId++;
+    if (!same) {
+        download->progress = (MDDownloadProgress){
+            .id = id,
+            .filename = download->filename,
+            .state = MD_DOWNLOAD_QUEUED,
+            .received = 0,
+            .size = -1,
+            .segments = 0,
+            .error = MD_ERR_NONE,
+        };
+        download->changed = true;
+        if (downloader->last)
+            downloader->last->next = download;
+        else
+            downloader->first = download;
+        downloader->last = download;
+    }
+    th_mutex_unlock(downloader->mutex);
+    if (queued)
+        *queued = !same;
+    if (same)
+        md_download_free(download);
+    else
+        curl_multi_wakeup(downloader->multi);
+    return id;
+}
+
+void md_downloader_set_parallel(MDDownloader *downloader, int count) {
+    count = count < 1 ? 1 : count > MD_DOWNLOAD_MAX_PARALLEL ? MD_DOWNLOAD_MAX_PARALLEL : count;
+    atomic_store(&downloader->parallel, count);
+    curl_multi_wakeup(downloader->multi);
+}
+
+int md_downloader_poll(MDDownloader *downloader, MDDownloadCallback callback, void *data) {
+    int calls = 0;
+    for (;;) {
+        // The lock isn't held during the callback, so that it may add
+        // downloads.
+        th_mutex_lock(downloader->mutex);
+        MDDownload *previous = NULL, *download = downloader->first;
+        while (download && !download->changed) {
+            previous = download;
+            download = download->next;
+        }
+        MDDownloadProgress progress;
+        bool finished = false;
+        if (download) {
+            download->changed = false;
+            progress = download->progress;
+            finished = progress.state == MD_DOWNLOAD_DONE || progress.state == MD_DOWNLOAD_FAILED;
+        }
+        if (finished) {
+            // The thread is done with the download, so it's taken off the
+            // list.
+            if (previous)
+                previous->next = download->next;
+            else
+                downloader->first = download->next;
+            if (downloader->last == download)
+                downloader->last = previous;
+        }
+        th_mutex_unlock(downloader->mutex);
+        if (!download)
+            break;
+
+        if (progress.state == MD_DOWNLOAD_FAILED)
+            md_error_set_message(download->message ? download->message : "");
+        callback(data, &progress);
+        ++calls;
+        if (finished)
+            md_download_free(download);
+    }
+    return calls;
+}
+
+// md_mirror_join returns allocated path to the entry of given name in the
+// folder, with the characters not allowed in file names replaced.
+static char *md_mirror_join(cchar *folder, cchar *name, MDError *error) {
+    name = name && *name ? name : "_";
+    size_t len = strlen(folder);
+    char *path = md_malloc(len + strlen(name) + 2, error);
+    if (!path)
+        return NULL;
+    char *entry = path + len + 1;
+    sprintf(path, "%s/%s", folder, name);
+    for (char *c = entry; *c; ++c) {
+        if ((unsigned char)*c < ' ' || strchr(MD_MIRROR_RESERVED_CHARS, *c))
+            *c = '_';
+    }
+    // Names can't be special folders or end with dots on windows.
+    if (!strcmp(entry, ".") || !strcmp(entry, ".."))
+        *entry = '_';
+    for (char *c = entry + strlen(entry) - 1; c > entry && (*c == '.' || *c == ' '); --c)
+        *c = '_';
+    return path;
+}
+
+// md_mirror_make_folders creates the folders of the path, starting with the
+// one of its first rootLen characters. Errors are ignored, as the folders most
+// likely exist already. Otherwise the download fails to open its file.
+static void md_mirror_make_folders(char *path, size_t rootLen) {
+    for (char *c = path + rootLen; (c = strchr(c, '/')); ++c) {
+        *c = '\0';
+#ifdef _WIN32
+        _mkdir(path);
+#else
+        mkdir(path, 0755);
+#endif
+        *c = '/';
+    }
+}
+
+// md_mirror_is_current returns true if the file at the path has the size and
+// modification time of the file on the server.
+static bool md_mirror_is_current(cchar *path, MDFile *file) {
+    struct stat info;
+    return !stat(path, &info) && info.st_size == file->filesize &&
+           (!file->timeModified || info.st_mtime == file->timeModified);
+}
+
+// MDMirror is the state of md_downloader_mirror.
+typedef struct MDMirror {
+    MDDownloader *downloader;
+    size_t rootLen;  // of the folder mirrored into.
+    int added;
+} MDMirror;
+
+// md_mirror_files adds downloads of the files into the folder, which are not
+// up to date.
+static void md_mirror_files(MDMirror *mirror, cchar *folder, MDArray files, MDError *error) {
+    for (int i = 0; i < files.len && !*error; ++i) {
+        MDFile *file = &MD_FILES(files)[i];
+        char *path = md_mirror_join(folder, file->filename, error);
+        if (path && !md_mirror_is_current(path, file)) {
+            md_mirror_make_folders(path, mirror->rootLen);
+            // Files mapped to the same path (of the same name in a module, or
+            // in courses of the same name) are only downloaded once.
+            bool queued;
+            md_downloader_add(mirror->downloader, file, path, &queued, error);
+            if (!*error && queued)
+                ++mirror->added;
+        }
+        free(path);
+    }
+}
+
+// md_mirror_module adds downloads of the files of the module and the files
+// submitted to it.
+static void md_mirror_module(MDMirror *mirror, cchar *folder, MDModule *module, MDError *error) {
+    MDArray files = MD_ARRAY_INITIALIZER, submittedFiles = MD_ARRAY_INITIALIZER;
+    switch (module->type) {
+        case MD_MOD_ASSIGNMENT:
+            files = module->contents.assignment.files;
+            submittedFiles = module->contents.assignment.status.submittedFiles;
+            break;
+        case MD_MOD_WORKSHOP:
+            submittedFiles = module->contents.workshop.status.submittedFiles;
+            break;
+        case MD_MOD_RESOURCE:
+            files = module->contents.resource.files;
+            break;
+        default:
+            break;
+    }
+    if (!files.len && !submittedFiles.len)
+        return;
+    char *path = md_mirror_join(folder, module->name, error);
+    if (path)
+        md_mirror_files(mirror, path, files, error);
+    if (path && submittedFiles.len && !*error) {
+        char *submissionPath = md_mirror_join(path, MD_MIRROR_SUBMISSION_FOLDER, error);
+        if (submissionPath)
+            md_mirror_files(mirror, submissionPath, submittedFiles, error);
+        free(submissionPath);
+    }
+    free(path);
+}
+
+int md_downloader_mirror(MDDownloader *downloader, MDCourse *course, cchar *folder, MDError *error) {
+    *error = MD_ERR_NONE;
+    MDMirror mirror = {.downloader = downloader, .rootLen = strlen(folder), .added = 0};
+    char *coursePath = md_mirror_join(folder, course->name, error);
+    for (int i = 0; coursePath && i < course->topics.len && !*error; ++i) {
+        MDTopic *topic = &MD_TOPICS(course->topics)[i];
+        char *topicPath = md_mirror_join(coursePath, topic->name, error);
+        for (int j = 0; topicPath && j < topic->modules.len && !*error; ++j)
+            md_mirror_module(&mirror, topicPath, &MD_MODULES(topic->modules)[j], error);
+        free(topicPath);
+    }
+    free(coursePath);
+    return mirror.added;
+}
+
+void md_downloader_cleanup(MDDownloader *downloader) {
+    if (!downloader)
+        return;
+    if (downloader->thread) {
+        atomic_store(&downloader->stop, true);
+        curl_multi_wakeup(downloader->multi);
+        th_join(downloader->thread);
+    }
+    while (downloader->first) {
+        MDDownload *next = downloader->first->next;
+        md_download_free(downloader->first);
+        downloader->first = next;
+    }
+    md_http_pool_give_multi(downloader->client->pool, downloader->multi);
+    if (downloader->mutex)
+        th_mutex_free(downloader->mutex);
+    free(downloader);
+}
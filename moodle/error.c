@@ -14,9 +14,11 @@
 
 #define MESSAGE_SIZE 4096
 
-char msg[MESSAGE_SIZE] = "";
-char errBuff[MESSAGE_SIZE] = "";
-bool errorHandlingWarningSet = false;
+// Error messages are kept per thread, so that functions of this library can be
+// used from multiple threads at once.
+_Thread_local char msg[MESSAGE_SIZE] = "";
+_Thread_local char errBuff[MESSAGE_SIZE] = "";
+_Thread_local bool errorHandlingWarningSet = false;
 
 struct errorMsg {
     MDError code;
@@ -39,6 +41,7 @@ struct errorMsg {
     {MD_ERR_FAILED_TO_LOAD_PLUGIN, "Failed to load plugin: %s"}, 
     {MD_ERR_MISSING_PLUGIN_VAR, "Missing plugin variable required for a plugin: %s"}, 
     {MD_ERR_INVALID_PLUGIN, "Plugin %s is invalid"}, 
+    {MD_ERR_INVALID_FILE, "Invalid or incompatible file %s"},
 };
 
 void md_set_error_handling_warning() {
@@ -49,6 +52,10 @@ void md_error_set_message(cchar *message) {
     snprintf(msg, MESSAGE_SIZE, "%s", message);
 }
 
+cchar *md_error_get_details() {
+    return msg;
+}
+
 cchar *md_error_get_message(MDError code) {
     errBuff[0] = 0;
     int size = sizeof(errorMessages) / sizeof(struct errorMsg);
@@ -8,6 +8,7 @@
 #define __MT_INTERNAL_H
 
 #include <stdarg.h>
+#include "fmap.h"
 #include "json.h"
 #include "moodle.h"
 #include "auth.h"
@@ -34,19 +35,205 @@ typedef const char cchar;
 // md_error_get_message.
 void md_error_set_message(cchar *message);
 
+// md_error_get_details returns the additional information set using
+// md_error_set_message in the current thread.
+cchar *md_error_get_details();
+
 // md_set_error_handling_warning sets a warning about faulty error handling (see
 // ENSURE_EMPTY_ERROR).
 void md_set_error_handling_warning();
 
+// pool.c
+
+// CURL_MAX_PARALLEL is the maximum number of parallel transfers.
+#define CURL_MAX_PARALLEL 20
+// MD_JSON_MAX_SIZE is the largest json response accepted from the server.
+#define MD_JSON_MAX_SIZE ((size_t)256 * 1024 * 1024)
+
+// MDHttpPool keeps curl handles of a client for reuse, so that connections,
+// DNS lookups and TLS sessions are reused between requests. It may be used
+// from multiple threads at once. Where a pool is expected, NULL may be passed
+// to create a new handle for every request instead.
+typedef struct MDHttpPool MDHttpPool;
+
+// md_http_pool_new creates and returns a new pool, which should be released
+// using md_http_pool_cleanup.
+MDHttpPool *md_http_pool_new(MDError *error);
+
+// md_http_pool_cleanup releases the pool with all its idle handles. Handles
+// taken from it must be given back before.
+void md_http_pool_cleanup(MDHttpPool *pool);
+
+// md_http_pool_take_easy returns an idle easy handle of the pool, or a new
+// one, which must be given back using md_http_pool_give_easy.
+void *md_http_pool_take_easy(MDHttpPool *pool, MDError *error);
+
+// md_http_pool_give_easy resets the handle and keeps it for later requests.
+void md_http_pool_give_easy(MDHttpPool *pool, void *handle);
+
+// md_http_pool_take_multi returns an idle multi handle of the pool, or a new
+// one, which must be given back using md_http_pool_give_multi.
+void *md_http_pool_take_multi(MDHttpPool *pool, MDError *error);
+
+// md_http_pool_give_multi keeps the multi handle (which must have no easy
+// handles added) for later requests.
+void md_http_pool_give_multi(MDHttpPool *pool, void *multi);
+
+// workers.c
+
+// MDTaskFunc is a task run by MDWorkers.
+typedef void (*MDTaskFunc)(void *arg);
+
+// MDWorkers is a pool of worker threads running submitted tasks, one thread
+// per processor by default. Idle workers steal tasks queued to the others.
+typedef struct MDWorkers MDWorkers;
+
+// md_workers_new starts count worker threads (limited to a reasonable number)
+// and returns the pool, which should be released using md_workers_cleanup.
+MDWorkers *md_workers_new(int count, MDError *error);
+
+// md_workers_submit queues the task to run on one of the workers. The task is
+// run right away on the calling thread if workers is NULL or it can't be
+// queued. Tasks may be submitted from any thread, including the workers.
+void md_workers_submit(MDWorkers *workers, MDTaskFunc func, void *arg);
+
+// md_workers_cleanup waits for all the queued tasks to finish and stops the
+// workers.
+void md_workers_cleanup(MDWorkers *workers);
+
+// md_http_pool_get_workers returns the workers of the pool, starting them on
+// the first call. NULL is returned (and tasks are run on the calling thread)
+// if the pool is NULL or the workers can't be started.
+MDWorkers *md_http_pool_get_workers(MDHttpPool *pool);
+
+// decode.c
+
+// MDJsonFieldType is the type of a struct field decoded from json by
+// MDJsonDecoder, along with the type of json value expected for it.
+typedef enum MDJsonFieldType {
+    MD_JSON_INT,     // int (or enum) from a number.
+    MD_JSON_LONG,    // long from a number.
+    MD_JSON_TIME,    // time_t from a number.
+    MD_JSON_BOOL,    // bool from a boolean.
+    MD_JSON_STRING,  // allocated char * from a string, or NULL from null.
+    MD_JSON_OBJECT,  // struct decoded using the schema from an object.
+    MD_JSON_ARRAY,   // MDArray of elements decoded using the schema from an
+                     // array of objects. Elements are appended to the array.
+    MD_JSON_EACH,    // array of objects, which are all decoded using the schema
+                     // into the same struct, being finished one by one.
+    MD_JSON_CUSTOM,  // any value other than object or array, passed to set.
+} MDJsonFieldType;
+
+struct MDJsonSchema;
+
+// MDJsonSetFunc decodes value of a MD_JSON_CUSTOM field into the struct
+// containing the field. It returns false to drop the struct if it's an element
+// of MD_JSON_ARRAY, and sets error if the value is not valid.
+typedef bool (*MDJsonSetFunc)(void *target, Json *value, MDError *error);
+
+// MDJsonField describes how the value of a key of a json object is decoded.
+typedef struct MDJsonField {
+    cchar *key;
+    MDJsonFieldType type;
+    size_t offset;  // of the field in the struct, see offsetof.
+    bool required;  // the key missing is an error (MD_ERR_MISSING_JSON_KEY).
+    const struct MDJsonSchema *schema;  // of MD_JSON_OBJECT, ARRAY and EACH.
+    MDJsonSetFunc set;                  // of MD_JSON_CUSTOM.
+} MDJsonField;
+
+// MDJsonSchema describes how a json object is decoded into a struct. Keys
+// which have no field are skipped, as well as duplicate keys after the first.
+typedef struct MDJsonSchema {
+    size_t size;  // of the struct, for elements of MD_JSON_ARRAY.
+    // init and cleanup are called for elements of MD_JSON_ARRAY (NULL for
+    // nothing). Cleanup is only called for elements which don't end up in the
+    // array.
+    void (*init)(void *element);
+    void (*cleanup)(void *element);
+    // finish, unless NULL, is called with the context of the decoder after an
+    // element of MD_JSON_ARRAY or MD_JSON_EACH is decoded. It may set error,
+    // or return false to drop the element.
+    bool (*finish)(void *element, void *context, MDError *error);
+    const MDJsonField *fields;  // at most 64.
+    int count;
+} MDJsonSchema;
+
+// MD_JSON_SCHEMA expands to the initializer of MDJsonSchema for struct type
+// with given fields array.
+#define MD_JSON_SCHEMA(type, initFunc, cleanupFunc, finishFunc, fieldArray)                                  \
+    {                                                                                                        \
+        sizeof(type), (void (*)(void *))(initFunc), (void (*)(void *))(cleanupFunc),                         \
+            (bool (*)(void *, void *, MDError *))(finishFunc), fieldArray, sizeof(fieldArray) / sizeof(fieldArray[0]) \
+    }
+
+// MD_JSON_DECODER_MAX_DEPTH is the maximum nesting of objects and arrays
+// described by schemas. Deeper values are only skipped.
+#define MD_JSON_DECODER_MAX_DEPTH 16
+
+// MDJsonDecoderFrame is an object or array which is being decoded.
+typedef struct MDJsonDecoderFrame {
+    const MDJsonField *field;  // of the object or array, NULL if it's skipped.
+    char *target;              // struct decoded into, or holding the array.
+    MDArray *array;            // of MD_JSON_ARRAY.
+    int capacity;              // of the array.
+    unsigned long long seen;   // bits of fields already decoded.
+    bool isArray, isElement, drop;
+} MDJsonDecoderFrame;
+
+// MDJsonDecoder decodes a json response straight into a struct as it is
+// parsed, without building json values (see json_parser_init_handler). A
+// Moodle exception is reported as MD_ERR_MOODLE_EXCEPTION. Its fields are
+// private, except for the handler to be passed to the parser.
+typedef struct MDJsonDecoder {
+    JsonHandler handler;
+    MDJsonField root;
+    void *target, *context;
+    MDJsonDecoderFrame frames[MD_JSON_DECODER_MAX_DEPTH];
+    int depth, skip;
+    const MDJsonField *field;  // of the current key, NULL if it's skipped.
+    char **capture;            // exception or message for the current key.
+    char *exception, *message;
+    bool mismatch;             // if the response is not of the expected type.
+    MDError error;
+} MDJsonDecoder;
+
+// md_json_decoder_init prepares the decoder to decode a response of given
+// type (MD_JSON_OBJECT, ARRAY or EACH) into target using the schema. Context
+// is passed to the finish functions of the schemas.
+void md_json_decoder_init(MDJsonDecoder *decoder, MDJsonFieldType type, const MDJsonSchema *schema, void *target,
+                          void *context);
+
+// md_json_decoder_finish sets error to the error of the decoded response, if
+// any, which takes precedence over the given error (e. g. of the parser
+// stopped by the decoder). The decoder is cleaned up.
+void md_json_decoder_finish(MDJsonDecoder *decoder, MDError *error);
+
+// md_json_decoder_cleanup releases the elements that were being decoded, in
+// case decoding is abandoned. Elements already in the arrays are kept.
+void md_json_decoder_cleanup(MDJsonDecoder *decoder);
+
 // util.c
 
+// MDParseJob parses a response on worker threads during http_multi_request.
+typedef struct MDParseJob MDParseJob;
+
 // struct to temporarily hold data while performing http request.
 typedef struct Memblock {
     char *memory;
     size_t size;
     MDError *error;
+    // If parser is set, received data is parsed as it arrives (by the job on
+    // a worker thread, if it's set), and only kept in memory if keep is set
+    // (e. g. to be cached).
+    JsonParser *parser;
+    MDParseJob *job;
+    bool keep;
 } Memblock;
 
+// md_parse_job_feed queues data to be parsed by the job, returning false if
+// the job has failed or there's no memory.
+bool md_parse_job_feed(MDParseJob *job, cchar *data, size_t size, MDError *error);
+
 // str_replace replaces all occurrences of needle with replacement in the given
 // string. Replacement must be no longer than the needle.
 void str_replace(char *str, cchar *needle, cchar *replacement);
@@ -65,28 +252,55 @@ char *clone_str(cchar *s, MDError *error);
 
 typedef size_t WriteCallback(void *ptr, size_t size, size_t nmemb, void *userdata);
 
-// create_curl creates a common handle for http requests. 
-void *create_curl(cchar *url, void *data, WriteCallback callback, MDError *error);
+// create_curl takes a handle from the pool and sets it up for common http
+// requests. It should be given back using release_curl.
+void *create_curl(MDHttpPool *pool, cchar *url, void *data, WriteCallback callback, MDError *error);
+
+// release_curl gives the handle created using create_curl back to the pool.
+void release_curl(MDHttpPool *pool, void *handle);
 
 // write_memblock_callback writes to memblock.
 size_t write_memblock_callback(void *contents, size_t size, size_t nmemb, void *userp);
 
 // http_get_request_to_file makes http get request to stream and writes data to
 // given stream.
-void http_get_request_to_file(cchar *url, FILE *stream, MDError *error);
+void http_get_request_to_file(MDHttpPool *pool, cchar *url, FILE *stream, MDError *error);
 
 // http_get_request makes get request and returns received data, for which
 // caller is responsible to free.
-char *http_get_request(cchar *url, MDError *error);
-
-// http_get_multi_request makes multiple http requests at once. Each element of
-// the returned 2D array and the array itself needs to be freed by the caller.
-char **http_get_multi_request(char *urls[], unsigned int size, MDError *error);
+char *http_get_request(MDHttpPool *pool, cchar *url, MDError *error);
+
+// MDHttpRequest is a single request made using http_multi_request.
+typedef struct MDHttpRequest {
+    cchar *url;
+    int priority;             // requests with higher priority are started first.
+    MDJsonDecoder *decoder;   // decodes the response instead, if not NULL.
+} MDHttpRequest;
+
+#define MD_HTTP_PRIORITY_NORMAL 0
+#define MD_HTTP_PRIORITY_HIGH 1
+
+// MDHttpCallback is called by http_multi_request as soon as a request
+// finishes. On success json is the parsed response, which the callback is
+// responsible to free using md_cleanup_json, or NULL if the request has a
+// decoder. On failure json is NULL and error is set to the error of the
+// request, with details available using md_error_get_details. If error is set
+// when the callback returns, the remaining requests are cancelled. The
+// callback may be NULL if all the requests have decoders.
+typedef void (*MDHttpCallback)(void *data, int index, Json *json, MDError *error);
+
+// http_multi_request makes multiple http get requests at once, parsing json
+// responses while they are being received. Requests are
+// started in the order of their priority, and in the given order if the
+// priorities are equal, while keeping at most CURL_MAX_PARALLEL transfers in
+// total and the host limit (see md_http_set_host_limit) for each host. The
+// callback is called from the calling thread with the index of the request.
+void http_multi_request(MDHttpPool *pool, MDHttpRequest *requests, int count, MDHttpCallback callback, void *data, MDError *error);
 
 // http_post_file posts a file specified by the filename to the given url.
 // @param name multipart field name of the field with file contents
 // @return response data, that the caller is responsible to free.
-char *http_post_file(cchar *url, cchar *filename, cchar *name, MDError *error);
+char *http_post_file(MDHttpPool *pool, cchar *url, cchar *filename, cchar *name, MDError *error);
 
 // fread_string reads zero-terminated string from binary file, scanning in
 // chunks and returning allocated memory which needs to be freed later.
@@ -97,11 +311,22 @@ typedef int (*compFunc)(const void *a, const void *b);
 
 void sort(void *array, size_t count, size_t size, compFunc comp);
 
-// md_parse_json allocates space for json object and parses given data. The
-// caller is responsible to free using md_cleanup_json.
-Json *md_parse_json(cchar *data, MDError *error);
+// md_new_json allocates an empty json value along with an arena for its
+// contents (see md_json_arena). The caller is responsible to free it using
+// md_cleanup_json.
+Json *md_new_json(MDError *error);
+
+// md_json_arena returns the arena of json allocated using md_new_json.
+Arena *md_json_arena(Json *json);
+
+// md_parse_json allocates space for json object and parses given data in
+// place (see json_parse_in_situ), taking ownership of data. The rest of the
+// json is kept in a single arena. The caller is responsible to free using
+// md_cleanup_json, which also frees data. Data is freed right away on failure.
+Json *md_parse_json(char *data, MDError *error);
 
-// md_cleanup_json deallocates json parsed using md_parse_json.
+// md_cleanup_json deallocates json parsed using md_parse_json or allocated
+// using md_new_json.
 void md_cleanup_json(Json *json);
 
 // json_get_property_silent finds and returns a property of json object if
@@ -135,6 +360,7 @@ void md_auth_plugin_cleanup(MDLoadedPlugin *plugin);
 
 typedef struct MDStatusRef {
     MDModule *module;
+    Arena *arena;  // arena of the courses of the module, or NULL.
     union {
         MDModWorkshopStatus workshop;
         MDModAssignmentStatus assignment;
@@ -154,20 +380,132 @@ typedef void (*MDInitFunc)(struct MDModule *);
 // MDInitFunc is the callback called by md_array_cleanup for each created element.
 typedef void (*MDCleanupFunc)(struct MDModule *);
 
-typedef void (*MDParseFunc)(MDClient *client, MDArray courses, Json *json, MDError *error);
-
 typedef void (*MDStatusParseFunc)(Json *data, MDStatusRef *statusRef, MDError *error);
 
+// cache.c
+
+// MDHttpCacheEntry holds the state of a single http get request made through
+// the response cache (see cache.c).
+typedef struct MDHttpCacheEntry {
+    Memblock *chunk;                            // received body
+    char *key, *path;                           // NULL if caching is disabled
+    FMap map;                                   // cached response, if any
+    size_t bodyOffset;                          // of the body in the map
+    char *etag, *lastModified;                  // validators of cached response
+    char *receivedEtag, *receivedLastModified;  // validators of new response
+    struct curl_slist *headers;
+} MDHttpCacheEntry;
+
+// md_http_cache_prepare initializes the entry and sets up the handle to make a
+// conditional request for url if the response is cached. It must be cleaned
+// up later using md_http_cache_entry_cleanup, after the handle is no longer
+// used.
+void md_http_cache_prepare(MDHttpCacheEntry *entry, void *handle, cchar *url, Memblock *chunk);
+
+// md_http_cache_finish should be called after a successful transfer. If the
+// server responded with 304 Not Modified, the cached body is written to the
+// chunk of the entry like a received one. Otherwise the received response is
+// cached if possible.
+void md_http_cache_finish(MDHttpCacheEntry *entry, void *handle);
+
+// md_http_cache_entry_cleanup releases the resources held by the entry.
+void md_http_cache_entry_cleanup(MDHttpCacheEntry *entry);
+
+// storage.c
+
+// MD_STORAGE_VERSION is the version of the binary format used to store courses.
+// It must be increased after any change to the format.
+#define MD_STORAGE_VERSION 3
+
+// MDWriter writes binary data to a file, or to a growing memory buffer if file
+// is NULL. After a failure error is set and further writes are ignored.
+typedef struct MDWriter {
+    FILE *file;
+    char *data;
+    size_t size, capacity;
+    MDError *error;
+} MDWriter;
+
+// MDReader reads binary data written by MDWriter from memory. After a failure
+// (e. g. reading past the end) error is set and further reads are ignored.
+// If arena is set, everything read is allocated from it, and strings are
+// interned in strings, if that's set too.
+typedef struct MDReader {
+    cchar *it, *end;
+    Arena *arena;
+    struct MDStringSet *strings;
+    MDError *error;
+} MDReader;
+
+// MDWriteFunc writes the contents of a module.
+typedef void (*MDWriteFunc)(MDWriter *writer, struct MDModule *module);
+
+// MDReadFunc reads the contents of a module, previously written by MDWriteFunc.
+typedef void (*MDReadFunc)(MDReader *reader, struct MDModule *module);
+
+void md_write_bytes(MDWriter *writer, const void *data, size_t size);
+void md_write_integer(MDWriter *writer, long long value);
+void md_write_string(MDWriter *writer, cchar *str);
+bool md_read_bytes(MDReader *reader, void *data, size_t size);
+long long md_read_integer(MDReader *reader);
+char *md_read_string(MDReader *reader);
+
+void md_mod_assignment_write(MDWriter *writer, MDModule *module);
+void md_mod_assignment_read(MDReader *reader, MDModule *module);
+void md_mod_workshop_write(MDWriter *writer, MDModule *module);
+void md_mod_workshop_read(MDReader *reader, MDModule *module);
+void md_mod_resource_write(MDWriter *writer, MDModule *module);
+void md_mod_resource_read(MDReader *reader, MDModule *module);
+void md_mod_url_write(MDWriter *writer, MDModule *module);
+void md_mod_url_read(MDReader *reader, MDModule *module);
+
+// md_open_private_file opens the file for writing in binary mode, truncating
+// it, with permissions for the current user only (where supported), as saved
+// and cached files hold the token and the data of the user. Returns NULL on
+// failure.
+FILE *md_open_private_file(cchar *filename);
+
+// md_courses_copy returns a deep copy of courses, which is a snapshot living in
+// a single arena (see md_courses_cleanup) if snapshot is true.
+MDArray md_courses_copy(MDArray courses, bool snapshot, MDError *error);
+
+// md_status_ref_copy_to_arena makes the module of the reference use a copy of
+// the loaded status, allocated from the arena of the reference. The module is
+// left unchanged if there's no memory for the copy.
+void md_status_ref_copy_to_arena(MDStatusRef *statusRef);
+
+// client.c
+
 typedef struct MDMod {
     MDModType type;
     cchar *name, *parseWsFunction;
     cchar *statusWsFunction, *statusInstanceName;
-    MDParseFunc parseFunc;
+    // dataSchema decodes the response of parseWsFunction into MDArray of
+    // MDModuleData.
+    const MDJsonSchema *dataSchema;
     MDInitFunc initFunc;
     MDCleanupFunc cleanupFunc;
     MDStatusParseFunc statusParseFunc;  // if NULL, it does not parse status.
+    MDWriteFunc writeFunc;
+    MDReadFunc readFunc;
 } MDMod;
 
+// MDModuleData holds the contents of a module, which are fetched separately
+// from the topics and moved to the module once all the topics are fetched
+// (see md_courses_apply_module_data).
+typedef struct MDModuleData {
+    int courseId, moduleId, instance;  // of the module.
+    MDModule module;                   // only type and contents are used.
+    char *configPlugin, *configName, *configValue;  // of assignment configs.
+} MDModuleData;
+
+// md_mod_write writes the type, name and contents of a module.
+void md_mod_write(MDWriter *writer, MDModule *module);
+
+// md_mod_read reads a module written using md_mod_write. The module must be
+// initialized using md_module_init.
+void md_mod_read(MDReader *reader, MDModule *module);
+
 // md_array_init_new initializes given array, optionaly calling callback for each created element
 // (if callback isn't NULL). The array must be cleaned later up using md_array_cleanup.
 void md_array_init_new(MDArray *array, size_t size, int length, MDInitFunc callback, MDError *error);
@@ -176,6 +514,9 @@ void md_array_init_new(MDArray *array, size_t size, int length, MDInitFunc callb
 // (if callback isn't NULL).
 void md_array_cleanup(MDArray *array, size_t size, MDCleanupFunc callback);
 
+// MD_URL_LENGTH is the maximum length of urls written by md_client_write_url.
+#define MD_URL_LENGTH 4096
+
 // md_client_write_url formats url for Moodle webservice request and returns bytes written.
 int md_client_write_url(MDClient *client, char *url, cchar *wsfunction, cchar *format, ...);
 
@@ -190,10 +531,14 @@ Json *md_client_do_http_json_request(MDClient *client, MDError *error, char *wsf
 // md_get_mod_type returns module type from Moodle module name.
 MDModType md_get_mod_type(cchar *module);
 
-// md_parse_moodle_json parses json, looking for Moodle exceptions.
+// md_parse_moodle_json parses json, looking for Moodle exceptions. Data is
+// owned by the result, as with md_parse_json.
 // @return json result, must be freed by the caller.
 Json *md_parse_moodle_json(char *data, MDError *error);
 
+// md_check_moodle_exception sets error if json is a Moodle exception.
+void md_check_moodle_exception(Json *json, MDError *error);
+
 // md_client_upload_file uploads a file to Moodle server. If itemId is not
 // MD_NO_ITEM_ID, file is uploaded to the same pool as the file specified with
 // itemId.
@@ -233,42 +578,84 @@ void md_text_submission_init(MDTextSubmission *submission);
 void md_text_submission_cleanup(MDTextSubmission *submission);
 void md_file_init(MDFile *file);
 void md_file_cleanup(MDFile *file);
+void md_mod_assignment_status_init(MDModAssignmentStatus *status);
+void md_mod_assignment_status_cleanup(MDModAssignmentStatus *status);
+void md_mod_workshop_status_init(MDModWorkshopStatus *status);
+void md_mod_workshop_status_cleanup(MDModWorkshopStatus *status);
+
+// md_client_fetch_course_list fetches the list of courses that the user is
+// enrolled in, without their contents.
+// @return MDArray with elements of type MDCourse.
+MDArray md_client_fetch_course_list(MDClient *client, bool sortByName, MDError *error);
+
+// md_modules_load_status is like md_courses_load_status, but only loads the
+// status of given modules.
+// @param modules MDArray with elements of type MDModule *.
+MDLoadedStatus md_modules_load_status(MDClient *client, MDArray modules, MDError *error);
+
+// md_module_share_status makes a module use the status of another module of
+// the same type without copying it if share is true. Otherwise the status of
+// the module is reset without being freed, which ends the sharing. Nothing is
+// done if from is NULL or the types differ.
+void md_module_share_status(MDModule *to, MDModule *from, bool share);
 
 // md_courses_fetch_topic_contents fetches all the data from Moodle server for
-// the topics of given courses.
-void md_courses_fetch_topic_contents(MDClient *client, MDArray courses, MDError *error);
-
-// md_parse_modules parses and returns modules from given json.
-// @return MDArray with elements of type MDModule.
-MDArray md_parse_modules(Json *json, MDError *error);
-
-// md_parse_topics parses and returns topics from given json.
-// @return MDArray with elements of type MDTopic.
-MDArray md_parse_topics(Json *json, MDError *error);
+// the topics of given courses. Contents of the course with priorityCourseId
+// (which may be MD_NO_COURSE) are requested first.
+void md_courses_fetch_topic_contents(MDClient *client, MDArray courses, int priorityCourseId, MDError *error);
+
+// MD_SYNC_TIME_MARGIN is the time in seconds subtracted from the local clock
+// for fetchTime and syncTime of courses. They are sent back to Moodle as the
+// time to get updates since, so the margin covers clocks running ahead of the
+// server's and changes made while the requests were in flight. Updates which
+// are reported twice only cause their course to be fetched again.
+#define MD_SYNC_TIME_MARGIN (10 * 60)
+
+#define MD_MODULE_INDEX_MIN_CAPACITY 16
+
+typedef struct MDModuleIndexEntry {
+    int courseId;
+    MDModule *module;  // NULL if the slot is empty.
+} MDModuleIndexEntry;
+
+// MDModuleIndex is a hash index of the modules of courses by course id, module
+// id and instance, with linear probing. It points into the topics of the
+// courses, so it must be built again once they change.
+typedef struct MDModuleIndex {
+    MDModuleIndexEntry *entries;
+    int capacity;  // power of two, or 0 if not built.
+} MDModuleIndex;
+
+// md_module_index_init initializes an empty index, which must be cleaned up
+// using md_module_index_cleanup.
+void md_module_index_init(MDModuleIndex *index);
+
+// md_module_index_build (re)builds the index from all the modules of courses.
+void md_module_index_build(MDModuleIndex *index, MDArray courses, MDError *error);
+
+// md_module_index_get returns the module with matching properties, or NULL
+// with MD_ERR_MISMACHING_MOODLE_DATA if there's none (like
+// md_courses_locate_module).
+MDModule *md_module_index_get(MDModuleIndex *index, int courseId, int moduleId, int instance, MDError *error);
+
+void md_module_index_cleanup(MDModuleIndex *index);
+
+// md_courses_apply_module_data moves the contents of module data (see
+// MDModuleData) to the matching modules of the index.
+// @param data MDArray with elements of type MDModuleData.
+void md_courses_apply_module_data(MDModuleIndex *index, MDArray data, MDError *error);
 
 // md_parse_files parses and returns files from given json.
 // @return MDArray with elements of type MDFile.
 MDArray md_parse_files(Json *json, MDError *error);
 
-// md_parse_mod_assignment_plugins parses settings for mod assignment out of given
-// json, as they have different syntax from the rest.
-void md_parse_mod_assignment_plugins(Json *configs, MDModAssignment *assignment, MDError *error);
+// md_mod_assignment_apply_config applies a single setting of assignment
+// plugin, as they have different syntax from the rest.
+void md_mod_assignment_apply_config(MDModAssignment *assignment, cchar *plugin, cchar *name, cchar *value,
+                                    MDError *error);
 
 // md_course_locate_module locates and returns pointer to a module with matching
 // properties if it exists in the given courses array.
 MDModule *md_courses_locate_module(MDArray courses, int courseId, int moduleId, int instance, MDError *error);
 
-// md_courses_locate_json_module similar to md_courses_locate_module, but data
-// needed to identify module is extracted from given json. Json property name
-// of module id should also be suplied (usually cmid or coursemodule).
-MDModule *md_courses_locate_json_module(MDArray courses, Json *json, cchar *moduleIdJsonName, MDError *error);
-
-// for efficiency, data for modules is fetched at once and then applied to
-// courses using following functions:
-
-void md_client_courses_set_mod_assignment_data(MDClient *client, MDArray courses, Json *json, MDError *error);
-void md_client_courses_set_mod_workshop_data(MDClient *client, MDArray courses, Json *json, MDError *error);
-void md_client_courses_set_mod_resource_data(MDClient *client, MDArray courses, Json *json, MDError *error);
-void md_client_courses_set_mod_url_data(MDClient *client, MDArray courses, Json *json, MDError *error);
-
 #endif
\ No newline at end of file
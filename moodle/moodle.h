@@ -59,6 +59,7 @@ typedef enum MDError {
     MD_ERR_FAILED_TO_LOAD_PLUGIN,
     MD_ERR_MISSING_PLUGIN_VAR,
     MD_ERR_INVALID_PLUGIN,
+    MD_ERR_INVALID_FILE,
 } MDError;
 
 // Dynamic arrays:
@@ -71,6 +72,9 @@ typedef enum MDError {
 typedef struct MDArray {
     int len;
     void *_data;
+    // _arena is the arena which owns the elements and everything they point
+    // to, or NULL if they are allocated one by one. Only set for courses.
+    void *_arena;
 } MDArray;
 
 // MD_ARR casts generic array to specific type array (pointer).
@@ -96,7 +100,7 @@ typedef struct MDArray {
 #define MD_MAKE_ARR_LEN(type, length, ...) ((MDArray){.len = length, ._data = (void *)((type[length]){__VA_ARGS__})})
 
 // Macro for zero initializer of a MDArray
-#define MD_ARRAY_INITIALIZER {.len = 0, ._data = NULL}
+#define MD_ARRAY_INITIALIZER {.len = 0, ._data = NULL, ._arena = NULL}
 
 // md_array_append appends an element of given size go give MDArray. Size must
 // match the sizes of previous elements, or behaviour is undefined. This
@@ -114,6 +118,13 @@ void md_array_free(MDArray *array);
 // MD_NO_FILE_LIMIT means that file count is not limited.
 #define MD_NO_FILE_LIMIT -1
 
+// MD_HTTP_HOST_LIMIT is the default limit of parallel requests to a single
+// server, see md_http_set_host_limit.
+#define MD_HTTP_HOST_LIMIT 10
+
+// MD_NO_COURSE can be used where a course id is optional.
+#define MD_NO_COURSE 0
+
 // MD_NO_WORD_LIMIT means that word count is not limited.
 #define MD_NO_WORD_LIMIT 0
 
@@ -125,6 +136,7 @@ typedef struct MDClient {
     int userid;
     long uploadLimit;
     char *token, *website;  // private
+    struct MDHttpPool *pool;  // private, reused connections
     MD_EXTRA_FIELD
     MD_EXTRA_FIELD_CLIENT    
 } MDClient;
@@ -163,6 +175,7 @@ typedef struct MDFile {
     char *filename;
     long filesize;
     char *url;
+    time_t timeModified;  // may be 0 if not known.
     MD_EXTRA_FIELD
     MD_EXTRA_FIELD_FILE    
 } MDFile;
@@ -302,6 +315,9 @@ typedef struct MDCourse {
     char *name;
     // Array with elements of type MDTopic.
     MDArray topics;
+    // When the contents and module statuses were last fetched, used by
+    // md_client_sync_courses. May be equal to MD_DATE_NONE.
+    time_t fetchTime, syncTime;
     MD_EXTRA_FIELD
     MD_EXTRA_FIELD_COURSE    
 } MDCourse;
@@ -314,6 +330,47 @@ typedef struct MDLoadedStatus {
     MDArray internalReferences;
 } MDLoadedStatus;
 
+// MDRefresher fetches courses with their module statuses in a background
+// thread and publishes each fetched tree as a new independent snapshot. It
+// generalises MDLoadedStatus: all the work is done in the background and the
+// application only swaps the courses it displays, whenever it's convenient.
+typedef struct MDRefresher MDRefresher;
+
+// MDDownloader downloads files in a background thread, so that the
+// application keeps responding while they are transferred. See
+// md_downloader_new.
+typedef struct MDDownloader MDDownloader;
+
+// MDDownloadState is the state of a single download of MDDownloader.
+typedef enum MDDownloadState {
+    MD_DOWNLOAD_QUEUED,
+    MD_DOWNLOAD_ACTIVE,
+    MD_DOWNLOAD_DONE,
+    MD_DOWNLOAD_FAILED,
+} MDDownloadState;
+
+// MDDownloadProgress describes a download, as reported by md_downloader_poll.
+typedef struct MDDownloadProgress {
+    int id;                // as returned by md_downloader_add.
+    const char *filename;  // where the file is saved.
+    MDDownloadState state;
+    long long received;    // bytes of the file saved so far, resumed ones included.
+    long long size;        // size of the file, or -1 if it's not known (yet).
+    int segments;          // number of parts transferred in parallel.
+    MDError error;         // set if the download failed.
+} MDDownloadProgress;
+
+// MDDownloadCallback is called by md_downloader_poll for each download, which
+// has changed since the last poll.
+typedef void (*MDDownloadCallback)(void *data, const MDDownloadProgress *progress);
+
+// MDHttpCacheStats counts webservice requests made while the http response
+// cache is enabled (see md_http_cache_set_folder).
+typedef struct MDHttpCacheStats {
+    long hits;    // answered with 304 Not Modified and served from disk
+    long misses;  // fully downloaded
+} MDHttpCacheStats;
+
 // Functions
 //
 // Bellow are the functions of this library. All of them are documented, but it
@@ -322,7 +379,9 @@ typedef struct MDLoadedStatus {
 // by the library and this will not be repeated in the decriptions of following
 // functions.
 
-// md_loaded_status_apply applies loaded changes.
+// md_loaded_status_apply applies loaded changes. Statuses applied to courses
+// returned by the library are copied into their arena, where the replaced
+// statuses stay until the courses are cleaned up.
 void md_loaded_status_apply(MDLoadedStatus status);
 
 // md_loaded_status_apply releases resources held by loaded changes.
@@ -354,9 +413,57 @@ void md_client_cleanup(MDClient *client);
 MDArray md_client_fetch_courses(MDClient *client, bool sortByName, MDError *error);
 
 // md_courses_cleanup releases all the resources owned by the list of courses.
+// Courses returned by the library (a snapshot) live in a single arena owned by
+// the array, so they are released at once. Equal strings of a snapshot are
+// shared, so nothing in it may be freed or changed in place, other than with
+// functions of the library.
 // @param courses MDArray with elements of type MDCourse.
 void md_courses_cleanup(MDArray courses);
 
+// md_client_sync_courses brings courses fetched earlier (or loaded from file)
+// up to date, including module statuses, like md_client_fetch_courses
+// followed by md_courses_load_status would. Moodle is asked which modules have
+// changed since the last sync of each course and only courses with changes
+// are fetched again. Statuses are only loaded for changed or new modules.
+// Courses are only replaced when the sync succeeds.
+// @param courses pointer to MDArray with elements of type MDCourse.
+// @param priorityCourseId id of the course (e. g. the one being viewed), which
+// is requested before the others, or MD_NO_COURSE.
+void md_client_sync_courses(MDClient *client, MDArray *courses, bool sortByName, int priorityCourseId, MDError *error);
+
+// md_courses_clone returns a deep copy of courses, which should be cleaned up
+// later using md_courses_cleanup.
+MDArray md_courses_clone(MDArray courses, MDError *error);
+
+// md_courses_save_to_file saves courses to given binary file, which can later
+// be loaded using md_courses_load_from_file. The file is replaced atomically, so
+// it's never left partially written.
+// @param courses MDArray with elements of type MDCourse.
+void md_courses_save_to_file(MDArray courses, const char *filename, MDError *error);
+
+// md_courses_load_from_file loads and returns courses saved using
+// md_courses_save_to_file. Files written by an incompatible version of the
+// library result in MD_ERR_INVALID_FILE. Returned courses should be cleaned up
+// later using md_courses_cleanup.
+MDArray md_courses_load_from_file(const char *filename, MDError *error);
+
+// md_http_cache_set_folder enables caching of webservice responses in given
+// existing folder, or disables it if folder is NULL (the default). Responses
+// are only reused when the server confirms that they haven't changed, so
+// caching is transparent, but it saves downloading the same data repeatedly.
+// The least recently stored responses are removed from the folder while they
+// take more than 64 MiB. It must not be called while other library functions
+// are running.
+void md_http_cache_set_folder(const char *folder, MDError *error);
+
+// md_http_set_host_limit sets the maximum number of parallel requests made to
+// a single server, MD_HTTP_HOST_LIMIT by default. The total number of parallel
+// requests is limited to 20 regardless.
+void md_http_set_host_limit(int limit);
+
+// md_http_cache_get_stats returns the numbers of cache hits and misses so far.
+MDHttpCacheStats md_http_cache_get_stats();
+
 // md_client_mod_assign_submit submits an assignment module with given files and
 // text. text or filename array may be NULL, in which case that part will not be
 // submitted.
@@ -384,6 +491,75 @@ void md_client_download_file(MDClient *client, MDFile *file, FILE *stream, MDErr
 // function can be freed using md_loaded_status_cleanup.
 MDLoadedStatus md_courses_load_status(MDClient *client, MDArray courses, MDError *error);
 
+// md_refresher_new starts a background thread, which refreshes courses every
+// interval seconds (or when requested using md_refresher_refresh). The thread
+// keeps a copy of given courses and keeps it up to date using
+// md_client_sync_courses. The client is shared with the thread, so it must not
+// be modified or cleaned up until md_refresher_cleanup is called. If filename
+// is not NULL, every fetched snapshot is also saved to that file using
+// md_courses_save_to_file.
+MDRefresher *md_refresher_new(MDClient *client, MDArray courses, int interval, bool sortByName, const char *filename, MDError *error);
+
+// md_refresher_refresh makes the refresher fetch courses right away, without
+// waiting for the interval to pass.
+void md_refresher_refresh(MDRefresher *refresher);
+
+// md_refresher_set_priority_course makes the following refreshes request the
+// course with given id (e. g. the one being viewed) before the others.
+void md_refresher_set_priority_course(MDRefresher *refresher, int courseId);
+
+// md_refresher_take never blocks and returns true if a refresh has finished
+// since the last call. On success the newest snapshot is moved to courses,
+// while the previous courses are left for the caller to clean up once they
+// are no longer used. If the refresh failed, error is set and courses are left
+// unchanged. Snapshots that were never taken are freed by the refresher.
+bool md_refresher_take(MDRefresher *refresher, MDArray *courses, MDError *error);
+
+// md_refresher_cleanup stops the refresher (waiting for the current refresh to
+// finish) and releases all its resources.
+void md_refresher_cleanup(MDRefresher *refresher);
+
+// md_downloader_new starts a background thread, which downloads files added
+// using md_downloader_add, a few at a time. Files are first saved to partial
+// files next to them (filename.part0, filename.part1, ...), which are kept if
+// the download fails or is stopped, so that the next download of the same file
+// resumes from where it stopped, if the server supports ranges. Big files are
+// downloaded in several parts in parallel. Transfers which stall for a minute
+// fail. The client is shared with the thread, so it must not be modified or
+// cleaned up until md_downloader_cleanup is called.
+MDDownloader *md_downloader_new(MDClient *client, MDError *error);
+
+// md_downloader_add queues the file to be downloaded to filename and returns
+// the id of the download. The file and filename are copied. If a download to
+// the same filename is queued or active already, its id is returned instead.
+// Unless it's NULL, queued is set to whether a new download was queued. The
+// downloaded file gets the modification time of the file, if it's known.
+int md_downloader_add(MDDownloader *downloader, MDFile *file, const char *filename, bool *queued, MDError *error);
+
+// md_downloader_set_parallel sets the number of files downloaded at once,
+// which is 2 by default and at most 16.
+void md_downloader_set_parallel(MDDownloader *downloader, int count);
+
+// md_downloader_mirror adds downloads of all the files of the course (files
+// of resources and assignments as well as submitted ones) into the folder,
+// laid out as folder/course/topic/module/file, with submitted files in a
+// "submission" folder of the module. Files which exist with the same size and
+// modification time as on the server are skipped, so mirroring again only
+// downloads new or changed files. Returns the number of downloads added, not
+// counting files which were being downloaded already.
+int md_downloader_mirror(MDDownloader *downloader, MDCourse *course, const char *folder, MDError *error);
+
+// md_downloader_poll never blocks and calls the callback from the calling
+// thread for each download, which has progressed since the last poll. Each
+// download is reported once more when it's done or has failed, in which case
+// details of the error are available using md_error_get_message, and is
+// forgotten afterwards. Returns the number of calls made.
+int md_downloader_poll(MDDownloader *downloader, MDDownloadCallback callback, void *data);
+
+// md_downloader_cleanup stops the downloader, leaving unfinished downloads to
+// be resumed later, and releases all its resources.
+void md_downloader_cleanup(MDDownloader *downloader);
+
 // See auth.h for implementing a custom plugin.
 
 // md_auth_load_plugin tries to load a new auth plugin specified by the
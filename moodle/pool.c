@@ -0,0 +1,178 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Part of moodle library (pool of reusable curl handles). See internal.h
+ *
+ * Each client owns a pool, so that requests don't pay for a new connection,
+ * DNS lookup and TLS handshake every time. Finished handles are reset and kept
+ * for later requests, which keeps their live connections open. DNS cache and
+ * TLS sessions are additionally shared between all the handles of the pool.
+ * Connections are not put to the share, as libcurl doesn't support using a
+ * shared connection cache from concurrent threads (e. g. the refresher and the
+ * application). The pool also owns the worker threads which parse the
+ * responses of http_multi_request, so that they're started only once.
+ */
+
+#include <curl/curl.h>
+#include <stdlib.h>
+
+#include "internal.h"
+#include "thread.h"
+
+// MD_HTTP_POOL_SIZE is the maximum number of idle handles of each kind kept in
+// the pool.
+#define MD_HTTP_POOL_SIZE CURL_MAX_PARALLEL
+
+struct MDHttpPool {
+    CURLSH *share;
+    void *shareLocks[CURL_LOCK_DATA_LAST];
+    void *mutex;  // guards the idle handles below.
+    CURL *easy[MD_HTTP_POOL_SIZE];
+    CURLM *multi[MD_HTTP_POOL_SIZE];
+    int easyCount, multiCount;
+    MDWorkers *workers;  // started on first use.
+    bool workersFailed;
+};
+
+static void md_http_pool_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr) {
+    th_mutex_lock(((MDHttpPool *)userptr)->shareLocks[data]);
+}
+
+static void md_http_pool_unlock(CURL *handle, curl_lock_data data, void *userptr) {
+    th_mutex_unlock(((MDHttpPool *)userptr)->shareLocks[data]);
+}
+
+MDHttpPool *md_http_pool_new(MDError *error) {
+    MDHttpPool *pool = md_malloc(sizeof(MDHttpPool), error);
+    if (!pool)
+        return NULL;
+    pool->easyCount = pool->multiCount = 0;
+    pool->workers = NULL;
+    pool->workersFailed = false;
+    pool->mutex = th_mutex_new();
+    bool ok = pool->mutex != NULL;
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; ++i) {
+        pool->shareLocks[i] = th_mutex_new();
+        ok = ok && pool->shareLocks[i];
+    }
+    pool->share = curl_share_init();
+    if (ok && pool->share) {
+        curl_share_setopt(pool->share, CURLSHOPT_LOCKFUNC, md_http_pool_lock);
+        curl_share_setopt(pool->share, CURLSHOPT_UNLOCKFUNC, md_http_pool_unlock);
+        curl_share_setopt(pool->share, CURLSHOPT_USERDATA, pool);
+        curl_share_setopt(pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    } else {
+        *error = MD_ERR_CURL_FAIL;
+        md_http_pool_cleanup(pool);
+        pool = NULL;
+    }
+    return pool;
+}
+
+void md_http_pool_cleanup(MDHttpPool *pool) {
+    if (!pool)
+        return;
+    md_workers_cleanup(pool->workers);
+    for (int i = 0; i < pool->easyCount; ++i) {
+        curl_easy_cleanup(pool->easy[i]);
+    }
+    for (int i = 0; i < pool->multiCount; ++i) {
+        curl_multi_cleanup(pool->multi[i]);
+    }
+    // The share can only be cleaned up after all the handles using it.
+    if (pool->share)
+        curl_share_cleanup(pool->share);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; ++i) {
+        if (pool->shareLocks[i])
+            th_mutex_free(pool->shareLocks[i]);
+    }
+    if (pool->mutex)
+        th_mutex_free(pool->mutex);
+    free(pool);
+}
+
+void *md_http_pool_take_easy(MDHttpPool *pool, MDError *error) {
+    CURL *handle = NULL;
+    if (pool) {
+        th_mutex_lock(pool->mutex);
+        if (pool->easyCount)
+            handle = pool->easy[--pool->easyCount];
+        th_mutex_unlock(pool->mutex);
+    }
+    if (!handle)
+        handle = curl_easy_init();
+    if (!handle)
+        *error = MD_ERR_CURL_FAIL;
+    else if (pool)
+        curl_easy_setopt(handle, CURLOPT_SHARE, pool->share);
+    return handle;
+}
+
+void md_http_pool_give_easy(MDHttpPool *pool, void *handle) {
+    if (!handle)
+        return;
+    if (pool) {
+        // Reset keeps the live connections, but clears all the options.
+        curl_easy_reset(handle);
+        th_mutex_lock(pool->mutex);
+        if (pool->easyCount < MD_HTTP_POOL_SIZE) {
+            pool->easy[pool->easyCount++] = handle;
+            handle = NULL;
+        }
+        th_mutex_unlock(pool->mutex);
+    }
+    if (handle)
+        curl_easy_cleanup(handle);
+}
+
+void *md_http_pool_take_multi(MDHttpPool *pool, MDError *error) {
+    CURLM *multi = NULL;
+    if (pool) {
+        th_mutex_lock(pool->mutex);
+        if (pool->multiCount)
+            multi = pool->multi[--pool->multiCount];
+        th_mutex_unlock(pool->mutex);
+    }
+    if (!multi) {
+        multi = curl_multi_init();
+        if (multi) {
+            curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long)CURL_MAX_PARALLEL);
+            // Requests to the same server are multiplexed over a single
+            // connection when it supports HTTP/2.
+            curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        } else {
+            *error = MD_ERR_CURL_FAIL;
+        }
+    }
+    return multi;
+}
+
+void md_http_pool_give_multi(MDHttpPool *pool, void *multi) {
+    if (!multi)
+        return;
+    if (pool) {
+        th_mutex_lock(pool->mutex);
+        if (pool->multiCount < MD_HTTP_POOL_SIZE) {
+            pool->multi[pool->multiCount++] = multi;
+            multi = NULL;
+        }
+        th_mutex_unlock(pool->mutex);
+    }
+    if (multi)
+        curl_multi_cleanup(multi);
+}
+
+MDWorkers *md_http_pool_get_workers(MDHttpPool *pool) {
+    if (!pool)
+        return NULL;
+    th_mutex_lock(pool->mutex);
+    if (!pool->workers && !pool->workersFailed) {
+        MDError error = MD_ERR_NONE;
+        pool->workers = md_workers_new(th_cpu_count(), &error);
+        pool->workersFailed = error != MD_ERR_NONE;
+    }
+    MDWorkers *workers = pool->workers;
+    th_mutex_unlock(pool->mutex);
+    return workers;
+}
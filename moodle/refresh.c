@@ -0,0 +1,169 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Part of moodle library (background refreshing of courses). See moodle.h
+ *
+ * The refresher thread keeps its own courses tree up to date using
+ * md_client_sync_courses and publishes a copy of it after every refresh by
+ * atomically exchanging the pending snapshot pointer. The
+ * reader takes the snapshot by exchanging it with NULL, so each snapshot is
+ * owned by exactly one side at any time and no locking is needed. Old trees
+ * are never touched by the refresher, so reclamation is deferred to the
+ * reader, which knows when the old tree is no longer used.
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal.h"
+#include "thread.h"
+
+// MDSnapshot is the result of a single refresh.
+typedef struct MDSnapshot {
+    MDArray courses;
+    MDError error;
+    char *message;  // details of the error, see md_error_get_details.
+} MDSnapshot;
+
+struct MDRefresher {
+    MDClient *client;
+    MDArray courses;  // only used by the refresher thread.
+    int interval;
+    bool sortByName;
+    char *filename;
+    void *thread, *mutex, *cond;
+    bool stop, refreshNow;  // guarded by mutex.
+    int priorityCourseId;   // guarded by mutex.
+    _Atomic(MDSnapshot *) pending;
+};
+
+void md_snapshot_cleanup(MDSnapshot *snapshot) {
+    if (snapshot) {
+        md_courses_cleanup(snapshot->courses);
+        free(snapshot->message);
+        free(snapshot);
+    }
+}
+
+// md_snapshot_fetch syncs courses of the refresher and returns their copy,
+// or NULL only if the snapshot itself can't be allocated.
+MDSnapshot *md_snapshot_fetch(MDRefresher *refresher, int priorityCourseId) {
+    MDError error = MD_ERR_NONE;
+    MDSnapshot *snapshot = md_malloc(sizeof(MDSnapshot), &error);
+    if (!snapshot)
+        return NULL;
+    md_array_init(&snapshot->courses);
+    snapshot->message = NULL;
+
+    md_client_sync_courses(refresher->client, &refresher->courses, refresher->sortByName, priorityCourseId, &error);
+    if (!error && refresher->filename)
+        md_courses_save_to_file(refresher->courses, refresher->filename, &error);
+    if (!error)
+        snapshot->courses = md_courses_clone(refresher->courses, &error);
+
+    snapshot->error = error;
+    if (error)
+        snapshot->message = clone_str(md_error_get_details(), &error);
+    return snapshot;
+}
+
+void md_refresher_run(void *data) {
+    MDRefresher *refresher = data;
+    th_mutex_lock(refresher->mutex);
+    while (!refresher->stop) {
+        // Waits until the interval has passed, as the condition variable may
+        // also wake up spuriously.
+        long long deadline = th_clock() + refresher->interval * 1000LL, remaining;
+        while (!refresher->refreshNow && !refresher->stop && (remaining = deadline - th_clock()) > 0)
+            th_cond_wait(refresher->cond, refresher->mutex, (int)remaining);
+        if (refresher->stop)
+            break;
+        refresher->refreshNow = false;
+        int priorityCourseId = refresher->priorityCourseId;
+        th_mutex_unlock(refresher->mutex);
+
+        MDSnapshot *snapshot = md_snapshot_fetch(refresher, priorityCourseId);
+        // A snapshot that wasn't taken yet is replaced by the newer one.
+        md_snapshot_cleanup(atomic_exchange(&refresher->pending, snapshot));
+
+        th_mutex_lock(refresher->mutex);
+    }
+    th_mutex_unlock(refresher->mutex);
+}
+
+MDRefresher *md_refresher_new(MDClient *client, MDArray courses, int interval, bool sortByName, cchar *filename, MDError *error) {
+    *error = MD_ERR_NONE;
+    MDRefresher *refresher = md_malloc(sizeof(MDRefresher), error);
+    if (!refresher)
+        return NULL;
+    refresher->client = client;
+    refresher->courses = md_courses_clone(courses, error);
+    refresher->interval = interval;
+    refresher->sortByName = sortByName;
+    refresher->filename = filename && !*error ? clone_str(filename, error) : NULL;
+    refresher->stop = refresher->refreshNow = false;
+    refresher->priorityCourseId = MD_NO_COURSE;
+    atomic_init(&refresher->pending, NULL);
+    refresher->mutex = th_mutex_new();
+    refresher->cond = th_cond_new();
+    refresher->thread = NULL;
+    if (!*error && refresher->mutex && refresher->cond)
+        refresher->thread = th_create(md_refresher_run, refresher);
+    if (!refresher->thread) {
+        if (!*error)
+            *error = MD_ERR_ALLOC;
+        md_refresher_cleanup(refresher);
+        refresher = NULL;
+    }
+    return refresher;
+}
+
+void md_refresher_refresh(MDRefresher *refresher) {
+    th_mutex_lock(refresher->mutex);
+    refresher->refreshNow = true;
+    th_cond_signal(refresher->cond);
+    th_mutex_unlock(refresher->mutex);
+}
+
+void md_refresher_set_priority_course(MDRefresher *refresher, int courseId) {
+    th_mutex_lock(refresher->mutex);
+    refresher->priorityCourseId = courseId;
+    th_mutex_unlock(refresher->mutex);
+}
+
+bool md_refresher_take(MDRefresher *refresher, MDArray *courses, MDError *error) {
+    *error = MD_ERR_NONE;
+    MDSnapshot *snapshot = atomic_exchange(&refresher->pending, NULL);
+    if (!snapshot)
+        return false;
+    *error = snapshot->error;
+    if (*error) {
+        md_error_set_message(snapshot->message ? snapshot->message : "");
+    } else {
+        *courses = snapshot->courses;
+        md_array_init(&snapshot->courses);
+    }
+    md_snapshot_cleanup(snapshot);
+    return true;
+}
+
+void md_refresher_cleanup(MDRefresher *refresher) {
+    if (!refresher)
+        return;
+    if (refresher->thread) {
+        th_mutex_lock(refresher->mutex);
+        refresher->stop = true;
+        th_cond_signal(refresher->cond);
+        th_mutex_unlock(refresher->mutex);
+        th_join(refresher->thread);
+    }
+    if (refresher->mutex)
+        th_mutex_free(refresher->mutex);
+    if (refresher->cond)
+        th_cond_free(refresher->cond);
+    md_snapshot_cleanup(atomic_load(&refresher->pending));
+    md_courses_cleanup(refresher->courses);
+    free(refresher->filename);
+    free(refresher);
+}
@@ -0,0 +1,592 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Part of moodle library (binary storage of fetched courses). See moodle.h
+ *
+ * The file starts with a header (magic bytes, format version and byte order
+ * mark), followed by the whole courses tree written in depth-first order.
+ * Integers are written as 8 byte values in machine byte order, strings are
+ * prefixed with their length + 1 (0 meaning NULL) and arrays with the number
+ * of their elements. The file is only meant to be read on the same machine,
+ * any mismatch results in MD_ERR_INVALID_FILE.
+ *
+ * The same format is used to copy courses in memory. Copies made as snapshots
+ * are read into a single arena, with equal strings shared, so that they take
+ * a single block of memory per 64 KB and are released all at once.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmap.h"
+#include "internal.h"
+
+#define MD_STORAGE_MAGIC "MOOTTREE"
+#define MD_STORAGE_BYTE_ORDER 0x01020304
+// Strings longer than MD_STORAGE_INTERN_MAX_LEN (e. g. descriptions) are rarely
+// repeated, so they are not interned.
+#define MD_STORAGE_INTERN_MAX_LEN 256
+#define MD_STORAGE_INTERN_MIN_CAPACITY 256
+
+typedef struct MDInternedString {
+    char *str;  // NULL if the slot is empty.
+    uint32_t len;
+} MDInternedString;
+
+// MDStringSet is a hash set of strings interned by a reader, with linear
+// probing. The strings themselves live in the arena of the reader.
+typedef struct MDStringSet {
+    MDInternedString *slots;
+    size_t len, capacity;  // capacity is a power of two.
+} MDStringSet;
+
+void md_write_bytes(MDWriter *writer, const void *data, size_t size) {
+    if (*writer->error || !size)
+        return;
+    if (writer->file) {
+        if (fwrite(data, size, 1, writer->file) != 1)
+            *writer->error = MD_ERR_FILE_OPERATION;
+        return;
+    }
+    if (writer->size + size > writer->capacity) {
+        size_t capacity = writer->capacity ? writer->capacity : 4096;
+        while (capacity < writer->size + size)
+            capacity *= 2;
+        char *data = md_realloc(writer->data, capacity, writer->error);
+        if (!data)
+            return;
+        writer->data = data;
+        writer->capacity = capacity;
+    }
+    memcpy(writer->data + writer->size, data, size);
+    writer->size += size;
+}
+
+void md_write_integer(MDWriter *writer, long long value) {
+    int64_t fixed = value;
+    md_write_bytes(writer, &fixed, sizeof(fixed));
+}
+
+void md_write_string(MDWriter *writer, cchar *str) {
+    uint32_t len = str ? strlen(str) + 1 : 0;
+    md_write_bytes(writer, &len, sizeof(len));
+    if (len)
+        md_write_bytes(writer, str, len - 1);
+}
+
+void md_write_rich_text(MDWriter *writer, MDRichText *richText) {
+    md_write_string(writer, richText->text);
+    md_write_integer(writer, richText->format);
+}
+
+void md_write_files(MDWriter *writer, MDArray files) {
+    md_write_integer(writer, files.len);
+    for (int i = 0; i < files.len; ++i) {
+        MDFile *file = &MD_FILES(files)[i];
+        md_write_string(writer, file->filename);
+        md_write_integer(writer, file->filesize);
+        md_write_string(writer, file->url);
+        md_write_integer(writer, file->timeModified);
+    }
+}
+
+void md_write_file_submission(MDWriter *writer, MDFileSubmission *submission) {
+    md_write_integer(writer, submission->status);
+    md_write_integer(writer, submission->maxUploadedFiles);
+    md_write_integer(writer, submission->maxSubmissionSize);
+    md_write_string(writer, submission->acceptedFileTypes);
+}
+
+void md_write_text_submission(MDWriter *writer, MDTextSubmission *submission) {
+    md_write_integer(writer, submission->status);
+    md_write_integer(writer, submission->wordLimit);
+}
+
+bool md_read_bytes(MDReader *reader, void *data, size_t size) {
+    if (*reader->error)
+        return false;
+    if ((size_t)(reader->end - reader->it) < size) {
+        *reader->error = MD_ERR_INVALID_FILE;
+        return false;
+    }
+    memcpy(data, reader->it, size);
+    reader->it += size;
+    return true;
+}
+
+long long md_read_integer(MDReader *reader) {
+    int64_t fixed = 0;
+    md_read_bytes(reader, &fixed, sizeof(fixed));
+    return fixed;
+}
+
+// md_read_alloc allocates memory for data being read, from the arena of the
+// reader if it has one.
+void *md_read_alloc(MDReader *reader, size_t size, bool aligned) {
+    if (!reader->arena)
+        return md_malloc(size, reader->error);
+    void *memory = aligned ? arena_alloc(reader->arena, size) : arena_alloc_bytes(reader->arena, size);
+    if (!memory)
+        *reader->error = MD_ERR_ALLOC;
+    return memory;
+}
+
+// md_string_hash returns 32 bit FNV-1a hash of given bytes.
+uint32_t md_string_hash(cchar *data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// md_string_set_find returns the slot of given string, which is empty if the
+// string is not in the set yet.
+MDInternedString *md_string_set_find(MDStringSet *set, cchar *data, uint32_t len) {
+    size_t mask = set->capacity - 1;
+    for (size_t i = md_string_hash(data, len) & mask;; i = (i + 1) & mask) {
+        MDInternedString *slot = &set->slots[i];
+        if (!slot->str || (slot->len == len && !memcmp(slot->str, data, len)))
+            return slot;
+    }
+}
+
+// md_read_interned_string returns the interned copy of given string, or NULL
+// if it can't be interned.
+char *md_read_interned_string(MDReader *reader, cchar *data, uint32_t len) {
+    MDStringSet *set = reader->strings;
+    if (len > MD_STORAGE_INTERN_MAX_LEN)
+        return NULL;
+    if ((set->len + 1) * 2 > set->capacity) {
+        // The set is rebuilt at twice the size, so that at most half of it is
+        // used. If that fails, strings are just not shared anymore.
+        size_t capacity = set->capacity ? set->capacity * 2 : MD_STORAGE_INTERN_MIN_CAPACITY;
+        MDStringSet grown = {.slots = calloc(capacity, sizeof(MDInternedString)), .len = set->len, .capacity = capacity};
+        if (!grown.slots)
+            return NULL;
+        for (size_t i = 0; i < set->capacity; ++i) {
+            if (set->slots[i].str)
+                *md_string_set_find(&grown, set->slots[i].str, set->slots[i].len) = set->slots[i];
+        }
+        free(set->slots);
+        *set = grown;
+    }
+    MDInternedString *slot = md_string_set_find(set, data, len);
+    if (!slot->str) {
+        char *str = md_read_alloc(reader, len + 1, false);
+        if (!str)
+            return NULL;
+        memcpy(str, data, len);
+        str[len] = '\0';
+        *slot = (MDInternedString){.str = str, .len = len};
+        ++set->len;
+    }
+    return slot->str;
+}
+
+char *md_read_string(MDReader *reader) {
+    uint32_t len = 0;
+    if (!md_read_bytes(reader, &len, sizeof(len)) || !len)
+        return NULL;
+    if ((size_t)(reader->end - reader->it) < len - 1) {
+        *reader->error = MD_ERR_INVALID_FILE;
+        return NULL;
+    }
+    char *str = reader->strings ? md_read_interned_string(reader, reader->it, len - 1) : NULL;
+    if (!str && !*reader->error && (str = md_read_alloc(reader, len, false))) {
+        memcpy(str, reader->it, len - 1);
+        str[len - 1] = '\0';
+    }
+    if (str)
+        reader->it += len - 1;
+    return str;
+}
+
+// md_read_length reads array length, making sure that it's not bigger than the
+// remaining data (every element takes at least a single byte).
+int md_read_length(MDReader *reader) {
+    long long len = md_read_integer(reader);
+    if (len < 0 || len > reader->end - reader->it) {
+        *reader->error = MD_ERR_INVALID_FILE;
+        return 0;
+    }
+    return len;
+}
+
+// md_read_array initializes the array with length read from the reader,
+// allocated like md_read_alloc does, calling callback for each element.
+void md_read_array(MDReader *reader, MDArray *array, size_t size, MDInitFunc callback) {
+    int len = md_read_length(reader);
+    md_array_init(array);
+    if (!len)
+        return;
+    array->_data = md_read_alloc(reader, len * size, true);
+    if (!array->_data)
+        return;
+    array->len = len;
+    for (int i = 0; i < len && callback; ++i)
+        callback((void *)((char *)array->_data + i * size));
+}
+
+void md_read_rich_text(MDReader *reader, MDRichText *richText) {
+    richText->text = md_read_string(reader);
+    richText->format = md_read_integer(reader);
+#ifdef MD_CUSTOM_FIELD_RICH_TEXT
+    richText->MD_CUSTOM_FIELD_RICH_TEXT = NULL;
+#endif
+}
+
+MDArray md_read_files(MDReader *reader) {
+    MDArray files;
+    md_read_array(reader, &files, sizeof(MDFile), (MDInitFunc)md_file_init);
+    for (int i = 0; i < files.len && !*reader->error; ++i) {
+        MDFile *file = &MD_FILES(files)[i];
+        file->filename = md_read_string(reader);
+        file->filesize = md_read_integer(reader);
+        file->url = md_read_string(reader);
+        file->timeModified = md_read_integer(reader);
+    }
+    return files;
+}
+
+void md_read_file_submission(MDReader *reader, MDFileSubmission *submission) {
+    submission->status = md_read_integer(reader);
+    submission->maxUploadedFiles = md_read_integer(reader);
+    submission->maxSubmissionSize = md_read_integer(reader);
+    submission->acceptedFileTypes = md_read_string(reader);
+}
+
+void md_read_text_submission(MDReader *reader, MDTextSubmission *submission) {
+    submission->status = md_read_integer(reader);
+    submission->wordLimit = md_read_integer(reader);
+}
+
+void md_write_assignment_status(MDWriter *writer, MDModAssignmentStatus *status) {
+    md_write_integer(writer, status->state);
+    md_write_integer(writer, status->submitDate);
+    md_write_integer(writer, status->gradeDate);
+    md_write_files(writer, status->submittedFiles);
+    md_write_rich_text(writer, &status->submittedText);
+    md_write_integer(writer, status->graded);
+    md_write_string(writer, status->grade);
+}
+
+void md_read_assignment_status(MDReader *reader, MDModAssignmentStatus *status) {
+    status->state = md_read_integer(reader);
+    status->submitDate = md_read_integer(reader);
+    status->gradeDate = md_read_integer(reader);
+    status->submittedFiles = md_read_files(reader);
+    md_read_rich_text(reader, &status->submittedText);
+    status->graded = md_read_integer(reader);
+    status->grade = md_read_string(reader);
+}
+
+void md_write_workshop_status(MDWriter *writer, MDModWorkshopStatus *status) {
+    md_write_integer(writer, status->submitted);
+    md_write_string(writer, status->title);
+    md_write_integer(writer, status->submitDate);
+    md_write_files(writer, status->submittedFiles);
+    md_write_rich_text(writer, &status->submittedText);
+}
+
+void md_read_workshop_status(MDReader *reader, MDModWorkshopStatus *status) {
+    status->submitted = md_read_integer(reader);
+    status->title = md_read_string(reader);
+    status->submitDate = md_read_integer(reader);
+    status->submittedFiles = md_read_files(reader);
+    md_read_rich_text(reader, &status->submittedText);
+}
+
+void md_mod_assignment_write(MDWriter *writer, MDModule *module) {
+    MDModAssignment *assignment = &module->contents.assignment;
+    md_write_integer(writer, assignment->fromDate);
+    md_write_integer(writer, assignment->dueDate);
+    md_write_integer(writer, assignment->cutOffDate);
+    md_write_rich_text(writer, &assignment->description);
+    md_write_files(writer, assignment->files);
+    md_write_file_submission(writer, &assignment->fileSubmission);
+    md_write_text_submission(writer, &assignment->textSubmission);
+    md_write_assignment_status(writer, &assignment->status);
+}
+
+void md_mod_assignment_read(MDReader *reader, MDModule *module) {
+    MDModAssignment *assignment = &module->contents.assignment;
+    assignment->fromDate = md_read_integer(reader);
+    assignment->dueDate = md_read_integer(reader);
+    assignment->cutOffDate = md_read_integer(reader);
+    md_read_rich_text(reader, &assignment->description);
+    assignment->files = md_read_files(reader);
+    md_read_file_submission(reader, &assignment->fileSubmission);
+    md_read_text_submission(reader, &assignment->textSubmission);
+    md_read_assignment_status(reader, &assignment->status);
+}
+
+void md_mod_workshop_write(MDWriter *writer, MDModule *module) {
+    MDModWorkshop *workshop = &module->contents.workshop;
+    md_write_integer(writer, workshop->fromDate);
+    md_write_integer(writer, workshop->dueDate);
+    md_write_integer(writer, workshop->lateSubmissions);
+    md_write_rich_text(writer, &workshop->description);
+    md_write_rich_text(writer, &workshop->instructions);
+    md_write_file_submission(writer, &workshop->fileSubmission);
+    md_write_text_submission(writer, &workshop->textSubmission);
+    md_write_workshop_status(writer, &workshop->status);
+}
+
+void md_mod_workshop_read(MDReader *reader, MDModule *module) {
+    MDModWorkshop *workshop = &module->contents.workshop;
+    workshop->fromDate = md_read_integer(reader);
+    workshop->dueDate = md_read_integer(reader);
+    workshop->lateSubmissions = md_read_integer(reader);
+    md_read_rich_text(reader, &workshop->description);
+    md_read_rich_text(reader, &workshop->instructions);
+    md_read_file_submission(reader, &workshop->fileSubmission);
+    md_read_text_submission(reader, &workshop->textSubmission);
+    md_read_workshop_status(reader, &workshop->status);
+}
+
+void md_mod_resource_write(MDWriter *writer, MDModule *module) {
+    MDModResource *resource = &module->contents.resource;
+    md_write_rich_text(writer, &resource->description);
+    md_write_files(writer, resource->files);
+}
+
+void md_mod_resource_read(MDReader *reader, MDModule *module) {
+    MDModResource *resource = &module->contents.resource;
+    md_read_rich_text(reader, &resource->description);
+    resource->files = md_read_files(reader);
+}
+
+void md_mod_url_write(MDWriter *writer, MDModule *module) {
+    MDModUrl *url = &module->contents.url;
+    md_write_rich_text(writer, &url->description);
+    md_write_string(writer, url->name);
+    md_write_string(writer, url->url);
+}
+
+void md_mod_url_read(MDReader *reader, MDModule *module) {
+    MDModUrl *url = &module->contents.url;
+    md_read_rich_text(reader, &url->description);
+    url->name = md_read_string(reader);
+    url->url = md_read_string(reader);
+}
+
+void md_courses_write(MDWriter *writer, MDArray courses) {
+    md_write_integer(writer, courses.len);
+    for (int i = 0; i < courses.len && !*writer->error; ++i) {
+        MDCourse *course = &MD_COURSES(courses)[i];
+        md_write_integer(writer, course->id);
+        md_write_string(writer, course->name);
+        md_write_integer(writer, course->fetchTime);
+        md_write_integer(writer, course->syncTime);
+        md_write_integer(writer, course->topics.len);
+        for (int j = 0; j < course->topics.len; ++j) {
+            MDTopic *topic = &MD_TOPICS(course->topics)[j];
+            md_write_integer(writer, topic->id);
+            md_write_string(writer, topic->name);
+            md_write_rich_text(writer, &topic->summary);
+            md_write_integer(writer, topic->modules.len);
+            for (int k = 0; k < topic->modules.len; ++k) {
+                MDModule *module = &MD_MODULES(topic->modules)[k];
+                md_write_integer(writer, module->id);
+                md_write_integer(writer, module->instance);
+                md_mod_write(writer, module);
+            }
+        }
+    }
+}
+
+// md_courses_read reads courses written using md_courses_write. If snapshot
+// is true, they are read into a new arena owned by the returned array, which
+// is left empty on failure.
+MDArray md_courses_read(MDReader *reader, bool snapshot) {
+    Arena arena;
+    MDStringSet strings = {.slots = NULL, .len = 0, .capacity = 0};
+    arena_init(&arena);
+    if (snapshot) {
+        reader->arena = &arena;
+        reader->strings = &strings;
+    }
+    MDArray courses;
+    md_read_array(reader, &courses, sizeof(MDCourse), (MDInitFunc)md_course_init);
+    for (int i = 0; i < courses.len && !*reader->error; ++i) {
+        MDCourse *course = &MD_COURSES(courses)[i];
+        course->id = md_read_integer(reader);
+        course->name = md_read_string(reader);
+        course->fetchTime = md_read_integer(reader);
+        course->syncTime = md_read_integer(reader);
+        md_read_array(reader, &course->topics, sizeof(MDTopic), (MDInitFunc)md_topic_init);
+        for (int j = 0; j < course->topics.len && !*reader->error; ++j) {
+            MDTopic *topic = &MD_TOPICS(course->topics)[j];
+            topic->id = md_read_integer(reader);
+            topic->name = md_read_string(reader);
+            md_read_rich_text(reader, &topic->summary);
+            md_read_array(reader, &topic->modules, sizeof(MDModule), (MDInitFunc)md_module_init);
+            for (int k = 0; k < topic->modules.len && !*reader->error; ++k) {
+                MDModule *module = &MD_MODULES(topic->modules)[k];
+                module->id = md_read_integer(reader);
+                module->instance = md_read_integer(reader);
+                md_mod_read(reader, module);
+            }
+        }
+    }
+
+    if (snapshot) {
+        // The arena is stored in itself, so that the array can own it.
+        Arena *owner = *reader->error ? NULL : md_read_alloc(reader, sizeof(Arena), true);
+        if (owner) {
+            *owner = arena;
+            courses._arena = owner;
+        } else {
+            arena_cleanup(&arena);
+            md_array_init(&courses);
+        }
+        free(strings.slots);
+        reader->arena = NULL;
+        reader->strings = NULL;
+    }
+    return courses;
+}
+
+FILE *md_open_private_file(cchar *filename) {
+#ifdef _WIN32
+    return fopen(filename, "wb");
+#else
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+        return NULL;
+    // Files which existed already keep their permissions when opened, so they
+    // are set again.
+    FILE *file = fchmod(fd, S_IRUSR | S_IWUSR) ? NULL : fdopen(fd, "wb");
+    if (!file)
+        close(fd);
+    return file;
+#endif
+}
+
+void md_courses_save_to_file(MDArray courses, cchar *filename, MDError *error) {
+    *error = MD_ERR_NONE;
+    // Write to temporary file first, so that readers never see partially
+    // written tree.
+    char tmpFilename[strlen(filename) + sizeof(".tmp")];
+    sprintf(tmpFilename, "%s.tmp", filename);
+
+    FILE *file = md_open_private_file(tmpFilename);
+    if (!file) {
+        *error = MD_ERR_FILE_OPERATION;
+    } else {
+        MDWriter writer = {.file = file, .data = NULL, .error = error};
+        md_write_bytes(&writer, MD_STORAGE_MAGIC, sizeof(MD_STORAGE_MAGIC) - 1);
+        md_write_integer(&writer, MD_STORAGE_VERSION);
+        md_write_integer(&writer, MD_STORAGE_BYTE_ORDER);
+        md_courses_write(&writer, courses);
+        if (fclose(file) && !*error)
+            *error = MD_ERR_FILE_OPERATION;
+#ifdef _WIN32
+        // Rename does not replace existing files on windows.
+        if (!*error)
+            remove(filename);
+#endif
+        if (!*error && rename(tmpFilename, filename))
+            *error = MD_ERR_FILE_OPERATION;
+        if (*error)
+            remove(tmpFilename);
+    }
+
+    if (*error == MD_ERR_FILE_OPERATION)
+        md_error_set_message(filename);
+}
+
+MDArray md_courses_load_from_file(cchar *filename, MDError *error) {
+    *error = MD_ERR_NONE;
+    MDArray courses;
+    md_array_init(&courses);
+    FMap map;
+    if (!fmap_open(&map, filename)) {
+        *error = MD_ERR_FILE_OPERATION;
+        md_error_set_message(filename);
+        return courses;
+    }
+
+    MDReader reader = {.it = map.data, .end = map.data + map.size, .error = error};
+    char magic[sizeof(MD_STORAGE_MAGIC) - 1];
+    md_read_bytes(&reader, magic, sizeof(magic));
+    if (!*error && memcmp(magic, MD_STORAGE_MAGIC, sizeof(magic)))
+        *error = MD_ERR_INVALID_FILE;
+    if (md_read_integer(&reader) != MD_STORAGE_VERSION || md_read_integer(&reader) != MD_STORAGE_BYTE_ORDER)
+        *error = MD_ERR_INVALID_FILE;
+    if (!*error)
+        courses = md_courses_read(&reader, true);
+    if (!*error && reader.it != reader.end)
+        *error = MD_ERR_INVALID_FILE;
+    fmap_close(&map);
+
+    if (*error) {
+        md_courses_cleanup(courses);
+        md_array_init(&courses);
+        md_error_set_message(filename);
+    }
+    return courses;
+}
+
+MDArray md_courses_clone(MDArray courses, MDError *error) {
+    *error = MD_ERR_NONE;
+    return md_courses_copy(courses, true, error);
+}
+
+MDArray md_courses_copy(MDArray courses, bool snapshot, MDError *error) {
+    // Courses are copied by writing them to memory and reading them back, so
+    // that no separate copying code is needed for every type of module.
+    MDWriter writer = {.file = NULL, .data = NULL, .size = 0, .capacity = 0, .error = error};
+    md_courses_write(&writer, courses);
+
+    MDArray clone;
+    md_array_init(&clone);
+    if (!*error) {
+        MDReader reader = {.it = writer.data, .end = writer.data + writer.size, .error = error};
+        clone = md_courses_read(&reader, snapshot);
+    }
+    free(writer.data);
+    if (*error) {
+        md_courses_cleanup(clone);
+        md_array_init(&clone);
+    }
+    return clone;
+}
+
+void md_status_ref_copy_to_arena(MDStatusRef *statusRef) {
+    MDError error = MD_ERR_NONE;
+    MDWriter writer = {.file = NULL, .data = NULL, .size = 0, .capacity = 0, .error = &error};
+    MDModule *module = statusRef->module;
+    if (module->type == MD_MOD_ASSIGNMENT)
+        md_write_assignment_status(&writer, &statusRef->status.assignment);
+    else if (module->type == MD_MOD_WORKSHOP)
+        md_write_workshop_status(&writer, &statusRef->status.workshop);
+
+    // The replaced status stays in the arena, as memory of an arena can't be
+    // released on its own.
+    MDReader reader = {.it = writer.data, .end = writer.data + writer.size, .arena = statusRef->arena, .error = &error};
+    if (module->type == MD_MOD_ASSIGNMENT) {
+        MDModAssignmentStatus status;
+        md_mod_assignment_status_init(&status);
+        md_read_assignment_status(&reader, &status);
+        if (!error)
+            module->contents.assignment.status = status;
+    } else if (module->type == MD_MOD_WORKSHOP) {
+        MDModWorkshopStatus status;
+        md_mod_workshop_status_init(&status);
+        md_read_workshop_status(&reader, &status);
+        if (!error)
+            module->contents.workshop.status = status;
+    }
+    free(writer.data);
+}
@@ -0,0 +1,280 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Part of moodle library (incremental synchronization of courses). See moodle.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "internal.h"
+
+// MD_SYNC_FULL_INTERVAL is the time in seconds after which contents of a course
+// are fetched again even if Moodle reports no updates, because removed modules
+// and changes of topics are not reported.
+#define MD_SYNC_FULL_INTERVAL (24 * 60 * 60)
+
+// MDCourseSync holds the state of a single course during synchronization.
+typedef struct MDCourseSync {
+    MDCourse *previous;  // matching previously fetched course or NULL.
+    bool fetch;          // whether contents of the course need to be fetched.
+    bool allUpdated;     // whether every module should be considered updated.
+    bool copied;         // whether contents were copied from previous course.
+    MDArray updated;     // Array with ids (int) of updated modules.
+} MDCourseSync;
+
+MDCourse *md_courses_find(MDArray courses, int id) {
+    for (int i = 0; i < courses.len; ++i) {
+        if (MD_COURSES(courses)[i].id == id)
+            return &MD_COURSES(courses)[i];
+    }
+    return NULL;
+}
+
+MDModule *md_course_find_module(MDCourse *course, int id, int instance) {
+    for (int i = 0; i < course->topics.len; ++i) {
+        MDTopic *topic = &MD_TOPICS(course->topics)[i];
+        for (int j = 0; j < topic->modules.len; ++j) {
+            MDModule *module = &MD_MODULES(topic->modules)[j];
+            if (module->id == id && module->instance == instance)
+                return module;
+        }
+    }
+    return NULL;
+}
+
+// md_course_sync_parse_updates parses the response of
+// core_course_get_updates_since.
+void md_course_sync_parse_updates(MDCourseSync *sync, Json *json, MDError *error) {
+    Json *instances = json_get_array(json, "instances", error);
+    if (*error)
+        return;
+    md_array_init_new(&sync->updated, sizeof(int), instances->len, NULL, error);
+    for (int i = 0; i < instances->len && !*error; ++i) {
+        Json *instance = &instances->values[i];
+        cchar *contextLevel = json_get_string_no_alloc(instance, "contextlevel", error);
+        int id = json_get_integer(instance, "id", error);
+        if (!*error) {
+            if (strcmp(contextLevel, "module"))
+                sync->allUpdated = true;
+            MD_ARR(sync->updated, int)[i] = id;
+        }
+    }
+    if (instances->len)
+        sync->fetch = true;
+}
+
+// md_course_sync_is_updated returns true if the status of a module needs to be
+// loaded again.
+bool md_course_sync_is_updated(MDCourseSync *sync, MDModule *module) {
+    if (sync->allUpdated || !sync->previous || sync->previous->syncTime == MD_DATE_NONE)
+        return true;
+    for (int i = 0; i < sync->updated.len; ++i) {
+        if (MD_ARR(sync->updated, int)[i] == module->id)
+            return true;
+    }
+    return !md_course_find_module(sync->previous, module->id, module->instance);
+}
+
+void md_courses_sync_updates_callback(void *data, int index, Json *json, MDError *error) {
+    MDCourseSync **checked = data;
+    if (*error)
+        return;
+    md_check_moodle_exception(json, error);
+    if (!*error)
+        md_course_sync_parse_updates(checked[index], json, error);
+    md_cleanup_json(json);
+}
+
+// md_courses_sync_check_updates asks Moodle what has changed in previously
+// fetched courses.
+void md_courses_sync_check_updates(MDClient *client, MDArray courses, MDCourseSync *syncs, time_t syncTime,
+                                   int priorityCourseId, MDError *error) {
+    int count = 0;
+    for (int i = 0; i < courses.len; ++i) {
+        if (syncs[i].previous && syncs[i].previous->fetchTime != MD_DATE_NONE)
+            ++count;
+    }
+    if (!count)
+        return;
+
+    char urls[count][MD_URL_LENGTH];
+    MDHttpRequest requests[count];
+    MDCourseSync *checked[count];
+    int index = 0;
+    for (int i = 0; i < courses.len; ++i) {
+        MDCourse *previous = syncs[i].previous;
+        if (previous && previous->fetchTime != MD_DATE_NONE) {
+            time_t since = previous->syncTime != MD_DATE_NONE ? previous->syncTime : previous->fetchTime;
+            syncs[i].fetch = syncTime - previous->fetchTime > MD_SYNC_FULL_INTERVAL;
+            md_client_write_url(client, urls[index], "core_course_get_updates_since", "&courseid=%d&since=%ld", previous->id, (long)since);
+            int priority = previous->id == priorityCourseId ? MD_HTTP_PRIORITY_HIGH : MD_HTTP_PRIORITY_NORMAL;
+            requests[index] = (MDHttpRequest){.url = urls[index], .priority = priority, .decoder = NULL};
+            checked[index++] = &syncs[i];
+        }
+    }
+
+    http_multi_request(client->pool, requests, count, md_courses_sync_updates_callback, checked, error);
+}
+
+// md_courses_sync_fetch_contents fetches contents of the courses that need it.
+void md_courses_sync_fetch_contents(MDClient *client, MDArray courses, MDCourseSync *syncs, int priorityCourseId,
+                                    MDError *error) {
+    int count = 0;
+    for (int i = 0; i < courses.len; ++i)
+        count += syncs[i].fetch;
+
+    MDArray fetched;
+    md_array_init_new(&fetched, sizeof(MDCourse), count, NULL, error);
+    if (*error || !count)
+        return;
+    for (int i = 0, index = 0; i < courses.len; ++i) {
+        if (syncs[i].fetch)
+            MD_COURSES(fetched)[index++] = MD_COURSES(courses)[i];
+    }
+    md_courses_fetch_topic_contents(client, fetched, priorityCourseId, error);
+    // The fetched courses are moved back, so that they are owned by courses.
+    for (int i = 0, index = 0; i < courses.len; ++i) {
+        if (syncs[i].fetch)
+            MD_COURSES(courses)[i] = MD_COURSES(fetched)[index++];
+    }
+    md_array_cleanup(&fetched, sizeof(MDCourse), NULL);
+}
+
+// md_courses_sync_load_status loads statuses of the modules that need it,
+// starting with the modules of the course with priorityCourseId.
+MDLoadedStatus md_courses_sync_load_status(MDClient *client, MDArray courses, MDCourseSync *syncs, int priorityCourseId,
+                                           MDError *error) {
+    int count = 0;
+    for (int i = 0; i < courses.len; ++i) {
+        MDCourse *course = &MD_COURSES(courses)[i];
+        for (int j = 0; j < course->topics.len; ++j)
+            count += MD_TOPICS(course->topics)[j].modules.len;
+    }
+
+    MDArray modules;
+    MDLoadedStatus status;
+    md_array_init(&status.internalReferences);
+    md_array_init_new(&modules, sizeof(MDModule *), count, NULL, error);
+    if (*error)
+        return status;
+    modules.len = 0;
+    int first = 0;
+    for (int i = 0; i < courses.len; ++i) {
+        if (MD_COURSES(courses)[i].id == priorityCourseId)
+            first = i;
+    }
+    for (int n = 0; n < courses.len; ++n) {
+        // Requests are made in order, so the priority course is moved to the
+        // front.
+        int i = n == 0 ? first : n <= first ? n - 1 : n;
+        MDCourse *course = &MD_COURSES(courses)[i];
+        for (int j = 0; j < course->topics.len; ++j) {
+            MDTopic *topic = &MD_TOPICS(course->topics)[j];
+            for (int k = 0; k < topic->modules.len; ++k) {
+                MDModule *module = &MD_MODULES(topic->modules)[k];
+                if (md_course_sync_is_updated(&syncs[i], module))
+                    MD_ARR(modules, MDModule *)[modules.len++] = module;
+            }
+        }
+    }
+    status = md_modules_load_status(client, modules, error);
+    md_array_cleanup(&modules, sizeof(MDModule *), NULL);
+    return status;
+}
+
+// md_courses_sync_take_previous takes what's left unchanged from the previous
+// courses. Previous courses are snapshots, which can't be changed, so their
+// contents are only shared with not fetched courses until the new snapshot is
+// made (see md_courses_sync_share_previous). Contents of courses which were
+// never synced are copied instead, as statuses of all their modules are loaded.
+void md_courses_sync_take_previous(MDArray courses, MDCourseSync *syncs, time_t syncTime, MDError *error) {
+    for (int i = 0; i < courses.len && !*error; ++i) {
+        MDCourse *course = &MD_COURSES(courses)[i], *previous = syncs[i].previous;
+        if (!syncs[i].fetch) {
+            course->fetchTime = previous->fetchTime;
+            if (previous->syncTime == MD_DATE_NONE) {
+                MDArray copy = md_courses_copy((MDArray){.len = 1, ._data = previous, ._arena = NULL}, false, error);
+                if (!*error) {
+                    course->topics = MD_COURSES(copy)[0].topics;
+                    md_array_init(&MD_COURSES(copy)[0].topics);
+                    syncs[i].copied = true;
+                }
+                md_courses_cleanup(copy);
+            }
+        }
+        course->syncTime = syncTime;
+    }
+}
+
+// md_courses_sync_share_previous makes the courses share unchanged contents and
+// statuses of previous courses without copying them if share is true, or ends
+// the sharing otherwise.
+void md_courses_sync_share_previous(MDArray courses, MDCourseSync *syncs, bool share) {
+    for (int i = 0; i < courses.len; ++i) {
+        MDCourse *course = &MD_COURSES(courses)[i], *previous = syncs[i].previous;
+        if (!syncs[i].fetch && !syncs[i].copied) {
+            if (share)
+                course->topics = previous->topics;
+            else
+                md_array_init(&course->topics);
+        } else if (syncs[i].fetch && previous) {
+            for (int j = 0; j < course->topics.len; ++j) {
+                MDTopic *topic = &MD_TOPICS(course->topics)[j];
+                for (int k = 0; k < topic->modules.len; ++k) {
+                    MDModule *module = &MD_MODULES(topic->modules)[k];
+                    if (!md_course_sync_is_updated(&syncs[i], module)) {
+                        MDModule *from = md_course_find_module(previous, module->id, module->instance);
+                        md_module_share_status(module, from, share);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void md_client_sync_courses(MDClient *client, MDArray *courses, bool sortByName, int priorityCourseId, MDError *error) {
+    *error = MD_ERR_NONE;
+    time_t syncTime = time(NULL) - MD_SYNC_TIME_MARGIN;
+    MDArray synced = md_client_fetch_course_list(client, sortByName, error);
+
+    MDArray syncs;
+    md_array_init_new(&syncs, sizeof(MDCourseSync), synced.len, NULL, error);
+    for (int i = 0; i < syncs.len; ++i) {
+        MDCourseSync *sync = &MD_ARR(syncs, MDCourseSync)[i];
+        sync->previous = md_courses_find(*courses, MD_COURSES(synced)[i].id);
+        sync->fetch = !sync->previous || sync->previous->fetchTime == MD_DATE_NONE;
+        sync->allUpdated = sync->copied = false;
+        md_array_init(&sync->updated);
+    }
+
+    if (!*error)
+        md_courses_sync_check_updates(client, synced, syncs._data, syncTime, priorityCourseId, error);
+    if (!*error)
+        md_courses_sync_fetch_contents(client, synced, syncs._data, priorityCourseId, error);
+    if (!*error)
+        md_courses_sync_take_previous(synced, syncs._data, syncTime, error);
+    if (!*error) {
+        MDLoadedStatus status = md_courses_sync_load_status(client, synced, syncs._data, priorityCourseId, error);
+        if (!*error)
+            md_loaded_status_apply(status);
+        md_loaded_status_cleanup(status);
+    }
+    MDArray snapshot;
+    md_array_init(&snapshot);
+    if (!*error) {
+        md_courses_sync_share_previous(synced, syncs._data, true);
+        snapshot = md_courses_clone(synced, error);
+        md_courses_sync_share_previous(synced, syncs._data, false);
+    }
+
+    for (int i = 0; i < syncs.len; ++i)
+        md_array_cleanup(&MD_ARR(syncs, MDCourseSync)[i].updated, sizeof(int), NULL);
+    md_array_cleanup(&syncs, sizeof(MDCourseSync), NULL);
+    md_courses_cleanup(synced);
+    if (!*error) {
+        md_courses_cleanup(*courses);
+        *courses = snapshot;
+    }
+}
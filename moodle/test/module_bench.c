@@ -0,0 +1,101 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Benchmark of locating the modules of courses, as done when the data of
+ * modules is applied to them (see md_courses_apply_module_data). Run main to
+ * print the number of lookups per second of each way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "internal.h"
+#include "moodle.h"
+
+#define BENCH_COURSES 100
+#define BENCH_TOPICS 10
+#define BENCH_MODULES 20  // per topic.
+
+MDArray generateCourses(MDError *error);
+double benchLinear(MDArray courses, int *ids, int count);
+double benchIndex(MDArray courses, int *ids, int count);
+
+int main() {
+    MDError error = MD_ERR_NONE;
+    MDArray courses = generateCourses(&error);
+    int count = BENCH_COURSES * BENCH_TOPICS * BENCH_MODULES;
+    // Course and module ids of every module, looked up in shuffled order.
+    int *ids = malloc(count * 2 * sizeof(int));
+    if (error || !ids) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < count; ++i) {
+        ids[i * 2] = i / (BENCH_TOPICS * BENCH_MODULES);
+        ids[i * 2 + 1] = i;
+    }
+    srand(1);
+    for (int i = count - 1; i > 0; --i) {
+        int j = rand() % (i + 1), courseId = ids[i * 2], moduleId = ids[i * 2 + 1];
+        ids[i * 2] = ids[j * 2];
+        ids[i * 2 + 1] = ids[j * 2 + 1];
+        ids[j * 2] = courseId;
+        ids[j * 2 + 1] = moduleId;
+    }
+
+    printf("%d courses, %d modules\n", BENCH_COURSES, count);
+    printf("%-28s %12s\n", "lookup", "klookups/s");
+    printf("%-28s %12.1f\n", "md_courses_locate_module", benchLinear(courses, ids, count));
+    printf("%-28s %12.1f\n", "md_module_index (with build)", benchIndex(courses, ids, count));
+    free(ids);
+    md_courses_cleanup(courses);
+}
+
+// generateCourses generates courses with ids from 0, each with the same number
+// of modules. Module ids are unique and instances are module ids plus one.
+MDArray generateCourses(MDError *error) {
+    MDArray courses;
+    md_array_init_new(&courses, sizeof(MDCourse), BENCH_COURSES, (MDInitFunc)md_course_init, error);
+    for (int i = 0; i < courses.len && !*error; ++i) {
+        MDCourse *course = &MD_COURSES(courses)[i];
+        course->id = i;
+        md_array_init_new(&course->topics, sizeof(MDTopic), BENCH_TOPICS, (MDInitFunc)md_topic_init, error);
+        for (int j = 0; j < course->topics.len && !*error; ++j) {
+            MDTopic *topic = &MD_TOPICS(course->topics)[j];
+            md_array_init_new(&topic->modules, sizeof(MDModule), BENCH_MODULES, (MDInitFunc)md_module_init, error);
+            for (int k = 0; k < topic->modules.len; ++k) {
+                MDModule *module = &MD_MODULES(topic->modules)[k];
+                module->id = (i * BENCH_TOPICS + j) * BENCH_MODULES + k;
+                module->instance = module->id + 1;
+            }
+        }
+    }
+    return courses;
+}
+
+// seconds returns seconds elapsed since start.
+double seconds(clock_t start) {
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    return seconds > 0 ? seconds : 1e-9;
+}
+
+double benchLinear(MDArray courses, int *ids, int count) {
+    MDError error = MD_ERR_NONE;
+    clock_t start = clock();
+    for (int i = 0; i < count && !error; ++i)
+        md_courses_locate_module(courses, ids[i * 2], ids[i * 2 + 1], ids[i * 2 + 1] + 1, &error);
+    return error ? -1 : count / 1e3 / seconds(start);
+}
+
+double benchIndex(MDArray courses, int *ids, int count) {
+    MDError error = MD_ERR_NONE;
+    clock_t start = clock();
+    MDModuleIndex index;
+    md_module_index_init(&index);
+    md_module_index_build(&index, courses, &error);
+    for (int i = 0; i < count && !error; ++i)
+        md_module_index_get(&index, ids[i * 2], ids[i * 2 + 1], ids[i * 2 + 1] + 1, &error);
+    md_module_index_cleanup(&index);
+    return error ? -1 : count / 1e3 / seconds(start);
+}
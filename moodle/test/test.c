@@ -32,7 +32,7 @@
 
 // Gets token from
 char *get_token(MDError *error) {
-    char *data = http_get_request(DEMO_SITE
+    char *data = http_get_request(NULL, DEMO_SITE
                                   "/login/token.php"
                                   "?username=markellis267&password=moodle&service=moodle_mobile_app",
                                   error);
@@ -44,7 +44,6 @@ char *get_token(MDError *error) {
         }
         md_cleanup_json(json);
     }
-    free(data);
     return token;
 }
  
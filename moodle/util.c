@@ -7,13 +7,17 @@
 
 #include <curl/curl.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "internal.h"
 #include "json.h"
-#define CURL_MAX_PARALLEL 20
+#include "thread.h"
 #define FREAD_CHUNK_SIZE 4096
+// MD_HTTP_POLL_TIMEOUT is the longest time in milliseconds to wait for
+// activity on transfers before checking them again.
+#define MD_HTTP_POLL_TIMEOUT 1000
 
 void md_array_append(MDArray *array, const void *ptr, size_t size, MDError *error) {
     ++array->len;
@@ -34,6 +38,18 @@ size_t write_memblock_callback(void *contents, size_t size, size_t nmemb, void *
     size_t realsize = size * nmemb;
     struct Memblock *mem = (struct Memblock *)userp;
 
+    if (mem->job) {
+        if (!md_parse_job_feed(mem->job, contents, realsize, mem->error))
+            return 0;
+    } else if (mem->parser && json_parser_feed(mem->parser, contents, realsize)) {
+        // A decoder stopping the parser has its own error.
+        if (!*mem->error)
+            *mem->error = MD_ERR_INVALID_JSON;
+        return 0;
+    }
+    if (mem->parser && !mem->keep)
+        return realsize;
+
     char *ptr = (char *)md_realloc(mem->memory, mem->size + realsize + 1, mem->error);
     if (ptr == NULL)
         return 0;
@@ -88,8 +104,8 @@ void str_replace(char *str, cchar *needle, cchar *replacement) {
     }
 }
 
-CURL *create_curl(cchar *url, void *data, WriteCallback callback, MDError *error) {
-    CURL *handle = curl_easy_init();
+CURL *create_curl(MDHttpPool *pool, cchar *url, void *data, WriteCallback callback, MDError *error) {
+    CURL *handle = md_http_pool_take_easy(pool, error);
     if (handle) {
         curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L);
         curl_easy_setopt(handle, CURLOPT_URL, url);
@@ -97,18 +113,27 @@ CURL *create_curl(cchar *url, void *data, WriteCallback callback, MDError *error
         curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, callback);
         curl_easy_setopt(handle, CURLOPT_WRITEDATA, data);
         curl_easy_setopt(handle, CURLOPT_USERAGENT, "moodle-tui/moot");
-    } else {
-        *error = MD_ERR_CURL_FAIL;
+        // Signals can't be used for timeouts when requests are made from
+        // multiple threads.
+        curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+        // Parallel requests rather wait for a connection to multiplex on than
+        // open new ones.
+        curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
     }
     return handle;
 }
 
+void release_curl(MDHttpPool *pool, CURL *handle) {
+    md_http_pool_give_easy(pool, handle);
+}
+
 size_t write_stream_callback(void *contents, size_t size, size_t nmemb, void *stream) {
     return fwrite(contents, size, nmemb, (FILE *)stream);
 }
 
-void http_get_request_to_file(cchar *url, FILE *stream, MDError *error) {
-    CURL *handle = create_curl(url, (void *)stream, write_stream_callback, error);
+void http_get_request_to_file(MDHttpPool *pool, cchar *url, FILE *stream, MDError *error) {
+    CURL *handle = create_curl(pool, url, (void *)stream, write_stream_callback, error);
     if (!handle)
         return;
 
@@ -118,105 +143,428 @@ void http_get_request_to_file(cchar *url, FILE *stream, MDError *error) {
         *error = MD_ERR_HTTP_REQUEST_FAIL;
     }
 
-    curl_easy_cleanup(handle);
+    release_curl(pool, handle);
 }
 
-char *http_get_request(cchar *url, MDError *error) {
+char *http_get_request(MDHttpPool *pool, cchar *url, MDError *error) {
     ENSURE_EMPTY_ERROR(error);
     CURL *handle;
     CURLcode res;
 
-    struct Memblock chunk;
-    chunk.size = 0;
+    struct Memblock chunk = {.size = 0, .error = error, .parser = NULL, .keep = true};
     chunk.memory = (char *)md_malloc(1, error);
     if (!*error) {
-        handle = create_curl(url, (void *)&chunk, write_memblock_callback, error);
+        handle = create_curl(pool, url, (void *)&chunk, write_memblock_callback, error);
         if (!*error) {
+            MDHttpCacheEntry entry;
+            md_http_cache_prepare(&entry, handle, url, &chunk);
             res = curl_easy_perform(handle);
-            if (res != CURLE_OK) {
+            if (res == CURLE_OK) {
+                md_http_cache_finish(&entry, handle);
+            } else {
                 md_error_set_message(curl_easy_strerror(res));
                 *error = MD_ERR_HTTP_REQUEST_FAIL;
                 free(chunk.memory);
                 chunk.memory = NULL;
             }
-            curl_easy_cleanup(handle);
+            release_curl(pool, handle);
+            md_http_cache_entry_cleanup(&entry);
         }
     }
     return chunk.memory;
 }
 
-char **http_get_multi_request(char *urls[], unsigned int size, MDError *error) {
-    ENSURE_EMPTY_ERROR(error);
-    CURLMsg *msg;
-    unsigned int transfers = 0;
-    int msgsLeft = -1;
-    int stillAlive = 1;
-
-    CURLM *multi = curl_multi_init();
-    if (!multi) {
-        *error = MD_ERR_CURL_FAIL;
-        return NULL;
+// MDHost counts active transfers to a single host during http_multi_request.
+typedef struct MDHost {
+    cchar *name;  // points to the host in the url of the first request.
+    size_t length;
+    int active;
+} MDHost;
+
+typedef enum MDTransferState {
+    MD_TRANSFER_QUEUED,
+    MD_TRANSFER_ACTIVE,
+    MD_TRANSFER_PARSING,  // received, but still being parsed.
+    MD_TRANSFER_DONE,
+} MDTransferState;
+
+// MDParseChunk is a received piece of a response waiting to be parsed.
+typedef struct MDParseChunk {
+    struct MDParseChunk *next;
+    size_t size;
+    char data[];
+} MDParseChunk;
+
+// MDParseJobs is the state shared by the parse jobs of http_multi_request.
+typedef struct MDParseJobs {
+    MDWorkers *workers;  // NULL to parse on the calling thread.
+    CURLM *multi;        // woken up when a job is done.
+    void *mutex;         // guards the jobs and the fields below.
+    int *done, doneCount;  // indices of the transfers which are parsed.
+} MDParseJobs;
+
+// MDParseJob parses a single response on the workers, in the order it's
+// received. At most one task runs the job at a time, so responses are parsed
+// in parallel with each other, but each by one thread at a time. All the
+// fields except parser are guarded by the mutex of the jobs.
+struct MDParseJob {
+    MDParseJobs *jobs;
+    JsonParser *parser;
+    int index;  // of the transfer.
+    MDParseChunk *first, *last;
+    bool scheduled;  // a task is queued or running for the job.
+    bool finishing;  // no more data is coming.
+    bool received;   // the whole response was received.
+    bool done;
+    MDError error;
+    char *message;  // details of the error, which are kept per thread.
+};
+
+// MDTransfer is the state of a single request during http_multi_request.
+typedef struct MDTransfer {
+    int index, priority;
+    MDTransferState state;
+    MDHost *host;
+    CURL *handle;
+    CURLcode result;
+    Memblock chunk;  // only holds the body if it's going to be cached.
+    JsonParser parser;
+    MDParseJob job;
+    Json *json;               // NULL if the response is decoded.
+    MDJsonDecoder *decoder;
+    MDError error;
+    MDHttpCacheEntry cache;
+} MDTransfer;
+
+static atomic_int hostLimit = MD_HTTP_HOST_LIMIT;
+
+void md_http_set_host_limit(int limit) {
+    atomic_store(&hostLimit, limit < 1 ? 1 : limit);
+}
+
+// md_hosts_find returns the host of the url, adding it to hosts if it's new.
+MDHost *md_hosts_find(MDHost *hosts, int *count, cchar *url) {
+    cchar *name = strstr(url, "://");
+    name = name ? name + 3 : url;
+    size_t length = strcspn(name, "/?#");
+    for (int i = 0; i < *count; ++i) {
+        if (hosts[i].length == length && !strncmp(hosts[i].name, name, length))
+            return &hosts[i];
     }
-    curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long)CURL_MAX_PARALLEL);
+    hosts[*count] = (MDHost){.name = name, .length = length, .active = 0};
+    return &hosts[(*count)++];
+}
 
-    struct Memblock chunks[size];
-    for (int i = 0; i < size; ++i) {
-        chunks[i].memory = (char *)md_malloc(1, error);
-        chunks[i].size = 0;
-        chunks[i].memory[0] = 0;
+// md_parse_job_fail sets the error of the job, if it has none yet.
+static void md_parse_job_fail(MDParseJob *job, MDError error) {
+    if (!job->error) {
+        job->error = error;
+        cchar *details = md_error_get_details();
+        job->message = malloc(strlen(details) + 1);
+        if (job->message)
+            strcpy(job->message, details);
     }
-    CURL *handles[size];
-    for (int i = 0; i < size; ++i) {
-        handles[i] = create_curl(urls[i], (void *)&chunks[i], write_memblock_callback, error);
+}
+
+// md_parse_job_run parses the chunks received so far, and finishes the job if
+// no more are coming.
+static void md_parse_job_run(void *arg) {
+    MDParseJob *job = arg;
+    MDParseJobs *jobs = job->jobs;
+    th_mutex_lock(jobs->mutex);
+    MDParseChunk *chunk;
+    while ((chunk = job->first)) {
+        job->first = job->last = NULL;
+        bool failed = job->error;
+        th_mutex_unlock(jobs->mutex);
+        MDError error = MD_ERR_NONE;
+        while (chunk) {
+            MDParseChunk *next = chunk->next;
+            if (!failed && !error && json_parser_feed(job->parser, chunk->data, chunk->size))
+                error = MD_ERR_INVALID_JSON;
+            free(chunk);
+            chunk = next;
+        }
+        th_mutex_lock(jobs->mutex);
+        if (error)
+            md_parse_job_fail(job, error);
     }
-    if (!*error) {
-        for (transfers = 0; transfers < CURL_MAX_PARALLEL && transfers < size; transfers++)
-            curl_multi_add_handle(multi, handles[transfers]);
+    if (job->finishing) {
+        if (job->received && !job->error) {
+            th_mutex_unlock(jobs->mutex);
+            bool failed = json_parser_finish(job->parser) != JSON_ERR_OK;
+            th_mutex_lock(jobs->mutex);
+            if (failed)
+                md_parse_job_fail(job, MD_ERR_INVALID_JSON);
+        }
+        job->done = true;
+        jobs->done[jobs->doneCount++] = job->index;
+        curl_multi_wakeup(jobs->multi);
+    }
+    job->scheduled = false;
+    th_mutex_unlock(jobs->mutex);
+}
 
-        do {
-            curl_multi_perform(multi, &stillAlive);
+// md_parse_job_schedule submits a task for the job unless there already is one.
+// The mutex of the jobs must be locked, and is unlocked.
+static void md_parse_job_schedule(MDParseJob *job) {
+    bool schedule = !job->scheduled;
+    job->scheduled = true;
+    th_mutex_unlock(job->jobs->mutex);
+    if (schedule)
+        md_workers_submit(job->jobs->workers, md_parse_job_run, job);
+}
 
-            while ((msg = curl_multi_info_read(multi, &msgsLeft))) {
-                // TODO curl error
-                if (msg->msg != CURLMSG_DONE) {
-                    md_error_set_message(curl_easy_strerror(msg->data.result));
-                    *error = MD_ERR_HTTP_REQUEST_FAIL;
-                }
-                curl_multi_remove_handle(multi, msg->easy_handle);
-                curl_easy_cleanup(msg->easy_handle);
+bool md_parse_job_feed(MDParseJob *job, cchar *data, size_t size, MDError *error) {
+    MDParseChunk *chunk = md_malloc(sizeof(MDParseChunk) + size, error);
+    if (!chunk)
+        return false;
+    chunk->next = NULL;
+    chunk->size = size;
+    memcpy(chunk->data, data, size);
+    th_mutex_lock(job->jobs->mutex);
+    if (job->error) {
+        // The rest of the response is not needed anymore.
+        th_mutex_unlock(job->jobs->mutex);
+        free(chunk);
+        return false;
+    }
+    if (job->last)
+        job->last->next = chunk;
+    else
+        job->first = chunk;
+    job->last = chunk;
+    md_parse_job_schedule(job);
+    return true;
+}
 
-                if (transfers < size)
-                    curl_multi_add_handle(multi, handles[transfers]);
-            }
-            if (stillAlive)
-                curl_multi_wait(multi, NULL, 0, 500, NULL);
+// md_parse_job_finish tells the job that no more data is coming, and whether
+// the response was received whole.
+static void md_parse_job_finish(MDParseJob *job, bool received) {
+    th_mutex_lock(job->jobs->mutex);
+    job->finishing = true;
+    job->received = received;
+    md_parse_job_schedule(job);
+}
+
+int md_transfer_compare(const void *a, const void *b) {
+    const MDTransfer *left = a, *right = b;
+    if (left->priority != right->priority)
+        return right->priority - left->priority;
+    return left->index - right->index;
+}
 
-        } while (stillAlive || (transfers < size));
+void md_transfer_start(MDTransfer *transfer, MDHttpPool *pool, CURLM *multi, cchar *url) {
+    transfer->state = MD_TRANSFER_ACTIVE;
+    ++transfer->host->active;
+    transfer->chunk = (Memblock){.size = 0, .error = &transfer->error, .parser = &transfer->parser, .job = &transfer->job, .keep = false};
+    transfer->chunk.memory = md_malloc(1, &transfer->error);
+    if (!transfer->decoder)
+        transfer->json = md_new_json(&transfer->error);
+    if (!transfer->error) {
+        transfer->chunk.memory[0] = '\0';
+        if (transfer->decoder)
+            json_parser_init_handler(&transfer->parser, &transfer->decoder->handler);
+        else
+            json_parser_init_arena(&transfer->parser, transfer->json, md_json_arena(transfer->json));
+        json_parser_set_limits(&transfer->parser, JSON_DEFAULT_MAX_DEPTH, MD_JSON_MAX_SIZE);
+        transfer->handle = create_curl(pool, url, &transfer->chunk, write_memblock_callback, &transfer->error);
+    }
+    if (!transfer->error) {
+        md_http_cache_prepare(&transfer->cache, transfer->handle, url, &transfer->chunk);
+        curl_easy_setopt(transfer->handle, CURLOPT_PRIVATE, transfer);
+        if (curl_multi_add_handle(multi, transfer->handle) != CURLM_OK)
+            transfer->error = MD_ERR_CURL_FAIL;
+    }
+}
+
+// md_transfer_cleanup releases the parser of the transfer, leaving the parsed
+// json in it, if any.
+void md_transfer_cleanup(MDTransfer *transfer) {
+    json_parser_cleanup(&transfer->parser);
+    free(transfer->job.message);
+    transfer->job.message = NULL;
+    transfer->state = MD_TRANSFER_DONE;
+}
 
-        curl_multi_cleanup(multi);
+// md_transfer_stop releases the curl resources of the transfer, once nothing
+// more is going to be received.
+void md_transfer_stop(MDTransfer *transfer, MDHttpPool *pool, CURLM *multi) {
+    if (transfer->handle) {
+        curl_multi_remove_handle(multi, transfer->handle);
+        release_curl(pool, transfer->handle);
+        transfer->handle = NULL;
     }
+    md_http_cache_entry_cleanup(&transfer->cache);
+    free(transfer->chunk.memory);
+    transfer->chunk.memory = NULL;
+    --transfer->host->active;
+    transfer->state = MD_TRANSFER_PARSING;
+}
 
-    char **result = md_malloc(size * sizeof(char *), error);
-    if (!*error) {
-        for (int i = 0; i < size; ++i) {
-            result[i] = chunks[i].memory;
+// md_transfer_receive stops the transfer once curl is done with it, leaving
+// the rest of the response to be parsed.
+void md_transfer_receive(MDTransfer *transfer, MDHttpPool *pool, CURLM *multi, CURLcode result) {
+    transfer->result = result;
+    if (result == CURLE_OK)
+        md_http_cache_finish(&transfer->cache, transfer->handle);
+    md_transfer_stop(transfer, pool, multi);
+    md_parse_job_finish(&transfer->job, result == CURLE_OK && !transfer->error);
+}
+
+// md_transfer_finish passes the parsed response to the callback. The job of
+// the transfer must be done.
+void md_transfer_finish(MDTransfer *transfer, MDHttpCallback callback, void *data, MDError *error) {
+    if (!transfer->error && transfer->job.error) {
+        transfer->error = transfer->job.error;
+        if (transfer->job.message)
+            md_error_set_message(transfer->job.message);
+    }
+    if (transfer->result != CURLE_OK && !transfer->error) {
+        md_error_set_message(curl_easy_strerror(transfer->result));
+        transfer->error = MD_ERR_HTTP_REQUEST_FAIL;
+    }
+    md_transfer_cleanup(transfer);
+    if (transfer->decoder)
+        md_json_decoder_finish(transfer->decoder, &transfer->error);
+    *error = transfer->error;
+    if (*error) {
+        md_cleanup_json(transfer->json);
+        transfer->json = NULL;
+    }
+    if (callback)
+        callback(data, transfer->index, transfer->json, error);
+}
+
+// md_parse_jobs_take_done moves the indices of transfers which are parsed to
+// ready and returns the number of them. If wait is set, it first waits for
+// activity on the transfers, or a job to be done, at most
+// MD_HTTP_POLL_TIMEOUT.
+static int md_parse_jobs_take_done(MDParseJobs *jobs, int *ready, bool wait) {
+    if (wait)
+        curl_multi_poll(jobs->multi, NULL, 0, MD_HTTP_POLL_TIMEOUT, NULL);
+    th_mutex_lock(jobs->mutex);
+    int count = jobs->doneCount;
+    memcpy(ready, jobs->done, count * sizeof(int));
+    jobs->doneCount = 0;
+    th_mutex_unlock(jobs->mutex);
+    return count;
+}
+
+void http_multi_request(MDHttpPool *pool, MDHttpRequest *requests, int count, MDHttpCallback callback, void *data, MDError *error) {
+    ENSURE_EMPTY_ERROR(error);
+    if (!count)
+        return;
+    MDTransfer *transfers = md_malloc(count * sizeof(MDTransfer), error);
+    MDHost *hosts = md_malloc(count * sizeof(MDHost), error);
+    // Indices of parsed transfers, filled by the workers and taken to ready.
+    int *done = md_malloc(count * sizeof(int), error), *ready = md_malloc(count * sizeof(int), error);
+    MDParseJobs jobs = {.workers = md_http_pool_get_workers(pool), .mutex = th_mutex_new(), .done = done, .doneCount = 0};
+    if (!jobs.mutex)
+        *error = MD_ERR_ALLOC;
+    CURLM *multi = jobs.multi = !*error ? md_http_pool_take_multi(pool, error) : NULL;
+    if (*error) {
+        free(transfers);
+        free(hosts);
+        free(done);
+        free(ready);
+        if (jobs.mutex)
+            th_mutex_free(jobs.mutex);
+        return;
+    }
+
+    int hostCount = 0;
+    for (int i = 0; i < count; ++i) {
+        MDTransfer *transfer = &transfers[i];
+        memset(transfer, 0, sizeof(MDTransfer));
+        transfer->index = i;
+        transfer->priority = requests[i].priority;
+        transfer->decoder = requests[i].decoder;
+        transfer->state = MD_TRANSFER_QUEUED;
+        transfer->host = md_hosts_find(hosts, &hostCount, requests[i].url);
+    }
+    sort(transfers, count, sizeof(MDTransfer), md_transfer_compare);
+    for (int i = 0; i < count; ++i)
+        transfers[i].job = (MDParseJob){.jobs = &jobs, .parser = &transfers[i].parser, .index = i};
+
+    // Responses are parsed by the workers while they're received, and each
+    // request gets its own response, so the results don't depend on the order
+    // in which the workers finish them.
+    int limit = atomic_load(&hostLimit), active = 0, parsing = 0, finished = 0, firstQueued = 0;
+    while (!*error && finished < count) {
+        for (int i = firstQueued; i < count && active < CURL_MAX_PARALLEL && !*error; ++i) {
+            MDTransfer *transfer = &transfers[i];
+            if (transfer->state != MD_TRANSFER_QUEUED || transfer->host->active >= limit)
+                continue;
+            md_transfer_start(transfer, pool, multi, requests[transfer->index].url);
+            if (transfer->error)
+                md_transfer_receive(transfer, pool, multi, CURLE_FAILED_INIT);
+            else
+                ++active;
+            ++parsing;
         }
-    } else {
-        for (int i = 0; i < size; ++i) {
-            free(chunks[i].memory);
+        while (firstQueued < count && transfers[firstQueued].state != MD_TRANSFER_QUEUED)
+            ++firstQueued;
+
+        int running, received = 0;
+        curl_multi_perform(multi, &running);
+        CURLMsg *msg;
+        int msgsLeft;
+        while ((msg = curl_multi_info_read(multi, &msgsLeft))) {
+            if (msg->msg == CURLMSG_DONE) {
+                MDTransfer *transfer;
+                curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&transfer);
+                md_transfer_receive(transfer, pool, multi, msg->data.result);
+                --active;
+                ++received;
+            }
+        }
+        // Finished transfers are replaced right away, without waiting.
+        int readyCount = md_parse_jobs_take_done(&jobs, ready, !received && parsing);
+        for (int i = 0; i < readyCount && !*error; ++i) {
+            md_transfer_finish(&transfers[ready[i]], callback, data, error);
+            --parsing;
+            ++finished;
         }
-        free(result);
-        result = NULL;
     }
-    return result;
+
+    // The remaining transfers are cancelled after an error, once the workers
+    // are done with them.
+    for (int i = 0; i < count; ++i) {
+        if (transfers[i].state == MD_TRANSFER_ACTIVE)
+            md_transfer_receive(&transfers[i], pool, multi, CURLE_ABORTED_BY_CALLBACK);
+    }
+    for (;;) {
+        bool pending = false;
+        th_mutex_lock(jobs.mutex);
+        for (int i = 0; i < count; ++i)
+            pending = pending || (transfers[i].state == MD_TRANSFER_PARSING && !transfers[i].job.done);
+        th_mutex_unlock(jobs.mutex);
+        if (!pending)
+            break;
+        md_parse_jobs_take_done(&jobs, ready, true);
+    }
+    for (int i = 0; i < count; ++i) {
+        if (transfers[i].state == MD_TRANSFER_PARSING) {
+            md_transfer_cleanup(&transfers[i]);
+            md_cleanup_json(transfers[i].json);
+            if (transfers[i].decoder)
+                md_json_decoder_cleanup(transfers[i].decoder);
+        }
+    }
+    md_http_pool_give_multi(pool, multi);
+    th_mutex_free(jobs.mutex);
+    free(transfers);
+    free(hosts);
+    free(done);
+    free(ready);
 }
 
-char *http_post_file(cchar *url, cchar *filename, cchar *name, MDError *error) {
+char *http_post_file(MDHttpPool *pool, cchar *url, cchar *filename, cchar *name, MDError *error) {
     ENSURE_EMPTY_ERROR(error);
-    struct Memblock chunk;
-    chunk.size = 0;
+    struct Memblock chunk = {.size = 0, .error = error, .parser = NULL, .keep = true};
     chunk.memory = (char *)md_malloc(1, error);
-    CURL *handle = create_curl(url, &chunk, write_memblock_callback, error);
+    CURL *handle = create_curl(pool, url, &chunk, write_memblock_callback, error);
     if (!*error) {
         curl_mime *mime;
         curl_mimepart *part;
@@ -239,7 +587,7 @@ char *http_post_file(cchar *url, cchar *filename, cchar *name, MDError *error) {
             *error = MD_ERR_FILE_OPERATION;
             md_error_set_message(filename);
         }
-        curl_easy_cleanup(handle);
+        release_curl(pool, handle);
         curl_mime_free(mime);
     }
     if (*error) {
@@ -306,33 +654,53 @@ void sort(void *array, size_t count, size_t size, compFunc comp) {
     }
 }
 
-Json *md_parse_json(cchar *data, MDError *error) {
-    Json *json = md_malloc(sizeof(Json), error);
-    if (json) {
-        if (json_parse(json, data)) {
-            *error = MD_ERR_INVALID_JSON;
-            json = NULL;
-        }
+// MDJson is a json value along with the arena and text holding all of its
+// memory.
+typedef struct MDJson {
+    Json json;  // must be the first member.
+    Arena arena;
+    char *text;  // parsed in situ, if any.
+} MDJson;
+
+Json *md_new_json(MDError *error) {
+    MDJson *doc = md_malloc(sizeof(MDJson), error);
+    if (!doc)
+        return NULL;
+    doc->json.type = JSON_NULL;
+    arena_init(&doc->arena);
+    doc->text = NULL;
+    return &doc->json;
+}
+
+Arena *md_json_arena(Json *json) {
+    return &((MDJson *)json)->arena;
+}
+
+Json *md_parse_json(char *data, MDError *error) {
+    Json *json = md_new_json(error);
+    if (!json) {
+        free(data);
+        return NULL;
+    }
+    ((MDJson *)json)->text = data;
+    if (json_parse_in_situ(json, data, md_json_arena(json))) {
+        *error = MD_ERR_INVALID_JSON;
+        md_cleanup_json(json);
+        json = NULL;
     }
     return json;
 }
 
 void md_cleanup_json(Json *json) {
     if (json) {
-        json_cleanup(json);
+        arena_cleanup(md_json_arena(json));
+        free(((MDJson *)json)->text);
         free(json);
     }
 }
 
 Json *json_get_property_silent(Json *json, cchar *key) {
-    if (json->type != JSON_OBJECT)
-        return NULL;
-    for (int i = 0; i < json->object.len; ++i) {
-        if (strcmp(json->object.entries[i].key.str, key) == 0) {
-            return &json->object.entries[i].value;
-        }
-    }
-    return NULL;
+    return json_object_get(json, key);
 }
 
 Json *json_get_property(Json *json, cchar *key, JsonType type, MDError *error) {
@@ -353,7 +721,7 @@ Json *json_get_property(Json *json, cchar *key, JsonType type, MDError *error) {
 long json_get_integer(Json *json, cchar *key, MDError *error) {
     Json *value = json_get_property(json, key, JSON_NUMBER, error);
     if (value)
-        return value->number;
+        return json_integer(value);
     return 0;
 }
 
@@ -375,14 +743,14 @@ char *json_get_string(Json *json, cchar *key, MDError *error) {
         }
     }
     if (value)
-        return clone_str(value->string.str, error);
+        return clone_str(value->str, error);
     return NULL;
 }
 
 cchar *json_get_string_no_alloc(Json *json, cchar *key, MDError *error) {
     Json *value = json_get_property(json, key, JSON_STRING, error);
     if (value)
-        return value->string.str;
+        return value->str;
     return NULL;
 }
 
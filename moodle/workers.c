@@ -0,0 +1,194 @@
+/*
+ * Licensed as with https://github.com/moodle-tui/moot
+ *
+ * Part of moodle library (pool of worker threads). See internal.h
+ *
+ * Each worker has its own queue of tasks. Tasks submitted from outside are
+ * spread over the queues in turns, while tasks submitted by a worker go to
+ * its own queue. Workers take tasks from their own queue first, and steal
+ * from the queues of the others once it's empty, so that no worker idles
+ * while there's work left. Workers sleep on a condition variable while there
+ * are no tasks at all.
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "internal.h"
+#include "thread.h"
+
+#define MD_WORKERS_MAX 16
+#define MD_WORKER_QUEUE_MIN_CAPACITY 16
+// MD_WORKER_IDLE_TIMEOUT is the longest time in milliseconds an idle worker
+// sleeps before checking the queues again.
+#define MD_WORKER_IDLE_TIMEOUT 1000
+
+typedef struct MDTask {
+    MDTaskFunc func;
+    void *arg;
+} MDTask;
+
+// MDWorkerQueue is a ring buffer of tasks, guarded by its own mutex.
+typedef struct MDWorkerQueue {
+    void *mutex;
+    MDTask *tasks;
+    int head, count, capacity;
+} MDWorkerQueue;
+
+typedef struct MDWorker {
+    MDWorkers *workers;
+    void *thread;
+    MDWorkerQueue queue;
+} MDWorker;
+
+struct MDWorkers {
+    void *mutex, *cond;  // for sleeping while there are no tasks.
+    atomic_int pending;  // number of queued tasks.
+    atomic_uint next;    // queue to put the next task from outside to.
+    bool stop;           // guarded by the mutex.
+    int count;
+    MDWorker workers[MD_WORKERS_MAX];
+};
+
+// The worker running on the current thread, if any.
+static _Thread_local MDWorker *currentWorker = NULL;
+
+// md_worker_queue_push appends the task to the queue, returning false if
+// there's no memory for it.
+static bool md_worker_queue_push(MDWorkerQueue *queue, MDTask task) {
+    th_mutex_lock(queue->mutex);
+    bool ok = true;
+    if (queue->count == queue->capacity) {
+        int capacity = queue->capacity ? queue->capacity * 2 : MD_WORKER_QUEUE_MIN_CAPACITY;
+        MDTask *tasks = malloc(capacity * sizeof(MDTask));
+        if (tasks) {
+            for (int i = 0; i < queue->count; ++i)
+                tasks[i] = queue->tasks[(queue->head + i) % queue->capacity];
+            free(queue->tasks);
+            queue->tasks = tasks;
+            queue->head = 0;
+            queue->capacity = capacity;
+        } else {
+            ok = false;
+        }
+    }
+    if (ok)
+        queue->tasks[(queue->head + queue->count++) % queue->capacity] = task;
+    th_mutex_unlock(queue->mutex);
+    return ok;
+}
+
+// md_worker_queue_pop takes the oldest task of the queue, returning false if
+// it's empty.
+static bool md_worker_queue_pop(MDWorkerQueue *queue, MDTask *task) {
+    th_mutex_lock(queue->mutex);
+    bool ok = queue->count > 0;
+    if (ok) {
+        *task = queue->tasks[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        --queue->count;
+    }
+    th_mutex_unlock(queue->mutex);
+    return ok;
+}
+
+static void md_worker_run(void *arg) {
+    MDWorker *worker = arg;
+    MDWorkers *workers = worker->workers;
+    currentWorker = worker;
+    int index = worker - workers->workers;
+    for (;;) {
+        MDTask task;
+        bool found = false;
+        for (int i = 0; i < workers->count && !found; ++i)
+            found = md_worker_queue_pop(&workers->workers[(index + i) % workers->count].queue, &task);
+        if (found) {
+            atomic_fetch_sub(&workers->pending, 1);
+            task.func(task.arg);
+            continue;
+        }
+        th_mutex_lock(workers->mutex);
+        bool stop = workers->stop && !atomic_load(&workers->pending);
+        if (!stop && !atomic_load(&workers->pending))
+            th_cond_wait(workers->cond, workers->mutex, MD_WORKER_IDLE_TIMEOUT);
+        th_mutex_unlock(workers->mutex);
+        if (stop)
+            break;
+    }
+}
+
+MDWorkers *md_workers_new(int count, MDError *error) {
+    MDWorkers *workers = md_malloc(sizeof(MDWorkers), error);
+    if (!workers)
+        return NULL;
+    count = count < 1 ? 1 : count > MD_WORKERS_MAX ? MD_WORKERS_MAX : count;
+    workers->mutex = th_mutex_new();
+    workers->cond = th_cond_new();
+    atomic_init(&workers->pending, 0);
+    atomic_init(&workers->next, 0);
+    workers->stop = false;
+    workers->count = count;
+    bool ok = workers->mutex && workers->cond;
+    for (int i = 0; i < count; ++i) {
+        workers->workers[i] = (MDWorker){.workers = workers, .thread = NULL, .queue = {.mutex = th_mutex_new()}};
+        ok = ok && workers->workers[i].queue.mutex;
+    }
+    // Workers are only started once all the queues exist.
+    for (int i = 0; i < count && ok; ++i) {
+        workers->workers[i].thread = th_create(md_worker_run, &workers->workers[i]);
+        ok = workers->workers[i].thread != NULL;
+    }
+    if (!ok) {
+        *error = MD_ERR_ALLOC;
+        md_workers_cleanup(workers);
+        workers = NULL;
+    }
+    return workers;
+}
+
+void md_workers_submit(MDWorkers *workers, MDTaskFunc func, void *arg) {
+    bool queued = false;
+    if (workers) {
+        MDWorker *worker = currentWorker && currentWorker->workers == workers
+                               ? currentWorker
+                               : &workers->workers[atomic_fetch_add(&workers->next, 1) % workers->count];
+        // The task is counted before it's queued, so that the count doesn't
+        // drop below zero if a worker takes it right away.
+        atomic_fetch_add(&workers->pending, 1);
+        queued = md_worker_queue_push(&worker->queue, (MDTask){func, arg});
+        if (queued) {
+            th_mutex_lock(workers->mutex);
+            th_cond_signal(workers->cond);
+            th_mutex_unlock(workers->mutex);
+        } else {
+            atomic_fetch_sub(&workers->pending, 1);
+        }
+    }
+    if (!queued)
+        func(arg);
+}
+
+void md_workers_cleanup(MDWorkers *workers) {
+    if (!workers)
+        return;
+    if (workers->mutex && workers->cond) {
+        th_mutex_lock(workers->mutex);
+        workers->stop = true;
+        th_cond_signal(workers->cond);
+        th_mutex_unlock(workers->mutex);
+    }
+    // The workers finish all the queued tasks before stopping.
+    for (int i = 0; i < workers->count; ++i) {
+        MDWorker *worker = &workers->workers[i];
+        if (worker->thread)
+            th_join(worker->thread);
+        if (worker->queue.mutex)
+            th_mutex_free(worker->queue.mutex);
+        free(worker->queue.tasks);
+    }
+    if (workers->mutex)
+        th_mutex_free(workers->mutex);
+    if (workers->cond)
+        th_cond_free(workers->cond);
+    free(workers);
+}